@@ -0,0 +1,198 @@
+/* Benchmarks the loops of sample-based planning and inverse kinematics,
+ * which create and copy many small Configs.
+ *
+ * Usage: configbenchmark [options]
+ *   -robots n      number of robots in the RRT problem, with 3 dofs each
+ *                  (may be repeated, default 2, 3 and 4)
+ *   -links n       number of links of the IK arm (may be repeated, default
+ *                  6 and 12)
+ *   -iters n       RRT iterations per run (default 5000)
+ *   -solves n      IK problems solved per run (default 2000)
+ *   -trials n      runs of each benchmark (default 3)
+ *   -csv file      results, one row per run (default configbenchmark.csv)
+ *
+ * The RRT benchmark runs the RRT planner for a fixed number of iterations
+ * on n rigid robots moving between the sides of a square with a block in
+ * the middle.  The IK benchmark solves position goals for the end of an
+ * n-link 3D arm, each sampled by forward kinematics from a random
+ * configuration, starting from another random configuration.
+ *
+ * Vectors of up to VECTOR_INLINE_CAPACITY elements are stored without heap
+ * allocation, so to measure its effect, run this once with the library
+ * built with the default capacity and once with VECTOR_INLINE_CAPACITY=0.
+ * Trial i is seeded with i+1 (srand treats seeds 0 and 1 alike), so runs
+ * are reproducible.
+ */
+#include <planning/AnyMotionPlanner.h>
+#include <planning/MultiRobot2DCSpace.h>
+#include <robotics/RobotKinematics3D.h>
+#include <robotics/IKFunctions.h>
+#include <math/random.h>
+#include <Timer.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+struct ConfigRun
+{
+  string benchmark;
+  int dofs,trial;
+  int iterations,successes;
+  double time;
+};
+
+//n square robots that start lined up on the left of the unit square and
+//end on the right, around a block in the middle
+void MakeRRTProblem(int n,MultiRobot2DCSpace& space,Config& start,Config& goal)
+{
+  space.allowRotation = true;
+  space.robots.resize(n);
+  for(int i=0;i<n;i++)
+    space.robots[i].Add(AABB2D(Vector2(-0.03,-0.03),Vector2(0.03,0.03)));
+  space.obstacles.Add(AABB2D(Vector2(0.4,0.3),Vector2(0.6,0.7)));
+  start.resize(n*3);
+  goal.resize(n*3);
+  for(int i=0;i<n;i++) {
+    Real y = (i+1)/Real(n+1);
+    start(i*3)=0.1; start(i*3+1)=y; start(i*3+2)=0;
+    goal(i*3)=0.9; goal(i*3+1)=1.0-y; goal(i*3+2)=0;
+  }
+}
+
+void RunRRT(int numRobots,int trial,int iters,ConfigRun& run)
+{
+  Srand(trial+1);
+  MultiRobot2DCSpace space;
+  Config start,goal;
+  MakeRRTProblem(numRobots,space,start,goal);
+  MotionPlannerFactory factory;
+  factory.type = MotionPlannerFactory::RRT;
+  MotionPlannerInterface* planner = factory.Create(&space);
+  int s = planner->AddMilestone(start);
+  int g = planner->AddMilestone(goal);
+  planner->ConnectHint(s,g);
+  Timer timer;
+  for(int i=0;i<iters;i++)
+    planner->PlanMore();
+  run.time = timer.ElapsedTime();
+  run.benchmark = "rrt";
+  run.dofs = numRobots*3;
+  run.trial = trial;
+  run.iterations = planner->NumIterations();
+  run.successes = (planner->IsConnected(s,g) ? 1 : 0);
+  delete planner;
+}
+
+//An arm of n revolute joints with alternating z and y axes, with total
+//length 1
+void MakeArm(int n,RobotKinematics3D& robot)
+{
+  robot.Initialize(n);
+  Real len = 1.0/n;
+  for(int i=0;i<n;i++) {
+    robot.parents[i] = i-1;
+    robot.links[i].SetRotationJoint((i%2==0) ? Vector3(0,0,1) : Vector3(0,1,0));
+    robot.links[i].T0_Parent.setIdentity();
+    if(i > 0) robot.links[i].T0_Parent.t.set(len,0,0);
+    robot.links[i].mass = 1;
+    robot.links[i].com.set(len*0.5,0,0);
+    robot.links[i].inertia.setIdentity();
+  }
+}
+
+void RandomArmConfig(RobotKinematics3D& robot)
+{
+  for(int i=0;i<robot.q.n;i++)
+    robot.q(i) = Rand(-Pi,Pi);
+}
+
+void RunIK(int numLinks,int trial,int solves,ConfigRun& run)
+{
+  Srand(trial+1);
+  RobotKinematics3D robot;
+  MakeArm(numLinks,robot);
+  vector<IKGoal> problem(1);
+  problem[0].link = numLinks-1;
+  problem[0].localPosition.set(1.0/numLinks,0,0);
+  run.benchmark = "ik";
+  run.dofs = numLinks;
+  run.trial = trial;
+  run.iterations = 0;
+  run.successes = 0;
+  run.time = 0;
+  for(int k=0;k<solves;k++) {
+    RandomArmConfig(robot);
+    robot.UpdateFrames();
+    Vector3 target;
+    robot.GetWorldPosition(problem[0].localPosition,problem[0].link,target);
+    problem[0].SetFixedPosition(target);
+    RandomArmConfig(robot);
+    int iters = 100;
+    Timer timer;
+    if(SolveIK(robot,problem,1e-6,iters,0)) run.successes++;
+    run.time += timer.ElapsedTime();
+    run.iterations += iters;
+  }
+}
+
+int main(int argc,const char** argv)
+{
+  vector<int> numRobots,numLinks;
+  int iters = 5000;
+  int solves = 2000;
+  int numTrials = 3;
+  const char* csvFile = "configbenchmark.csv";
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-robots")) numRobots.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-links")) numLinks.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-iters")) iters = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-solves")) solves = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-trials")) numTrials = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else {
+      printf("Usage: %s [-robots n] [-links n] [-iters n] [-solves n] [-trials n] [-csv file]\n",argv[0]);
+      return 1;
+    }
+  }
+  if(numRobots.empty()) {
+    numRobots.push_back(2);
+    numRobots.push_back(3);
+    numRobots.push_back(4);
+  }
+  if(numLinks.empty()) {
+    numLinks.push_back(6);
+    numLinks.push_back(12);
+  }
+
+  ofstream csv(csvFile);
+  if(!csv) {
+    printf("Unable to open %s\n",csvFile);
+    return 1;
+  }
+  printf("Vector inline capacity %d\n",VECTOR_INLINE_CAPACITY);
+  csv<<"benchmark,inline_capacity,dofs,trial,iterations,successes,time"<<endl;
+  printf("%6s %6s %6s %10s %10s %10s\n","bench","dofs","trial","iterations","successes","time");
+  vector<ConfigRun> runs;
+  for(size_t i=0;i<numRobots.size();i++) {
+    for(int trial=0;trial<numTrials;trial++) {
+      ConfigRun run;
+      RunRRT(numRobots[i],trial,iters,run);
+      runs.push_back(run);
+    }
+  }
+  for(size_t i=0;i<numLinks.size();i++) {
+    for(int trial=0;trial<numTrials;trial++) {
+      ConfigRun run;
+      RunIK(numLinks[i],trial,solves,run);
+      runs.push_back(run);
+    }
+  }
+  for(size_t i=0;i<runs.size();i++) {
+    const ConfigRun& run = runs[i];
+    printf("%6s %6d %6d %10d %10d %9gs\n",run.benchmark.c_str(),run.dofs,run.trial,run.iterations,run.successes,run.time);
+    csv<<run.benchmark<<","<<VECTOR_INLINE_CAPACITY<<","<<run.dofs<<","<<run.trial<<","<<run.iterations<<","<<run.successes<<","<<run.time<<endl;
+  }
+  return 0;
+}
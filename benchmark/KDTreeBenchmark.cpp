@@ -0,0 +1,98 @@
+/* Benchmarks the batch k-nearest neighbor queries of KDTree.
+ *
+ * Usage: kdtreebenchmark [options]
+ *   -points n      number of points in the tree (default 100000)
+ *   -dim n         dimension of the points (default 3)
+ *   -queries n     number of queries (default 100000)
+ *   -k n           number of neighbors per query (default 8)
+ *   -threads n     threads of the batch query, 0 for all cores (default 0)
+ *   -csv file      results (default kdtreebenchmark.csv)
+ *
+ * Times KDTree::BatchKClosestPoints against a serial loop of
+ * KClosestPoints, on uniformly random points and queries, and checks that
+ * they agree.
+ */
+#include <geometry/KDTree.h>
+#include <math/random.h>
+#include <utils/ThreadPool.h>
+#include <Timer.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace Geometry;
+using namespace std;
+
+void RandomPoints(int n,int dim,vector<Vector>& pts)
+{
+  pts.resize(n);
+  for(int i=0;i<n;i++) {
+    pts[i].resize(dim);
+    for(int j=0;j<dim;j++) pts[i](j) = Rand();
+  }
+}
+
+int main(int argc,const char** argv)
+{
+  int numPoints = 100000;
+  int dim = 3;
+  int numQueries = 100000;
+  int k = 8;
+  int numThreads = 0;
+  const char* csvFile = "kdtreebenchmark.csv";
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-points")) numPoints = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-dim")) dim = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-queries")) numQueries = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-k")) k = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-threads")) numThreads = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else {
+      printf("Usage: %s [-points n] [-dim n] [-queries n] [-k n] [-threads n] [-csv file]\n",argv[0]);
+      return 1;
+    }
+  }
+
+  ofstream csv(csvFile);
+  if(!csv) {
+    printf("Unable to open %s\n",csvFile);
+    return 1;
+  }
+  Srand(1);
+  vector<Vector> pts,queries;
+  RandomPoints(numPoints,dim,pts);
+  RandomPoints(numQueries,dim,queries);
+  Timer timer;
+  KDTree* tree = KDTree::Build(pts,dim);
+  double tBuild = timer.ElapsedTime();
+  printf("Built %d points in %d dimensions in %gs, depth %d\n",numPoints,dim,tBuild,tree->MaxDepth());
+
+  vector<Real> dist(numQueries*k),batchDist(numQueries*k);
+  vector<int> idx(numQueries*k),batchIdx(numQueries*k);
+  timer.Reset();
+  for(int i=0;i<numQueries;i++)
+    tree->KClosestPoints(queries[i],k,&dist[i*k],&idx[i*k]);
+  double tSerial = timer.ElapsedTime();
+
+  ThreadPool pool(numThreads);
+  timer.Reset();
+  tree->BatchKClosestPoints(queries,k,&batchDist[0],&batchIdx[0],&pool);
+  double tBatch = timer.ElapsedTime();
+
+  //the serial results are unordered, so compare the farthest distances
+  int numErrors = 0;
+  for(int i=0;i<numQueries;i++) {
+    Real dmax = 0;
+    for(int j=0;j<k;j++) dmax = Max(dmax,dist[i*k+j]);
+    if(dmax != batchDist[i*k+k-1]) numErrors++;
+  }
+  printf("%d %d-nearest queries, serial %gs, batch (%d threads) %gs, speedup %g\n",numQueries,k,tSerial,pool.NumThreads(),tBatch,tSerial/tBatch);
+  csv<<"points,dim,queries,k,threads,build_time,serial_time,batch_time,errors"<<endl;
+  csv<<numPoints<<","<<dim<<","<<numQueries<<","<<k<<","<<pool.NumThreads()<<","<<tBuild<<","<<tSerial<<","<<tBatch<<","<<numErrors<<endl;
+  delete tree;
+  if(numErrors > 0) {
+    printf("Error: %d batch queries differ from serial ones\n",numErrors);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,185 @@
+/* Benchmarks the explanation sets of the minimum constraint removal (MCR)
+ * planners.
+ *
+ * Usage: mcrbenchmark [options]
+ *   -obstacles n   number of obstacles (may be repeated, default 32, 128
+ *                  and 512)
+ *   -iters n       planner iterations per run (default 2000)
+ *   -trials n      runs of the planner on each problem (default 3)
+ *   -csv file      results, one row per run (default mcrbenchmark.csv)
+ *
+ * First times the set operations used by the planners (union, subset
+ * test, comparison, and size) on Subset and BitSubset, for random sets
+ * with the density of explanations in the planning problems.  Then runs
+ * MCRPlanner on a unit square filled with n random disks, from one corner
+ * to the other.  The planner uses ExplanationSet, so to compare the two
+ * representations in the planner, run this once with the library built
+ * with MCR_BITSET_EXPLANATIONS=1 (the default) and once with 0.
+ *
+ * Trial i is seeded with i+1 (srand treats seeds 0 and 1 alike), so runs
+ * are reproducible.  The planner raises its explanation limit in 10
+ * evenly spaced steps.
+ */
+#include <planning/MCRPlanner.h>
+#include <planning/Geometric2DCSpace.h>
+#include <math/random.h>
+#include <Timer.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+//Fills space with n disks of random centers, with radii such that the
+//disks cover about half of the unit square
+void MakeProblem(int n,Geometric2DCSpace& space)
+{
+  space.Clear();
+  Real r = Sqrt(0.5/(Pi*n))*2;
+  for(int i=0;i<n;i++) {
+    Circle2D c;
+    c.center.set(Rand(),Rand());
+    c.radius = r*Rand(0.5,1.5);
+    space.Add(c);
+  }
+}
+
+void RandomSets(int n,Real density,int count,vector<vector<bool> >& sets)
+{
+  sets.resize(count);
+  for(int i=0;i<count;i++) {
+    sets[i].resize(n);
+    for(int j=0;j<n;j++)
+      sets[i][j] = (Rand() < density);
+  }
+}
+
+//Times the set operations made by the path cover updates on count sets,
+//and returns a checksum so the work isn't optimized away
+template <class Set>
+double TimeSetOperations(const vector<vector<bool> >& bits,int rounds,double& time)
+{
+  vector<Set> sets(bits.size());
+  for(size_t i=0;i<bits.size();i++)
+    sets[i] = Set(bits[i]);
+  Timer timer;
+  double checksum = 0;
+  for(int r=0;r<rounds;r++) {
+    for(size_t i=0;i+1<sets.size();i++) {
+      Set u = sets[i]+sets[i+1];
+      checksum += u.size();
+      if(sets[i].is_subset(u)) checksum += 1;
+      if(u.is_subset(sets[i])) checksum += 1;
+      if(sets[i] < sets[i+1]) checksum += 1;
+      if(u == sets[i]) checksum += 1;
+    }
+  }
+  time = timer.ElapsedTime();
+  return checksum;
+}
+
+struct MCRRun
+{
+  int numObstacles,trial;
+  int iterations,milestones,modes;
+  double time,timeUpdatePaths;
+  Real lowerCost,cover;
+};
+
+void Run(int numObstacles,int trial,int iters,MCRRun& run)
+{
+  Srand(trial+1);
+  Geometric2DCSpace space;
+  space.domain.bmin.set(0,0);
+  space.domain.bmax.set(1,1);
+  MakeProblem(numObstacles,space);
+  Config start(2),goal(2);
+  start(0)=start(1)=0.02;
+  goal(0)=goal(1)=0.98;
+
+  MCRPlanner planner(&space);
+  planner.Init(start,goal);
+  vector<int> schedule(10);
+  for(int i=0;i<10;i++)
+    schedule[i] = (i+1)*iters/10;
+  vector<int> path;
+  ExplanationSet cover;
+  Timer timer;
+  planner.Plan(0,schedule,path,cover);
+  run.time = timer.ElapsedTime();
+
+  vector<bool> violations;
+  space.CheckObstacles(start,violations);
+  ExplanationSet lowerCover(violations);
+  space.CheckObstacles(goal,violations);
+  lowerCover = lowerCover + ExplanationSet(violations);
+  run.numObstacles = numObstacles;
+  run.trial = trial;
+  run.iterations = planner.numExpands;
+  run.milestones = (int)planner.roadmap.nodes.size();
+  run.modes = (int)planner.modeGraph.nodes.size();
+  run.timeUpdatePaths = planner.timeUpdatePaths;
+  run.lowerCost = planner.Cost(lowerCover);
+  run.cover = planner.Cost(cover);
+}
+
+int main(int argc,const char** argv)
+{
+  vector<int> numObstacles;
+  int iters = 2000;
+  int numTrials = 3;
+  const char* csvFile = "mcrbenchmark.csv";
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-obstacles")) numObstacles.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-iters")) iters = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-trials")) numTrials = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else {
+      printf("Usage: %s [-obstacles n] [-iters n] [-trials n] [-csv file]\n",argv[0]);
+      return 1;
+    }
+  }
+  if(numObstacles.empty()) {
+    numObstacles.push_back(32);
+    numObstacles.push_back(128);
+    numObstacles.push_back(512);
+  }
+
+  printf("Set operations (union, subset tests, comparison, size):\n");
+  printf("%10s %10s %12s %12s %8s\n","obstacles","density","Subset","BitSubset","speedup");
+  for(size_t i=0;i<numObstacles.size();i++) {
+    const static Real densities[3] = {0.02,0.1,0.5};
+    for(int j=0;j<3;j++) {
+      Srand(0);
+      vector<vector<bool> > bits;
+      RandomSets(numObstacles[i],densities[j],1000,bits);
+      int rounds = Max(1,100000/numObstacles[i]);
+      double tvec,tbit;
+      double cvec = TimeSetOperations<Subset>(bits,rounds,tvec);
+      double cbit = TimeSetOperations<BitSubset>(bits,rounds,tbit);
+      if(cvec != cbit) {
+	printf("Error: Subset and BitSubset results differ\n");
+	return 1;
+      }
+      printf("%10d %10g %11gs %11gs %8.2f\n",numObstacles[i],densities[j],tvec,tbit,tvec/tbit);
+    }
+  }
+
+  printf("\nMCRPlanner with %s explanation sets, %d iterations:\n",(MCR_BITSET_EXPLANATIONS ? "BitSubset" : "Subset"),iters);
+  ofstream csv(csvFile);
+  if(!csv) {
+    printf("Unable to open %s\n",csvFile);
+    return 1;
+  }
+  csv<<"obstacles,trial,explanation_set,iterations,milestones,modes,time,update_paths_time,lower_cost,cover"<<endl;
+  printf("%10s %6s %10s %8s %10s %12s %6s %6s\n","obstacles","trial","milestones","modes","time","updatePaths","lower","cover");
+  for(size_t i=0;i<numObstacles.size();i++) {
+    for(int trial=0;trial<numTrials;trial++) {
+      MCRRun run;
+      Run(numObstacles[i],trial,iters,run);
+      printf("%10d %6d %10d %8d %9gs %11gs %6g %6g\n",run.numObstacles,run.trial,run.milestones,run.modes,run.time,run.timeUpdatePaths,run.lowerCost,run.cover);
+      csv<<run.numObstacles<<","<<run.trial<<","<<(MCR_BITSET_EXPLANATIONS ? "bitset" : "vector")<<","<<run.iterations<<","<<run.milestones<<","<<run.modes<<","<<run.time<<","<<run.timeUpdatePaths<<","<<run.lowerCost<<","<<run.cover<<endl;
+    }
+  }
+  return 0;
+}
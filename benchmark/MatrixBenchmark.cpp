@@ -0,0 +1,185 @@
+/* Benchmarks the blocked matrix products of math/fastarray.cpp against the
+ * plain loops of math/fastarray.h.
+ *
+ * Usage: matrixbenchmark [options]
+ *   -size n        size of the square matrices and vectors (may be
+ *                  repeated, default 16, 32, 64, 128, 256 and 512)
+ *   -dofs n        number of columns of the 6 x n Jacobians (may be
+ *                  repeated, default 12, 30 and 100)
+ *   -time t        minimum time of each measurement, in seconds (default
+ *                  0.2)
+ *   -csv file      results, one row per product (default
+ *                  matrixbenchmark.csv)
+ *
+ * Times the products made by Matrix::mul, mulTransposeA, mulTransposeB,
+ * mul(Vector) and mulTranspose(Vector) on random row-major matrices, and
+ * the products J^T J and J J^T of 6 x n Jacobians as in IK and Newton
+ * solvers.  Each product is timed with the plain loop (the templates
+ * called with an explicit type) and with the overloads for doubles that
+ * the Matrix methods call, which use the blocked kernels for all but small
+ * products.  The largest difference between the two results is reported
+ * as a check.
+ */
+#include <math/matrix.h>
+#include <math/fastarray.h>
+#include <math/random.h>
+#include <Timer.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace Math;
+using namespace std;
+
+enum ProductType { MatMul, MatMulTransposeA, MatMulTransposeB, MatVec, MatVecTranspose };
+
+const static char* kProductNames[5] = {"A*B","A^T*B","A*B^T","A*x","A^T*x"};
+
+void RandomMatrix(int m,int n,Matrix& A)
+{
+  A.resize(m,n);
+  for(int i=0;i<m;i++)
+    for(int j=0;j<n;j++)
+      A(i,j) = Rand(-1,1);
+}
+
+//X = op(A)*op(B) with the plain loops, or with the overloads for doubles
+//that Matrix::mul etc. call
+template <bool blocked>
+void Product(ProductType p,const Matrix& A,const Matrix& B,Matrix& X)
+{
+  switch(p) {
+  case MatMul:
+    if(blocked) gen_array2d_multiply(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,B.jstride,X.m,A.n,X.n);
+    else gen_array2d_multiply<double>(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,B.jstride,X.m,A.n,X.n);
+    break;
+  case MatMulTransposeA:
+    if(blocked) gen_array2d_multiply(X.getStart(),X.istride,X.jstride,A.getStart(),A.jstride,A.istride,B.getStart(),B.istride,B.jstride,X.m,A.m,X.n);
+    else gen_array2d_multiply<double>(X.getStart(),X.istride,X.jstride,A.getStart(),A.jstride,A.istride,B.getStart(),B.istride,B.jstride,X.m,A.m,X.n);
+    break;
+  case MatMulTransposeB:
+    if(blocked) gen_array2d_multiply(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.jstride,B.istride,X.m,A.n,X.n);
+    else gen_array2d_multiply<double>(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.jstride,B.istride,X.m,A.n,X.n);
+    break;
+  case MatVec:
+    if(blocked) gen_array2d_vector_multiply(X.getStart(),X.istride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,A.m,A.n);
+    else gen_array2d_vector_multiply<double>(X.getStart(),X.istride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,A.m,A.n);
+    break;
+  case MatVecTranspose:
+    if(blocked) gen_array2d_vector_multiply(X.getStart(),X.istride,A.getStart(),A.jstride,A.istride,B.getStart(),B.istride,A.n,A.m);
+    else gen_array2d_vector_multiply<double>(X.getStart(),X.istride,A.getStart(),A.jstride,A.istride,B.getStart(),B.istride,A.n,A.m);
+    break;
+  }
+}
+
+//Returns the time of one product, repeating it for at least minTime
+template <class F>
+double TimeProduct(F f,ProductType p,const Matrix& A,const Matrix& B,Matrix& X,double minTime)
+{
+  Timer timer;
+  int count = 0;
+  double t;
+  do {
+    f(p,A,B,X);
+    count++;
+    t = timer.ElapsedTime();
+  } while(t < minTime);
+  return t/count;
+}
+
+struct MatrixRun
+{
+  string name;
+  int m,n,p;
+  double flops;
+  double timeLoop,timeBlocked;
+  double error;
+};
+
+void Run(const char* name,ProductType p,int m,int n,int q,double minTime,MatrixRun& run)
+{
+  Matrix A,B;
+  int xm,xn;
+  switch(p) {
+  case MatMul: RandomMatrix(m,n,A); RandomMatrix(n,q,B); xm=m; xn=q; break;
+  case MatMulTransposeA: RandomMatrix(n,m,A); RandomMatrix(n,q,B); xm=m; xn=q; break;
+  case MatMulTransposeB: RandomMatrix(m,n,A); RandomMatrix(q,n,B); xm=m; xn=q; break;
+  case MatVec: RandomMatrix(m,n,A); RandomMatrix(n,1,B); xm=m; xn=1; break;
+  default: RandomMatrix(n,m,A); RandomMatrix(n,1,B); xm=m; xn=1; break;
+  }
+  Matrix Xloop(xm,xn),Xblocked(xm,xn);
+  run.name = name;
+  run.m = xm;
+  run.n = n;
+  run.p = xn;
+  run.flops = 2.0*xm*n*xn;
+  run.timeLoop = TimeProduct(Product<false>,p,A,B,Xloop,minTime);
+  run.timeBlocked = TimeProduct(Product<true>,p,A,B,Xblocked,minTime);
+  run.error = 0;
+  for(int i=0;i<xm;i++)
+    for(int j=0;j<xn;j++)
+      run.error = Max(run.error,Abs(Xloop(i,j)-Xblocked(i,j)));
+}
+
+int main(int argc,const char** argv)
+{
+  vector<int> sizes,dofs;
+  double minTime = 0.2;
+  const char* csvFile = "matrixbenchmark.csv";
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-size")) sizes.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-dofs")) dofs.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-time")) minTime = atof(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else {
+      printf("Usage: %s [-size n] [-dofs n] [-time t] [-csv file]\n",argv[0]);
+      return 1;
+    }
+  }
+  if(sizes.empty()) {
+    for(int n=16;n<=512;n*=2)
+      sizes.push_back(n);
+  }
+  if(dofs.empty()) {
+    dofs.push_back(12);
+    dofs.push_back(30);
+    dofs.push_back(100);
+  }
+
+  ofstream csv(csvFile);
+  if(!csv) {
+    printf("Unable to open %s\n",csvFile);
+    return 1;
+  }
+  Srand(1);
+  vector<MatrixRun> runs;
+  for(size_t i=0;i<sizes.size();i++) {
+    int n=sizes[i];
+    for(int p=0;p<5;p++) {
+      MatrixRun run;
+      if(p < MatVec) Run(kProductNames[p],(ProductType)p,n,n,n,minTime,run);
+      else Run(kProductNames[p],(ProductType)p,n,n,1,minTime,run);
+      runs.push_back(run);
+    }
+  }
+  for(size_t i=0;i<dofs.size();i++) {
+    MatrixRun run;
+    //J^T J and J J^T of a 6 x n Jacobian
+    Run("J^T*J",MatMulTransposeA,dofs[i],6,dofs[i],minTime,run);
+    runs.push_back(run);
+    Run("J*J^T",MatMulTransposeB,6,dofs[i],6,minTime,run);
+    runs.push_back(run);
+  }
+
+  printf("Blocked kernels: %s\n",blocked_array_kernel_name());
+  printf("%8s %6s %6s %6s %10s %10s %8s %10s\n","product","m","n","p","loop GF/s","blocked","speedup","error");
+  csv<<"product,kernels,m,n,p,loop_time,blocked_time,loop_gflops,blocked_gflops,error"<<endl;
+  for(size_t i=0;i<runs.size();i++) {
+    const MatrixRun& run = runs[i];
+    double gloop = run.flops/run.timeLoop*1e-9;
+    double gblocked = run.flops/run.timeBlocked*1e-9;
+    printf("%8s %6d %6d %6d %10.3f %10.3f %8.2f %10.2g\n",run.name.c_str(),run.m,run.n,run.p,gloop,gblocked,run.timeLoop/run.timeBlocked,run.error);
+    csv<<run.name<<","<<blocked_array_kernel_name()<<","<<run.m<<","<<run.n<<","<<run.p<<","<<run.timeLoop<<","<<run.timeBlocked<<","<<gloop<<","<<gblocked<<","<<run.error<<endl;
+  }
+  return 0;
+}
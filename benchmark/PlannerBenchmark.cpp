@@ -0,0 +1,440 @@
+/* Benchmarks the MotionPlannerFactory planners on a suite of reproducible
+ * problems built from the 2D configuration spaces in planning/.
+ *
+ * Usage: plannerbenchmark [options]
+ *   -time t        time limit of each run, in seconds (default 5)
+ *   -trials n      runs of each planner on each problem (default 10)
+ *   -problem name  only runs the given problem (may be repeated)
+ *   -planner name  only runs the given planner type (may be repeated)
+ *   -csv file      results, one row per run (default benchmark.csv)
+ *   -json file     results with the path cost over time (default
+ *                  benchmark.json)
+ *
+ * Trial i of every planner and problem is seeded with i, so runs are
+ * reproducible.  The feasible planners stop at the first solution, while
+ * the optimal ones (PRM*, Lazy-PRM*, RRT*) run for the whole time limit
+ * and record the path cost whenever it improves.  Feasibility tests, edge
+ * checks and distance computations are counted by wrapping each space.
+ * The planners' own counts and times of sampling, feasibility tests, edge
+ * checks, nearest neighbor queries and graph searches, and their memory
+ * estimate, are taken from MotionPlannerInterface::GetStats, and are -1
+ * if not reported (e.g., if built with PLANNER_STATS=0).
+ */
+#include <planning/AnyMotionPlanner.h>
+#include <planning/Geometric2DCSpace.h>
+#include <planning/RigidRobot2DCSpace.h>
+#include <planning/MultiRobot2DCSpace.h>
+#include <planning/Grid2DCSpace.h>
+#include <planning/PlannerStats.h>
+#include <math/random.h>
+#include <Timer.h>
+#include <errors.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+//Counts of the calls made to a space and its edge planners
+struct CallCounts
+{
+  CallCounts() { Reset(); }
+  void Reset() { numFeasible=numEdgeChecks=numDistance=0; }
+  int numFeasible,numEdgeChecks,numDistance;
+};
+
+//Counts the checks of an edge planner.  Incremental planning counts as a
+//single check, on the first call to Plan().
+class CountingEdgePlanner : public EdgePlanner
+{
+public:
+  CountingEdgePlanner(EdgePlanner* _e,CallCounts* _counts)
+    :e(_e),counts(_counts),started(false)
+  {}
+  virtual bool IsVisible() { counts->numEdgeChecks++; return e->IsVisible(); }
+  virtual void Eval(Real u,Config& x) const { e->Eval(u,x); }
+  virtual const Config& Start() const { return e->Start(); }
+  virtual const Config& Goal() const { return e->Goal(); }
+  virtual CSpace* Space() const { return e->Space(); }
+  virtual EdgePlanner* Copy() const { return new CountingEdgePlanner(e->Copy(),counts); }
+  virtual EdgePlanner* ReverseCopy() const { return new CountingEdgePlanner(e->ReverseCopy(),counts); }
+  virtual Real Priority() const { return e->Priority(); }
+  virtual bool Plan() {
+    if(!started) { counts->numEdgeChecks++; started=true; }
+    return e->Plan();
+  }
+  virtual bool Done() const { return e->Done(); }
+  virtual bool Failed() const { return e->Failed(); }
+
+  SmartPointer<EdgePlanner> e;
+  CallCounts* counts;
+  bool started;
+};
+
+//Counts the calls made to the space Base.  Base::Clone() returns NULL for
+//this subclass, so multithreaded planners run serially and all calls are
+//counted.
+template <class Base>
+class CountingCSpace : public Base
+{
+public:
+  CountingCSpace() {}
+  CountingCSpace(int m,int n) : Base(m,n) {}
+  using Base::IsFeasible;
+  using Base::LocalPlanner;
+  virtual bool IsFeasible(const Config& x) { counts.numFeasible++; return Base::IsFeasible(x); }
+  virtual EdgePlanner* LocalPlanner(const Config& a,const Config& b) { return new CountingEdgePlanner(Base::LocalPlanner(a,b),&counts); }
+  virtual Real Distance(const Config& x,const Config& y) { counts.numDistance++; return Base::Distance(x,y); }
+
+  CallCounts counts;
+};
+
+//Also counts the single-obstacle tests of an ExplicitCSpace
+template <class Base>
+class CountingExplicitCSpace : public CountingCSpace<Base>
+{
+public:
+  using CountingCSpace<Base>::IsFeasible;
+  virtual bool IsFeasible(const Config& x,int obstacle) { this->counts.numFeasible++; return Base::IsFeasible(x,obstacle); }
+};
+
+struct BenchmarkProblem
+{
+  string name;
+  SmartPointer<CSpace> space;
+  CallCounts* counts;
+  Config start,goal;
+};
+
+struct BenchmarkPlanner
+{
+  string name;
+  MotionPlannerFactory::Type type;
+  bool optimal;
+  bool implemented;
+};
+
+struct BenchmarkRun
+{
+  string problem,planner;
+  int trial;
+  bool success;
+  double timeToSolution,time;
+  int iterations,milestones;
+  CallCounts counts;
+  //from GetStats
+  int opCount[PlannerStats::NumOperations];
+  double opTime[PlannerStats::NumOperations];
+  double memory;
+  double cost;
+  //(time,cost) whenever the cost improved
+  vector<pair<double,double> > costs;
+};
+
+inline Config Config2(Real x,Real y)
+{
+  Config q(2);
+  q(0)=x; q(1)=y;
+  return q;
+}
+
+inline Config Config3(Real x,Real y,Real theta)
+{
+  Config q(3);
+  q(0)=x; q(1)=y; q(2)=theta;
+  return q;
+}
+
+void MakeProblems(vector<BenchmarkProblem>& problems)
+{
+  problems.resize(0);
+  BenchmarkProblem p;
+  {
+    //two staggered walls
+    CountingExplicitCSpace<Geometric2DCSpace>* s = new CountingExplicitCSpace<Geometric2DCSpace>;
+    s->Add(AABB2D(Vector2(0.3,0.0),Vector2(0.35,0.8)));
+    s->Add(AABB2D(Vector2(0.6,0.2),Vector2(0.65,1.0)));
+    p.name = "geometric2d_walls";
+    p.space = s;
+    p.counts = &s->counts;
+    p.start = Config2(0.1,0.1);
+    p.goal = Config2(0.9,0.9);
+    problems.push_back(p);
+  }
+  {
+    //a wall with a narrow gap, and a disk in front of it
+    CountingExplicitCSpace<Geometric2DCSpace>* s = new CountingExplicitCSpace<Geometric2DCSpace>;
+    s->Add(AABB2D(Vector2(0.45,0.0),Vector2(0.55,0.48)));
+    s->Add(AABB2D(Vector2(0.45,0.52),Vector2(0.55,1.0)));
+    Circle2D c;
+    c.center.set(0.3,0.5);
+    c.radius = 0.1;
+    s->Add(c);
+    p.name = "geometric2d_narrow";
+    p.space = s;
+    p.counts = &s->counts;
+    p.start = Config2(0.1,0.5);
+    p.goal = Config2(0.9,0.5);
+    problems.push_back(p);
+  }
+  {
+    //a bar that must turn to pass through a gap in a wall
+    CountingExplicitCSpace<RigidRobot2DCSpace>* s = new CountingExplicitCSpace<RigidRobot2DCSpace>;
+    s->robot.Add(AABB2D(Vector2(-0.1,-0.02),Vector2(0.1,0.02)));
+    s->obstacles.Add(AABB2D(Vector2(0.45,0.0),Vector2(0.55,0.44)));
+    s->obstacles.Add(AABB2D(Vector2(0.45,0.56),Vector2(0.55,1.0)));
+    p.name = "rigidrobot2d_gap";
+    p.space = s;
+    p.counts = &s->counts;
+    p.start = Config3(0.2,0.3,Pi*0.5);
+    p.goal = Config3(0.8,0.7,Pi*0.5);
+    problems.push_back(p);
+  }
+  {
+    //two disks that swap places around a block
+    CountingCSpace<MultiRobot2DCSpace>* s = new CountingCSpace<MultiRobot2DCSpace>;
+    Circle2D c;
+    c.center.setZero();
+    c.radius = 0.08;
+    s->allowRotation = false;
+    s->robots.resize(2);
+    s->robots[0].Add(c);
+    s->robots[1].Add(c);
+    s->obstacles.Add(AABB2D(Vector2(0.35,0.3),Vector2(0.65,0.7)));
+    p.name = "multirobot2d_swap";
+    p.space = s;
+    p.counts = &s->counts;
+    p.start.resize(4);
+    p.start(0)=0.15; p.start(1)=0.5;
+    p.start(2)=0.85; p.start(3)=0.5;
+    p.goal.resize(4);
+    p.goal(0)=0.85; p.goal(1)=0.5;
+    p.goal(2)=0.15; p.goal(3)=0.5;
+    problems.push_back(p);
+  }
+  {
+    //a 64x64 occupancy grid with three walls
+    CountingCSpace<Grid2DCSpace>* s = new CountingCSpace<Grid2DCSpace>(64,64);
+    s->Add(AABB2D(Vector2(0.25,0.0),Vector2(0.3,0.7)));
+    s->Add(AABB2D(Vector2(0.5,0.3),Vector2(0.55,1.0)));
+    s->Add(AABB2D(Vector2(0.75,0.0),Vector2(0.8,0.7)));
+    p.name = "grid2d_walls";
+    p.space = s;
+    p.counts = &s->counts;
+    p.start = Config2(0.1,0.1);
+    p.goal = Config2(0.9,0.9);
+    problems.push_back(p);
+  }
+}
+
+void MakePlanners(vector<BenchmarkPlanner>& planners)
+{
+  const static BenchmarkPlanner all[] = {
+    {"any",MotionPlannerFactory::Any,false,true},
+    {"prm",MotionPlannerFactory::PRM,false,true},
+    {"lazyprm",MotionPlannerFactory::LazyPRM,false,false},
+    {"perturbationtree",MotionPlannerFactory::PerturbationTree,false,false},
+    {"est",MotionPlannerFactory::EST,false,false},
+    {"rrt",MotionPlannerFactory::RRT,false,true},
+    {"sbl",MotionPlannerFactory::SBL,false,true},
+    {"sblprt",MotionPlannerFactory::SBLPRT,false,true},
+    {"prmstar",MotionPlannerFactory::PRMStar,true,true},
+    {"lazyprmstar",MotionPlannerFactory::LazyPRMStar,true,true},
+    {"rrtstar",MotionPlannerFactory::RRTStar,true,false}
+  };
+  planners.assign(all,all+sizeof(all)/sizeof(all[0]));
+}
+
+Real PathCost(const MilestonePath& path)
+{
+  if(path.edges.empty()) return Inf;
+  return path.Length();
+}
+
+void Run(BenchmarkProblem& problem,const BenchmarkPlanner& plannerType,int trial,double timeLimit,BenchmarkRun& run)
+{
+  run.problem = problem.name;
+  run.planner = plannerType.name;
+  run.trial = trial;
+  run.success = false;
+  run.timeToSolution = -1;
+  run.cost = Inf;
+  run.costs.resize(0);
+
+  Srand(trial);
+  problem.counts->Reset();
+  MotionPlannerFactory factory;
+  factory.type = plannerType.type;
+  MotionPlannerInterface* planner = factory.Create(problem.space);
+  int start = planner->AddMilestone(problem.start);
+  int goal = planner->AddMilestone(problem.goal);
+  //the multi-tree planners only grow trees between hinted milestones
+  planner->ConnectHint(start,goal);
+
+  //path extraction for recording the cost is not counted as planning
+  //time, and is done at most 100 times per run
+  Timer timer,overheadTimer;
+  double overhead = 0;
+  double costInterval = timeLimit*0.01, lastCostTime = -Inf;
+  MilestonePath path;
+  while(true) {
+    double t = timer.ElapsedTime()-overhead;
+    if(t >= timeLimit) break;
+    planner->PlanMore();
+    if(!planner->IsConnected(start,goal)) continue;
+    t = timer.ElapsedTime()-overhead;
+    if(run.timeToSolution < 0) run.timeToSolution = t;
+    if(run.timeToSolution == t || t - lastCostTime >= costInterval) {
+      overheadTimer.Reset();
+      planner->GetPath(start,goal,path);
+      Real cost = PathCost(path);
+      if(cost < run.cost) {
+	run.cost = cost;
+	run.costs.push_back(pair<double,double>(t,cost));
+      }
+      lastCostTime = t;
+      overhead += overheadTimer.ElapsedTime();
+    }
+    if(!plannerType.optimal) break;
+  }
+  run.time = timer.ElapsedTime()-overhead;
+  if(planner->IsConnected(start,goal)) {
+    planner->GetPath(start,goal,path);
+    Real cost = PathCost(path);
+    if(cost < run.cost) {
+      run.cost = cost;
+      run.costs.push_back(pair<double,double>(run.time,cost));
+    }
+  }
+  run.success = (run.timeToSolution >= 0);
+  run.iterations = planner->NumIterations();
+  run.milestones = planner->NumMilestones();
+  run.counts = *problem.counts;
+
+  StatDatabase stats;
+  planner->GetStats(stats);
+  for(int i=0;i<PlannerStats::NumOperations;i++) {
+    const char* name = PlannerStats::OperationName(i);
+    if(stats.GetData(name)) {
+      run.opCount[i] = stats.GetCount(name);
+      run.opTime[i] = stats.GetValue(stats.Concat(name,"time")).sum;
+    }
+    else {
+      run.opCount[i] = -1;
+      run.opTime[i] = -1;
+    }
+  }
+  run.memory = (stats.GetData("memory") ? stats.GetValue("memory").sum : -1);
+  delete planner;
+}
+
+void WriteCSVHeader(ostream& out)
+{
+  out<<"problem,planner,trial,success,time_to_solution,time,iterations,milestones,feasibility_tests,edge_checks,distances,";
+  for(int i=0;i<PlannerStats::NumOperations;i++)
+    out<<PlannerStats::OperationName(i)<<"_count,"<<PlannerStats::OperationName(i)<<"_time,";
+  out<<"memory,cost"<<endl;
+}
+
+void WriteCSV(ostream& out,const BenchmarkRun& run)
+{
+  out<<run.problem<<","<<run.planner<<","<<run.trial<<","<<(run.success?1:0)<<","<<run.timeToSolution<<","<<run.time<<","<<run.iterations<<","<<run.milestones<<","<<run.counts.numFeasible<<","<<run.counts.numEdgeChecks<<","<<run.counts.numDistance<<",";
+  for(int i=0;i<PlannerStats::NumOperations;i++)
+    out<<run.opCount[i]<<","<<run.opTime[i]<<",";
+  out<<run.memory<<",";
+  if(IsInf(run.cost)) out<<"inf";
+  else out<<run.cost;
+  out<<endl;
+}
+
+void WriteJSON(ostream& out,const BenchmarkRun& run)
+{
+  out<<"{\"problem\":\""<<run.problem<<"\",\"planner\":\""<<run.planner<<"\",\"trial\":"<<run.trial;
+  out<<",\"success\":"<<(run.success?"true":"false")<<",\"time_to_solution\":"<<run.timeToSolution<<",\"time\":"<<run.time;
+  out<<",\"iterations\":"<<run.iterations<<",\"milestones\":"<<run.milestones;
+  out<<",\"feasibility_tests\":"<<run.counts.numFeasible<<",\"edge_checks\":"<<run.counts.numEdgeChecks<<",\"distances\":"<<run.counts.numDistance;
+  out<<",\"planner_stats\":{";
+  for(int i=0;i<PlannerStats::NumOperations;i++) {
+    if(i > 0) out<<",";
+    out<<"\""<<PlannerStats::OperationName(i)<<"\":{\"count\":"<<run.opCount[i]<<",\"time\":"<<run.opTime[i]<<"}";
+  }
+  out<<"},\"memory\":"<<run.memory;
+  out<<",\"cost\":";
+  if(IsInf(run.cost)) out<<"null";
+  else out<<run.cost;
+  out<<",\"cost_over_time\":[";
+  for(size_t i=0;i<run.costs.size();i++) {
+    if(i > 0) out<<",";
+    out<<"["<<run.costs[i].first<<","<<run.costs[i].second<<"]";
+  }
+  out<<"]}";
+}
+
+bool Selected(const vector<string>& names,const string& name)
+{
+  if(names.empty()) return true;
+  for(size_t i=0;i<names.size();i++)
+    if(names[i] == name) return true;
+  return false;
+}
+
+int main(int argc,const char** argv)
+{
+  double timeLimit = 5;
+  int numTrials = 10;
+  const char* csvFile = "benchmark.csv";
+  const char* jsonFile = "benchmark.json";
+  vector<string> problemNames,plannerNames;
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-time")) timeLimit = atof(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-trials")) numTrials = atoi(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-problem")) problemNames.push_back(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-planner")) plannerNames.push_back(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else if(i+1 < argc && 0==strcmp(argv[i],"-json")) jsonFile = argv[++i];
+    else {
+      printf("Usage: %s [-time t] [-trials n] [-problem name] [-planner name] [-csv file] [-json file]\n",argv[0]);
+      return 1;
+    }
+  }
+
+  vector<BenchmarkProblem> problems;
+  vector<BenchmarkPlanner> planners;
+  MakeProblems(problems);
+  MakePlanners(planners);
+  ofstream csv(csvFile),json(jsonFile);
+  if(!csv || !json) {
+    fprintf(stderr,"Couldn't open %s or %s for writing\n",csvFile,jsonFile);
+    return 1;
+  }
+  WriteCSVHeader(csv);
+  json<<"["<<endl;
+  bool first = true;
+  BenchmarkRun run;
+  for(size_t i=0;i<problems.size();i++) {
+    if(!Selected(problemNames,problems[i].name)) continue;
+    for(size_t j=0;j<planners.size();j++) {
+      if(!Selected(plannerNames,planners[j].name)) continue;
+      if(!planners[j].implemented) {
+	printf("%s: planner %s is not implemented, skipping\n",problems[i].name.c_str(),planners[j].name.c_str());
+	continue;
+      }
+      int numSuccesses = 0;
+      double totalTime = 0;
+      for(int trial=0;trial<numTrials;trial++) {
+	Run(problems[i],planners[j],trial,timeLimit,run);
+	WriteCSV(csv,run);
+	if(!first) json<<","<<endl;
+	WriteJSON(json,run);
+	first = false;
+	if(run.success) {
+	  numSuccesses++;
+	  totalTime += run.timeToSolution;
+	}
+      }
+      printf("%s %s: success %d/%d, mean time to solution %g\n",problems[i].name.c_str(),planners[j].name.c_str(),numSuccesses,numTrials,(numSuccesses>0 ? totalTime/numSuccesses : -1.0));
+    }
+  }
+  json<<endl<<"]"<<endl;
+  return 0;
+}
@@ -0,0 +1,113 @@
+/* Benchmarks the vector expressions of math/VectorExpression.h.
+ *
+ * Usage: vectorbenchmark [options]
+ *   -size n        size of the vectors (may be repeated, default 3, 6, 12,
+ *                  30, 100, 1000 and 10000)
+ *   -time t        minimum time of each measurement, in seconds (default
+ *                  0.2)
+ *   -csv file      results, one row per size (default vectorbenchmark.csv)
+ *
+ * Times x = a + b*s - c computed three ways: with a new vector for each
+ * operator, as the operators returned before expressions were added; with
+ * the in-place methods mul, inc and dec, which make three passes over x;
+ * and with the expression, which makes one pass and no temporaries.  The
+ * largest difference between the results is reported as a check.
+ */
+#include <math/vector.h>
+#include <math/random.h>
+#include <Timer.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+using namespace Math;
+using namespace std;
+
+enum EvalType { Temporaries, Methods, Expression };
+
+//the operators as they were before expressions, returning new vectors
+Vector Add(const Vector& a,const Vector& b) { Vector x(a.n); x.add(a,b); return x; }
+Vector Sub(const Vector& a,const Vector& b) { Vector x(a.n); x.sub(a,b); return x; }
+Vector Mul(const Vector& a,Real c) { Vector x(a.n); x.mul(a,c); return x; }
+
+template <EvalType type>
+void Eval(const Vector& a,const Vector& b,Real s,const Vector& c,Vector& x)
+{
+  switch(type) {
+  case Temporaries: x = Sub(Add(a,Mul(b,s)),c); break;
+  case Methods: x.mul(b,s); x.inc(a); x.dec(c); break;
+  case Expression: x = a + b*s - c; break;
+  }
+}
+
+//Returns the time of one evaluation, repeating it for at least minTime
+template <EvalType type>
+double TimeEval(const Vector& a,const Vector& b,Real s,const Vector& c,Vector& x,double minTime)
+{
+  Timer timer;
+  int count = 0;
+  double t;
+  do {
+    for(int k=0;k<100;k++)
+      Eval<type>(a,b,s,c,x);
+    count += 100;
+    t = timer.ElapsedTime();
+  } while(t < minTime);
+  return t/count;
+}
+
+void RandomVector(int n,Vector& x)
+{
+  x.resize(n);
+  for(int i=0;i<n;i++)
+    x(i) = Rand(-1,1);
+}
+
+int main(int argc,const char** argv)
+{
+  vector<int> sizes;
+  double minTime = 0.2;
+  const char* csvFile = "vectorbenchmark.csv";
+  for(int i=1;i<argc;i++) {
+    if(i+1 < argc && 0==strcmp(argv[i],"-size")) sizes.push_back(atoi(argv[++i]));
+    else if(i+1 < argc && 0==strcmp(argv[i],"-time")) minTime = atof(argv[++i]);
+    else if(i+1 < argc && 0==strcmp(argv[i],"-csv")) csvFile = argv[++i];
+    else {
+      printf("Usage: %s [-size n] [-time t] [-csv file]\n",argv[0]);
+      return 1;
+    }
+  }
+  if(sizes.empty()) {
+    const static int defaultSizes[7] = {3,6,12,30,100,1000,10000};
+    sizes.assign(defaultSizes,defaultSizes+7);
+  }
+
+  ofstream csv(csvFile);
+  if(!csv) {
+    printf("Unable to open %s\n",csvFile);
+    return 1;
+  }
+  Srand(1);
+  printf("x = a + b*s - c, time per evaluation\n");
+  printf("%8s %12s %12s %12s %8s %10s\n","n","temporaries","methods","expression","speedup","error");
+  csv<<"n,inline_capacity,temporaries_time,methods_time,expression_time,error"<<endl;
+  for(size_t i=0;i<sizes.size();i++) {
+    int n = sizes[i];
+    Vector a,b,c;
+    RandomVector(n,a);
+    RandomVector(n,b);
+    RandomVector(n,c);
+    Real s = Rand(-1,1);
+    Vector xt,xm,xe;
+    xm.resize(n);
+    double tt = TimeEval<Temporaries>(a,b,s,c,xt,minTime);
+    double tm = TimeEval<Methods>(a,b,s,c,xm,minTime);
+    double te = TimeEval<Expression>(a,b,s,c,xe,minTime);
+    Real error = 0;
+    for(int j=0;j<n;j++)
+      error = Max(error,Max(Abs(xt(j)-xe(j)),Abs(xm(j)-xe(j))));
+    printf("%8d %11gs %11gs %11gs %8.2f %10.2g\n",n,tt,tm,te,tt/te,error);
+    csv<<n<<","<<VECTOR_INLINE_CAPACITY<<","<<tt<<","<<tm<<","<<te<<","<<error<<endl;
+  }
+  return 0;
+}
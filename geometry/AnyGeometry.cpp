@@ -1,4 +1,5 @@
 #include "AnyGeometry.h"
+#include "CollisionImplicitSurface.h"
 #include <utils/stringutils.h>
 #include <meshing/IO.h>
 #include <fstream>
@@ -482,11 +483,8 @@ Real AnyCollisionGeometry3D::Distance(const Vector3& pt) const
     }
   case PointCloud:
     {
-      const CollisionPointCloud& pc = PointCloudCollisionData();
-      Real dmin = Inf;
-      for(size_t i=0;i<pc.points.size();i++)
-	dmin = Min(dmin,ptlocal.distanceSquared(pc.points[i]));
-      return Min(Sqrt(dmin)-margin,0.0);
+      Real dmin = ::Distance(PointCloudCollisionData(),GeometricPrimitive3D(pt));
+      return Min(dmin-margin,0.0);
     }
   }
   return Inf;
@@ -497,29 +495,12 @@ Real AnyCollisionGeometry3D::Distance(const Vector3& pt) const
 bool Collides(const Meshing::VolumeGrid& grid,const GeometricPrimitive3D& a,Real margin,
 	      vector<int>& gridelements,size_t maxContacts)
 {
-  if(a.type != GeometricPrimitive3D::Point && a.type != GeometricPrimitive3D::Sphere) {
-    FatalError("Can't collide an implicit surface and a primitive yet\n");
-  }
-  if(a.type == GeometricPrimitive3D::Point) {
-    const Vector3& pt = *AnyCast<Vector3>(&a.data);
-    bool res = (grid.TrilinearInterpolate(pt) <= margin);
-    if(res) {
-      gridelements.resize(1);
-      IntTriple cell;
-      grid.GetIndex(pt,cell);
-      gridelements[0] = cell.a*grid.value.n*grid.value.p + cell.b*grid.value.p + cell.c;
-    }
-    return res;
-  }
-  const Sphere3D* s=AnyCast<Sphere3D>(&a.data);
-  bool res = (grid.TrilinearInterpolate(s->center) <= margin+s->radius);  
-  if(res) {
-    gridelements.resize(1);
-    IntTriple cell;
-    grid.GetIndex(s->center,cell);
-    gridelements[0] = cell.a*grid.value.n*grid.value.p + cell.b*grid.value.p + cell.c;
+  int cell;
+  if(WithinDistance(grid,a,margin,cell)) {
+    gridelements.push_back(cell);
+    return true;
   }
-  return res;
+  return false;
 }
 
 bool Collides(const GeometricPrimitive3D& a,const GeometricPrimitive3D& b,Real margin)
@@ -553,31 +534,22 @@ bool Collides(const GeometricPrimitive3D& a,const CollisionPointCloud& b,Real ma
 bool Collides(const Meshing::VolumeGrid& a,const RigidTransform& Ta,const Meshing::VolumeGrid& b,const RigidTransform& Tb,Real margin,
 	      vector<int>& elements1,vector<int>& elements2,size_t maxContacts)
 {
-  FatalError("Volume grid to volume grid collisions not done\n");
-  return false;
+  NearbyCells(a,Ta,b,Tb,margin,elements1,elements2,maxContacts);
+  return !elements1.empty();
 }
 
 bool Collides(const Meshing::VolumeGrid& a,const RigidTransform& Ta,const CollisionMesh& b,Real margin,
 	      vector<int>& elements1,vector<int>& elements2,size_t maxContacts)
 {
-  FatalError("Volume grid to triangle mesh collisions not done\n");
-  return false;
+  NearbyCells(a,Ta,b,margin,elements1,elements2,maxContacts);
+  return !elements1.empty();
 }
 
 bool Collides(const Meshing::VolumeGrid& a,const RigidTransform& Ta,const CollisionPointCloud& b,Real margin,
 	      vector<int>& elements1,vector<int>& elements2,size_t maxContacts)
 {
-  RigidTransform btoa; btoa.mulInverseA(Ta,b.currentTransform);
-  for(size_t i=0;i<b.points.size();i++) {
-    if(a.TrilinearInterpolate(btoa*b.points[i]) <= margin) {
-      IntTriple cell;
-      a.GetIndex(b.points[i],cell);
-      elements1.push_back(cell.a*a.value.n*a.value.p + cell.b*a.value.p + cell.c);
-      elements2.push_back(i);
-      if(elements1.size() >= maxContacts) return true;
-    }
-  }
-  return false;
+  NearbyCells(a,Ta,b,margin,elements1,elements2,maxContacts);
+  return !elements1.empty();
 }
 
 bool Collides(const CollisionMesh& a,const CollisionMesh& b,Real margin,
@@ -590,31 +562,15 @@ bool Collides(const CollisionMesh& a,const CollisionMesh& b,Real margin,
 bool Collides(const CollisionMesh& a,const CollisionPointCloud& b,Real margin,
 	      vector<int>& elements1,vector<int>& elements2,size_t maxContacts)
 {
-  Box3D abb,bbb;
-  GetBB(a,abb);
-  GetBB(b,bbb);
-  if(!abb.intersects(bbb)) return false;
-  for(size_t i=0;i<b.points.size();i++) {
-    vector<int> nearTris;
-    NearbyTriangles(a,b.currentTransform*b.points[i],margin,nearTris,maxContacts-elements1.size());
-    for(size_t k=0;k<nearTris.size();k++) {
-      elements1.push_back(nearTris[k]);
-      elements2.push_back(i);
-    }
-    if(elements1.size()>=maxContacts) return true;
-  }
-  return false;
+  NearbyTriangles(a,b,margin,elements1,elements2,(int)Min(maxContacts,(size_t)INT_MAX));
+  return !elements1.empty();
 }
 
 bool Collides(const CollisionPointCloud& a,const CollisionPointCloud& b,Real margin,
 	      vector<int>& elements1,vector<int>& elements2,size_t maxContacts)
 {
-  Box3D abb,bbb;
-  GetBB(a,abb);
-  GetBB(b,bbb);
-  if(!abb.intersects(bbb)) return false;
-  FatalError("Can't yet do point cloud-point cloud collision detection");
-  return false;
+  NearbyPoints(a,b,margin,elements1,elements2,maxContacts);
+  return !elements1.empty();
 }
 
 bool Collides(const GeometricPrimitive3D& a,const RigidTransform& Ta,Real margin,const AnyCollisionGeometry3D& b,
@@ -771,6 +727,10 @@ Real AnyCollisionGeometry3D::Distance(const AnyCollisionGeometry3D& geom) const
 
 Real AnyCollisionGeometry3D::Distance(const AnyCollisionGeometry3D& geom,int& elem1,int& elem2) const
 {
+  if(type == PointCloud && geom.type == PointCloud) {
+    Real d = ::Distance(PointCloudCollisionData(),geom.PointCloudCollisionData(),elem1,elem2);
+    return d - margin - geom.margin;
+  }
   FatalError("Distance not implemented yet\n");
   return Inf;
 }
@@ -840,26 +800,9 @@ bool AnyCollisionGeometry3D::RayCast(const Ray3D& r,Real* distance,int* element)
     }
   case PointCloud:
     {
-      const CollisionPointCloud& pc = PointCloudCollisionData();
-      Ray3D rlocal;
-      pc.currentTransform.mulInverse(r.source,rlocal.source);
-      pc.currentTransform.R.mulTranspose(r.direction,rlocal.direction);
-      Real closest = Inf;
-      int closestpt = -1;
-      Sphere3D s;
-      s.radius = margin;
-      Vector3 pr;
-      for(size_t i=0;i<pc.points.size();i++) {
-	s.center = pc.points[i];
-	Real tmin,tmax;
-	if(s.intersects(r,&tmin,&tmax)) {
-	  if(tmax >= 0 && tmin < closest) {
-	    closest = Max(tmin,0.0);
-	    closestpt = i;
-	  }
-	}
-      }
-      if(distance) *distance = closest;
+      Vector3 worldpt;
+      int closestpt = ::RayCast(PointCloudCollisionData(),margin,r,worldpt);
+      if(distance) *distance = (closestpt >= 0 ? worldpt.distance(r.source) : Inf);
       if(element) *element = closestpt;
       return closestpt >= 0;
     }
@@ -0,0 +1,349 @@
+#include "CollisionImplicitSurface.h"
+#include "CollisionMesh.h"
+#include "CollisionPointCloud.h"
+#include <errors.h>
+
+#if HAVE_PQP
+#include <PQP.h>
+#endif //HAVE_PQP
+
+using namespace Meshing;
+using namespace std;
+
+namespace Geometry {
+
+Real Distance(const VolumeGrid& grid,const Vector3& pt)
+{
+  //the distance field's value at the closest point in the grid bounds the
+  //distance here from below, and so does the distance to the grid itself
+  Real d = grid.bb.distance(pt);
+  if(d == 0) return grid.TrilinearInterpolate(pt);
+  return Max(grid.TrilinearInterpolate(pt)-d,d);
+}
+
+int GetCellIndex(const VolumeGrid& grid,const Vector3& pt)
+{
+  IntTriple cell;
+  grid.GetIndex(pt,cell);
+  if(cell.a < 0) cell.a = 0;
+  if(cell.a >= grid.value.m) cell.a = grid.value.m-1;
+  if(cell.b < 0) cell.b = 0;
+  if(cell.b >= grid.value.n) cell.b = grid.value.n-1;
+  if(cell.c < 0) cell.c = 0;
+  if(cell.c >= grid.value.p) cell.c = grid.value.p-1;
+  return cell.a*grid.value.n*grid.value.p + cell.b*grid.value.p + cell.c;
+}
+
+/* Samples pieces of geometry against the distance field, refining each one
+ * only where its bounding sphere reaches into the band of width tol
+ * around the surface.  Pieces are refined until they are about as small as
+ * a grid cell, at which point their corners are sampled too.
+ * Everything is given in the grid's local frame.
+ */
+struct GridSampler
+{
+  GridSampler(const VolumeGrid& _grid,Real _tol)
+    :grid(_grid),tol(_tol),cell(-1)
+  {
+    Vector3 h = grid.GetCellSize();
+    rmin = Half*Min(h.x,h.y,h.z);
+  }
+
+  //returns 1 if the sphere (c,r) hits the band at its center, 0 if it
+  //misses the band entirely, and -1 if it needs to be refined
+  int Test(const Vector3& c,Real r) {
+    Real d = Distance(grid,c);
+    if(d <= tol) {
+      cell = GetCellIndex(grid,c);
+      return 1;
+    }
+    if(d - r > tol) return 0;
+    return -1;
+  }
+
+  bool Point(const Vector3& p) {
+    return Test(p,0) == 1;
+  }
+
+  bool Segment(const Vector3& a,const Vector3& b) {
+    Vector3 c = (a+b)*Half;
+    Real r = Half*a.distance(b);
+    int res = Test(c,r);
+    if(res >= 0) return (res == 1);
+    if(r <= rmin) return Point(a) || Point(b);
+    return Segment(a,c) || Segment(c,b);
+  }
+
+  bool Triangle(const Vector3& a,const Vector3& b,const Vector3& c) {
+    Vector3 m = (a+b+c)*(1.0/3.0);
+    Real r = Sqrt(Max(m.distanceSquared(a),m.distanceSquared(b),m.distanceSquared(c)));
+    int res = Test(m,r);
+    if(res >= 0) return (res == 1);
+    if(r <= rmin) return Point(a) || Point(b) || Point(c);
+    Vector3 ab = (a+b)*Half, bc = (b+c)*Half, ca = (c+a)*Half;
+    return Triangle(a,ab,ca) || Triangle(ab,b,bc) || Triangle(ca,bc,c) || Triangle(ab,bc,ca);
+  }
+
+  //a box with center c and half-extent vectors x,y,z along its axes
+  bool Box(const Vector3& c,const Vector3& x,const Vector3& y,const Vector3& z) {
+    Real r = Sqrt(x.normSquared()+y.normSquared()+z.normSquared());
+    int res = Test(c,r);
+    if(res >= 0) return (res == 1);
+    if(r <= rmin) {
+      for(int i=0;i<8;i++)
+	if(Point(c + (i&1 ? x : -x) + (i&2 ? y : -y) + (i&4 ? z : -z))) return true;
+      return false;
+    }
+    Vector3 hx = x*Half, hy = y*Half, hz = z*Half;
+    for(int i=0;i<8;i++)
+      if(Box(c + (i&1 ? hx : -hx) + (i&2 ? hy : -hy) + (i&4 ? hz : -hz),hx,hy,hz)) return true;
+    return false;
+  }
+
+  const VolumeGrid& grid;
+  Real tol;
+  //pieces with bounding radius below rmin are not refined further
+  Real rmin;
+  //the cell of the last contact
+  int cell;
+};
+
+bool WithinDistance(const VolumeGrid& grid,const GeometricPrimitive3D& g,Real tol,int& cell)
+{
+  GridSampler sampler(grid,tol);
+  bool res = false;
+  switch(g.type) {
+  case GeometricPrimitive3D::Empty:
+    return false;
+  case GeometricPrimitive3D::Point:
+    res = sampler.Point(*AnyCast<Vector3>(&g.data));
+    break;
+  case GeometricPrimitive3D::Sphere:
+    {
+      const Sphere3D* s = AnyCast<Sphere3D>(&g.data);
+      res = (Distance(grid,s->center) <= tol+s->radius);
+      if(res) sampler.cell = GetCellIndex(grid,s->center);
+    }
+    break;
+  case GeometricPrimitive3D::Segment:
+    {
+      const Segment3D* s = AnyCast<Segment3D>(&g.data);
+      res = sampler.Segment(s->a,s->b);
+    }
+    break;
+  case GeometricPrimitive3D::Triangle:
+    {
+      const Triangle3D* t = AnyCast<Triangle3D>(&g.data);
+      res = sampler.Triangle(t->a,t->b,t->c);
+    }
+    break;
+  case GeometricPrimitive3D::AABB:
+    {
+      const AABB3D* bb = AnyCast<AABB3D>(&g.data);
+      Vector3 h = (bb->bmax-bb->bmin)*Half;
+      res = sampler.Box((bb->bmin+bb->bmax)*Half,Vector3(h.x,0,0),Vector3(0,h.y,0),Vector3(0,0,h.z));
+    }
+    break;
+  case GeometricPrimitive3D::Box:
+    {
+      const Box3D* b = AnyCast<Box3D>(&g.data);
+      Vector3 x = b->xbasis*(b->dims.x*Half), y = b->ybasis*(b->dims.y*Half), z = b->zbasis*(b->dims.z*Half);
+      res = sampler.Box(b->origin+x+y+z,x,y,z);
+    }
+    break;
+  default:
+    FatalError("Can't collide an implicit surface and a %s yet\n",g.TypeName());
+  }
+  if(res) cell = sampler.cell;
+  return res;
+}
+
+#if HAVE_PQP
+
+/* Walks the mesh's PQP bounding volume hierarchy, culling the subtrees
+ * whose bounding spheres stay outside the band, and samples the triangles
+ * of the leaves that reach into it.
+ */
+struct MeshGridCollider
+{
+  MeshGridCollider(const VolumeGrid& grid,const RigidTransform& T,const CollisionMesh& _m,Real tol,vector<int>& _cells,vector<int>& _tris,size_t _maxContacts)
+    :sampler(grid,tol),m(_m),cells(_cells),tris(_tris),maxContacts(_maxContacts)
+  {
+    Tmg.mulInverseA(T,m.currentTransform);
+  }
+
+  //returns false if the search should stop
+  bool Recurse(int b) {
+    const BV& bv = m.pqpModel->b[b];
+    Vector3 c(bv.To[0],bv.To[1],bv.To[2]);
+    Real r = Sqrt(Sqr(bv.d[0])+Sqr(bv.d[1])+Sqr(bv.d[2]));
+    if(sampler.Test(Tmg*c,r) == 0) return true;
+    if(bv.Leaf()) {
+      const Tri& t = m.pqpModel->tris[-bv.first_child-1];
+      Vector3 p1(t.p1[0],t.p1[1],t.p1[2]),p2(t.p2[0],t.p2[1],t.p2[2]),p3(t.p3[0],t.p3[1],t.p3[2]);
+      if(sampler.Triangle(Tmg*p1,Tmg*p2,Tmg*p3)) {
+	cells.push_back(sampler.cell);
+	tris.push_back(t.id);
+	if(tris.size() >= maxContacts) return false;
+      }
+      return true;
+    }
+    if(!Recurse(bv.first_child)) return false;
+    return Recurse(bv.first_child+1);
+  }
+
+  GridSampler sampler;
+  const CollisionMesh& m;
+  vector<int>& cells;
+  vector<int>& tris;
+  size_t maxContacts;
+  //transform from the mesh's frame to the grid's frame
+  RigidTransform Tmg;
+};
+
+void NearbyCells(const VolumeGrid& grid,const RigidTransform& T,const CollisionMesh& m,Real tol,vector<int>& cells,vector<int>& tris,size_t maxContacts)
+{
+  if(m.pqpModel->num_bvs == 0) return;
+  MeshGridCollider collider(grid,T,m,tol,cells,tris,maxContacts);
+  collider.Recurse(0);
+}
+
+#else
+
+void NearbyCells(const VolumeGrid& grid,const RigidTransform& T,const CollisionMesh& m,Real tol,vector<int>& cells,vector<int>& tris,size_t maxContacts)
+{
+  FatalError("Implicit surface to triangle mesh collisions require PQP\n");
+}
+
+#endif //HAVE_PQP
+
+/* Walks the point cloud's cell hierarchy, culling the cells whose bounding
+ * spheres stay outside the band.
+ */
+struct PointCloudGridCollider
+{
+  PointCloudGridCollider(const VolumeGrid& grid,const RigidTransform& T,const CollisionPointCloud& _pc,Real tol,vector<int>& _cells,vector<int>& _points,size_t _maxContacts)
+    :sampler(grid,tol),pc(_pc),cells(_cells),points(_points),maxContacts(_maxContacts)
+  {
+    Tpg.mulInverseA(T,pc.currentTransform);
+  }
+
+  //returns false if the search should stop
+  bool Recurse(int level,const IntTriple& cell) {
+    AABB3D bb;
+    pc.GetCellBounds(level,cell,bb);
+    if(sampler.Test(Tpg*((bb.bmin+bb.bmax)*Half),Half*bb.bmin.distance(bb.bmax)) == 0) return true;
+    if(level == 0) {
+      const vector<int>& cellPoints = pc.grid.find(cell)->second;
+      for(size_t i=0;i<cellPoints.size();i++) {
+	if(sampler.Point(Tpg*pc.points[cellPoints[i]])) {
+	  cells.push_back(sampler.cell);
+	  points.push_back(cellPoints[i]);
+	  if(points.size() >= maxContacts) return false;
+	}
+      }
+      return true;
+    }
+    const vector<IntTriple>& children = pc.coarseGrids[level-1].find(cell)->second;
+    for(size_t i=0;i<children.size();i++)
+      if(!Recurse(level-1,children[i])) return false;
+    return true;
+  }
+
+  GridSampler sampler;
+  const CollisionPointCloud& pc;
+  vector<int>& cells;
+  vector<int>& points;
+  size_t maxContacts;
+  //transform from the point cloud's frame to the grid's frame
+  RigidTransform Tpg;
+};
+
+void NearbyCells(const VolumeGrid& grid,const RigidTransform& T,const CollisionPointCloud& pc,Real tol,vector<int>& cells,vector<int>& points,size_t maxContacts)
+{
+  PointCloudGridCollider collider(grid,T,pc,tol,cells,points,maxContacts);
+  int level = pc.NumLevels()-1;
+  if(level == 0) {
+    for(CollisionPointCloud::GridHash::const_iterator i=pc.grid.begin();i!=pc.grid.end();i++)
+      if(!collider.Recurse(0,i->first)) return;
+  }
+  else {
+    const CollisionPointCloud::CoarseGridHash& top = pc.coarseGrids.back();
+    for(CollisionPointCloud::CoarseGridHash::const_iterator i=top.begin();i!=top.end();i++)
+      if(!collider.Recurse(level,i->first)) return;
+  }
+}
+
+//central difference gradient of the distance field at a cell center
+void CellGradient(const VolumeGrid& grid,int i,int j,int k,Vector3& grad)
+{
+  Vector3 h = grid.GetCellSize();
+  int i1=Max(i-1,0),i2=Min(i+1,grid.value.m-1);
+  int j1=Max(j-1,0),j2=Min(j+1,grid.value.n-1);
+  int k1=Max(k-1,0),k2=Min(k+1,grid.value.p-1);
+  grad.x = (i1==i2 ? 0 : (grid.value(i2,j,k)-grid.value(i1,j,k))/(h.x*(i2-i1)));
+  grad.y = (j1==j2 ? 0 : (grid.value(i,j2,k)-grid.value(i,j1,k))/(h.y*(j2-j1)));
+  grad.z = (k1==k2 ? 0 : (grid.value(i,j,k2)-grid.value(i,j,k1))/(h.z*(k2-k1)));
+}
+
+//tests the surface cells of a that overlap b's bounding box against b.
+//Tab transforms a's frame to b's frame.  Returns false if the search
+//should stop.
+bool NearbySurfaceCells(const VolumeGrid& a,const VolumeGrid& b,const RigidTransform& Tab,Real tol,vector<int>& cellsa,vector<int>& cellsb,size_t maxContacts)
+{
+  //only a's cells near b's bounding box can come within tol of b
+  RigidTransform Tba;
+  Tba.setInverse(Tab);
+  Box3D box;
+  AABB3D bbb;
+  box.setTransformed(b.bb,Tba);
+  box.getAABB(bbb);
+  bbb.bmin -= Vector3(tol);
+  bbb.bmax += Vector3(tol);
+  if(!bbb.intersects(a.bb)) return true;
+  bbb.setIntersection(a.bb);
+  IntTriple imin,imax;
+  a.GetIndexRange(bbb,imin,imax);
+  if(imin.a < 0) imin.a = 0;
+  if(imax.a >= a.value.m) imax.a = a.value.m-1;
+  if(imin.b < 0) imin.b = 0;
+  if(imax.b >= a.value.n) imax.b = a.value.n-1;
+  if(imin.c < 0) imin.c = 0;
+  if(imax.c >= a.value.p) imax.c = a.value.p-1;
+
+  //a cell center within this distance of a's surface is a surface cell
+  Real band = Half*a.GetCellSize().norm();
+  Vector3 c,grad;
+  for(int i=imin.a;i<=imax.a;i++) {
+    for(int j=imin.b;j<=imax.b;j++) {
+      for(int k=imin.c;k<=imax.c;k++) {
+	Real va = a.value(i,j,k);
+	if(Abs(va) > band) continue;
+	//project the center onto the surface along the central difference
+	//gradient of the distance field
+	CellGradient(a,i,j,k,grad);
+	a.GetCellCenter(i,j,k,c);
+	Real gnorm = grad.norm();
+	if(gnorm > Epsilon) c.madd(grad,-va/gnorm);
+	c = Tab*c;
+	if(Distance(b,c) <= tol) {
+	  cellsa.push_back(i*a.value.n*a.value.p + j*a.value.p + k);
+	  cellsb.push_back(GetCellIndex(b,c));
+	  if(cellsa.size() >= maxContacts) return false;
+	}
+      }
+    }
+  }
+  return true;
+}
+
+void NearbyCells(const VolumeGrid& a,const RigidTransform& Ta,const VolumeGrid& b,const RigidTransform& Tb,Real tol,vector<int>& cells1,vector<int>& cells2,size_t maxContacts)
+{
+  RigidTransform Tab,Tba;
+  Tab.mulInverseA(Tb,Ta);
+  Tba.mulInverseA(Ta,Tb);
+  if(!NearbySurfaceCells(a,b,Tab,tol,cells1,cells2,maxContacts)) return;
+  NearbySurfaceCells(b,a,Tba,tol,cells2,cells1,maxContacts);
+}
+
+} //namespace Geometry
@@ -0,0 +1,54 @@
+#ifndef COLLISION_IMPLICIT_SURFACE_H
+#define COLLISION_IMPLICIT_SURFACE_H
+
+#include <meshing/VolumeGrid.h>
+#include <math3d/geometry3d.h>
+#include <limits.h>
+
+namespace Geometry {
+
+  using namespace Math3D;
+  class CollisionMesh;
+  class CollisionPointCloud;
+
+/** @addtogroup Geometry */
+/**\@{*/
+
+/* Collision queries against an implicit surface, given by a
+ * Meshing::VolumeGrid holding signed distances at the cell centers.
+ *
+ * Each lookup is O(1), and since a distance field changes no faster than
+ * the distance moved, any region of radius r around a point whose distance
+ * exceeds tol+r can be culled without sampling it.  The queries below use
+ * this to skip everything outside a narrow band around the surface, and
+ * sample only inside it, down to the resolution of the grid.
+ *
+ * Contacts on the grid are returned as flattened cell indices
+ * i*n*p + j*p + k.  Outside the grid's bounding box, the distance is
+ * assumed to be at least the distance to the box.
+ */
+
+///Returns a lower bound on the signed distance at the local point pt
+Real Distance(const Meshing::VolumeGrid& grid,const Vector3& pt);
+///Returns the flattened index of the (clamped) cell containing the local
+///point pt
+int GetCellIndex(const Meshing::VolumeGrid& grid,const Vector3& pt);
+///Returns true if the primitive g, given in the grid's local frame, comes
+///within distance tol of the surface.  The cell of the contact is returned
+///in cell.  Polygons, ellipsoids and cylinders are not supported yet.
+bool WithinDistance(const Meshing::VolumeGrid& grid,const GeometricPrimitive3D& g,Real tol,int& cell);
+///Computes the pairs of grid cells and triangles of m that come within
+///distance tol, where the grid has transform T.  Each triangle gives at
+///most one pair.  Stops once maxContacts pairs have been found.
+void NearbyCells(const Meshing::VolumeGrid& grid,const RigidTransform& T,const CollisionMesh& m,Real tol,std::vector<int>& cells,std::vector<int>& tris,size_t maxContacts=INT_MAX);
+///Computes the pairs of grid cells and points of pc within distance tol,
+///where the grid has transform T.
+void NearbyCells(const Meshing::VolumeGrid& grid,const RigidTransform& T,const CollisionPointCloud& pc,Real tol,std::vector<int>& cells,std::vector<int>& points,size_t maxContacts=INT_MAX);
+///Computes pairs of cells of a and b whose surfaces come within distance
+///tol.  The centers of each grid's surface cells are projected onto its
+///surface and tested against the other grid.
+void NearbyCells(const Meshing::VolumeGrid& a,const RigidTransform& Ta,const Meshing::VolumeGrid& b,const RigidTransform& Tb,Real tol,std::vector<int>& cells1,std::vector<int>& cells2,size_t maxContacts=INT_MAX);
+
+} //namespace Geometry
+
+#endif
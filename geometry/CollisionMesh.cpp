@@ -1,4 +1,5 @@
 #include "CollisionMesh.h"
+#include "CollisionPointCloud.h"
 #include "PenetrationDepth.h"
 #include <math3d/random.h>
 #include <math3d/clip.h>
@@ -750,6 +751,21 @@ inline void Copy(const Vector3& x,PQP_REAL p[3])
 }
 
 
+Real TriangleDistance(const CollisionMesh& m1,int t1,const CollisionMesh& m2,int t2)
+{
+  Triangle3D a,b;
+  m1.GetTriangle(t1,a);
+  m2.GetTriangle(t2,b);
+  PQP_REAL tri1[3][3],tri2[3][3],p[3],q[3];
+  Copy(m1.currentTransform*a.a,tri1[0]);
+  Copy(m1.currentTransform*a.b,tri1[1]);
+  Copy(m1.currentTransform*a.c,tri1[2]);
+  Copy(m2.currentTransform*b.a,tri2[0]);
+  Copy(m2.currentTransform*b.b,tri2[1]);
+  Copy(m2.currentTransform*b.c,tri2[2]);
+  return TriDist(p,q,tri1,tri2);
+}
+
 void BVToBox(const BV& b,Box3D& box)
 {
   Copy(b.d,box.dims);
@@ -1517,6 +1533,132 @@ void NearbyTriangles(const CollisionMesh& m1,const CollisionMesh& m2,Real d,vect
 
 
 
+/* Traverses a mesh's PQP bounding volume hierarchy and a point cloud's cell
+ * hierarchy together.  The cells' bounding boxes, grown by d, are converted
+ * to BVs in the mesh's local frame, so that whole subtrees can be culled
+ * with the OBB disjointness test.  Once a level 0 cell is reached, its
+ * points are transformed once into the mesh's frame and tested against the
+ * triangles of the remaining BV subtree, culled by their bounding sphere.
+ */
+struct MeshPointCloudCollider
+{
+  MeshPointCloudCollider(const CollisionMesh& _m,const CollisionPointCloud& _pc,Real _d,vector<int>& _tris,vector<int>& _points,size_t _max)
+    :m(_m),pc(_pc),d(_d),tris(_tris),points(_points),max(_max)
+  {
+    Tpm.mulInverseA(m.currentTransform,pc.currentTransform);
+  }
+
+  void CellBV(int level,const IntTriple& cell,BV& bv) const {
+    AABB3D bb;
+    pc.GetCellBounds(level,cell,bb);
+    bb.bmin -= Vector3(d);
+    bb.bmax += Vector3(d);
+    Box3D box;
+    box.setTransformed(bb,Tpm);
+    BoxToBV(box,bv);
+  }
+
+  bool Overlap(int b,const BV& bv) const {
+    BV bvloc;
+    ToLocal(m.pqpModel->b[b],bv,bvloc);
+    return CollideBV(m.pqpModel->b[b].d,bvloc);
+  }
+
+  //returns false if the search should stop
+  bool Recurse(int b,int level,const IntTriple& cell) {
+    BV bv;
+    CellBV(level,cell,bv);
+    if(!Overlap(b,bv)) return true;
+    if(level == 0) {
+      const vector<int>& cellPoints = pc.grid.find(cell)->second;
+      ptIndices = &cellPoints;
+      ptLocal.resize(cellPoints.size());
+      AABB3D bb;
+      pc.GetCellBounds(cell,bb);
+      cellSphere.center = Tpm*((bb.bmin+bb.bmax)*Half);
+      cellSphere.radius = 0;
+      for(size_t i=0;i<cellPoints.size();i++) {
+	ptLocal[i] = Tpm*pc.points[cellPoints[i]];
+	cellSphere.radius = Max(cellSphere.radius,ptLocal[i].distanceSquared(cellSphere.center));
+      }
+      cellSphere.radius = Sqrt(cellSphere.radius) + d;
+      return RecursePoints(b);
+    }
+    const BV& mbv = m.pqpModel->b[b];
+    Real bvSize = 2.0*Max(mbv.d[0],mbv.d[1],mbv.d[2]);
+    Real cellSize = pc.gridResolution;
+    for(int i=0;i<level;i++) cellSize *= CollisionPointCloud::coarseFactor;
+    if(mbv.Leaf() || cellSize >= bvSize) {
+      const vector<IntTriple>& children = pc.coarseGrids[level-1].find(cell)->second;
+      for(size_t i=0;i<children.size();i++)
+	if(!Recurse(b,level-1,children[i])) return false;
+    }
+    else {
+      if(!Recurse(mbv.first_child,level,cell)) return false;
+      if(!Recurse(mbv.first_child+1,level,cell)) return false;
+    }
+    return true;
+  }
+
+  //tests the points of the current level 0 cell against the subtree b
+  bool RecursePoints(int b) {
+    const BV& mbv = m.pqpModel->b[b];
+    Sphere3D sloc;
+    ToLocal(mbv,cellSphere,sloc);
+    if(!CollideBV(mbv.d,sloc)) return true;
+    if(mbv.Leaf()) {
+      int t=-mbv.first_child-1;
+      Triangle3D tri;
+      Copy(m.pqpModel->tris[t].p1,tri.a);
+      Copy(m.pqpModel->tris[t].p2,tri.b);
+      Copy(m.pqpModel->tris[t].p3,tri.c);
+      Real d2 = d*d;
+      for(size_t i=0;i<ptLocal.size();i++) {
+	if(tri.closestPoint(ptLocal[i]).distanceSquared(ptLocal[i]) <= d2) {
+	  tris.push_back(m.pqpModel->tris[t].id);
+	  points.push_back((*ptIndices)[i]);
+	  if(tris.size() >= max) return false;
+	}
+      }
+      return true;
+    }
+    if(!RecursePoints(mbv.first_child)) return false;
+    return RecursePoints(mbv.first_child+1);
+  }
+
+  const CollisionMesh& m;
+  const CollisionPointCloud& pc;
+  Real d;
+  vector<int>& tris;
+  vector<int>& points;
+  size_t max;
+  //transform from the point cloud's frame to the mesh's frame
+  RigidTransform Tpm;
+  //the current level 0 cell: a sphere containing its points grown by d,
+  //its point indices, and its points, all in the mesh's frame
+  Sphere3D cellSphere;
+  const vector<int>* ptIndices;
+  vector<Vector3> ptLocal;
+};
+
+void NearbyTriangles(const CollisionMesh& m,const CollisionPointCloud& pc,Real d,vector<int>& tris,vector<int>& points,int max)
+{
+  if(m.pqpModel->num_bvs == 0 || pc.grid.empty()) return;
+  MeshPointCloudCollider collider(m,pc,d,tris,points,max);
+  int level = pc.NumLevels()-1;
+  if(level == 0) {
+    for(CollisionPointCloud::GridHash::const_iterator i=pc.grid.begin();i!=pc.grid.end();i++)
+      if(!collider.Recurse(0,0,i->first)) return;
+  }
+  else {
+    const CollisionPointCloud::CoarseGridHash& top = pc.coarseGrids.back();
+    for(CollisionPointCloud::CoarseGridHash::const_iterator i=top.begin();i!=top.end();i++)
+      if(!collider.Recurse(0,level,i->first)) return;
+  }
+}
+
+
+
 int ClosestPointAndNormal(const TriMesh& m,Real pWeight,Real nWeight,const Vector3& p,const Vector3& n,Vector3& cp)
 {
   Real dmin=Inf;
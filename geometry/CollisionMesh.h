@@ -11,6 +11,7 @@ class PQP_Results;
 namespace Geometry {
 
   class ApproximatePenetrationDepth;
+  class CollisionPointCloud;
   using namespace Math3D;
 
 /** @ingroup Geometry
@@ -166,10 +167,19 @@ bool WithinDistance(const CollisionMesh& m1,const CollisionMesh& m2,Real d);
 void NearbyTriangles(const CollisionMesh& m,const Vector3& p,Real d,std::vector<int>& tris,int max=INT_MAX);
 void NearbyTriangles(const CollisionMesh& m,const GeometricPrimitive3D& g,Real d,std::vector<int>& tris,int max=INT_MAX);
 void NearbyTriangles(const CollisionMesh& m1,const CollisionMesh& m2,Real d,std::vector<int>& tris1,std::vector<int>& tris2,int max=INT_MAX);
+/// Computes the pairs of triangles in m and points in pc within distance d
+/// of each other, by traversing the mesh's bounding volume hierarchy and
+/// the point cloud's cell hierarchy together.  Results are appended to tris
+/// and points, stopping once they hold max pairs.
+void NearbyTriangles(const CollisionMesh& m,const CollisionPointCloud& pc,Real d,std::vector<int>& tris,std::vector<int>& points,int max=INT_MAX);
 
 /// Convenience function to check distance between two meshes
 Real Distance(const CollisionMesh& m1,const CollisionMesh& m2,Real absErr,Real relErr);
 
+/// Returns the distance between triangle t1 of m1 and triangle t2 of m2 at
+/// their current transforms
+Real TriangleDistance(const CollisionMesh& m1,int t1,const CollisionMesh& m2,int t2);
+
 ///Finds the closest point pt to p on m and returns the triangle index. cp is given in the mesh's local frame
 int ClosestPoint(const CollisionMesh& m,const Vector3& p,Vector3& cp);
 
@@ -1,14 +1,401 @@
 #include "CollisionPointCloud.h"
+#include <algorithm>
 
 namespace Geometry {
 
+//the default resolution puts about this many points in each occupied cell
+const static Real kPointsPerCell = 8;
+
+inline bool InRange(const IntTriple& c,const IntTriple& imin,const IntTriple& imax)
+{
+  return (c.a >= imin.a && c.a <= imax.a &&
+	  c.b >= imin.b && c.b <= imax.b &&
+	  c.c >= imin.c && c.c <= imax.c);
+}
+
+inline Real NumCells(const IntTriple& imin,const IntTriple& imax)
+{
+  if(imax.a < imin.a || imax.b < imin.b || imax.c < imin.c) return 0;
+  return Real(imax.a-imin.a+1)*Real(imax.b-imin.b+1)*Real(imax.c-imin.c+1);
+}
+
+//clamps the cell range [imin,imax] to the occupied cells.  Returns false
+//if the result is empty
+inline bool ClampRange(const CollisionPointCloud& pc,IntTriple& imin,IntTriple& imax)
+{
+  for(int i=0;i<3;i++) {
+    imin[i] = Max(imin[i],pc.gridMin[i]);
+    imax[i] = Min(imax[i],pc.gridMax[i]);
+    if(imin[i] > imax[i]) return false;
+  }
+  return true;
+}
+
+inline Real Distance(const AABB3D& a,const AABB3D& b)
+{
+  Real d2 = 0;
+  for(int i=0;i<3;i++) {
+    Real gap = Max(a.bmin[i]-b.bmax[i],b.bmin[i]-a.bmax[i]);
+    if(gap > 0) d2 += gap*gap;
+  }
+  return Sqrt(d2);
+}
+
+/* Calls visitor(cell,points) for each occupied cell in [imin,imax].  Stops
+ * and returns false as soon as the visitor returns false.  If the range has
+ * more cells than the grid has occupied ones, the occupied cells are
+ * enumerated instead.
+ */
+template <class Visitor>
+bool VisitCells(const CollisionPointCloud& pc,const IntTriple& imin,const IntTriple& imax,Visitor& visitor)
+{
+  if(NumCells(imin,imax) > Real(pc.grid.size())) {
+    for(CollisionPointCloud::GridHash::const_iterator i=pc.grid.begin();i!=pc.grid.end();i++) {
+      if(!InRange(i->first,imin,imax)) continue;
+      if(!visitor(i->first,i->second)) return false;
+    }
+    return true;
+  }
+  IntTriple c;
+  for(c.a=imin.a;c.a<=imax.a;c.a++) {
+    for(c.b=imin.b;c.b<=imax.b;c.b++) {
+      for(c.c=imin.c;c.c<=imax.c;c.c++) {
+	CollisionPointCloud::GridHash::const_iterator i=pc.grid.find(c);
+	if(i != pc.grid.end())
+	  if(!visitor(c,i->second)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+//lower bound on the (possibly signed) distance from g to any point in the
+//box bb.  gbb is the bounding box of g.
+inline Real BoxDistance(const GeometricPrimitive3D& g,const AABB3D& gbb,const AABB3D& bb)
+{
+  Real d = Distance(bb,gbb);
+  if(d > 0) return d;
+  //the cell overlaps g's bounding box
+  switch(g.type) {
+  case GeometricPrimitive3D::Point:
+    return g.Distance(bb);
+  case GeometricPrimitive3D::Sphere:
+    {
+      const Sphere3D* s = AnyCast<Sphere3D>(&g.data);
+      return bb.distance(s->center)-s->radius;
+    }
+  case GeometricPrimitive3D::Segment:
+  case GeometricPrimitive3D::Triangle:
+  case GeometricPrimitive3D::AABB:
+  case GeometricPrimitive3D::Box:
+    return 0;
+  default:
+    //distances may be signed
+    return -Inf;
+  }
+}
+
+inline Real CellDistance(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,const AABB3D& gbb,const IntTriple& cell)
+{
+  AABB3D bb;
+  pc.GetCellBounds(cell,bb);
+  return BoxDistance(g,gbb,bb);
+}
+
+struct WithinDistanceVisitor
+{
+  WithinDistanceVisitor(const CollisionPointCloud& _pc,const GeometricPrimitive3D& _g,const AABB3D& _gbb,Real _tol,std::vector<int>* _points,size_t _maxContacts)
+    :pc(_pc),g(_g),gbb(_gbb),tol(_tol),points(_points),maxContacts(_maxContacts),found(false)
+  {}
+  bool operator () (const IntTriple& cell,const std::vector<int>& cellPoints) {
+    if(CellDistance(pc,g,gbb,cell) > tol) return true;
+    for(size_t i=0;i<cellPoints.size();i++) {
+      if(g.Distance(pc.points[cellPoints[i]]) <= tol) {
+	found = true;
+	if(!points) return false;
+	points->push_back(cellPoints[i]);
+	if(points->size() >= maxContacts) return false;
+      }
+    }
+    return true;
+  }
+
+  const CollisionPointCloud& pc;
+  const GeometricPrimitive3D& g;
+  const AABB3D& gbb;
+  Real tol;
+  std::vector<int>* points;
+  size_t maxContacts;
+  bool found;
+};
+
+struct ClosestPointVisitor
+{
+  ClosestPointVisitor(const CollisionPointCloud& _pc,const GeometricPrimitive3D& _g,const AABB3D& _gbb)
+    :pc(_pc),g(_g),gbb(_gbb),dmin(Inf)
+  {}
+  bool operator () (const IntTriple& cell,const std::vector<int>& cellPoints) {
+    if(CellDistance(pc,g,gbb,cell) >= dmin) return true;
+    for(size_t i=0;i<cellPoints.size();i++)
+      dmin = Min(dmin,g.Distance(pc.points[cellPoints[i]]));
+    return true;
+  }
+
+  const CollisionPointCloud& pc;
+  const GeometricPrimitive3D& g;
+  const AABB3D& gbb;
+  Real dmin;
+};
+
+struct RayCastVisitor
+{
+  RayCastVisitor(const CollisionPointCloud& _pc,const Ray3D& _r,Real rad)
+    :pc(_pc),r(_r),closest(Inf),closestpt(-1)
+  {
+    s.radius = rad;
+  }
+  bool operator () (const IntTriple& cell,const std::vector<int>& cellPoints) {
+    for(size_t i=0;i<cellPoints.size();i++) {
+      s.center = pc.points[cellPoints[i]];
+      Real tmin,tmax;
+      if(s.intersects(r,&tmin,&tmax)) {
+	if(tmax >= 0 && tmin < closest) {
+	  closest = Max(tmin,0.0);
+	  closestpt = cellPoints[i];
+	}
+      }
+    }
+    return true;
+  }
+
+  const CollisionPointCloud& pc;
+  const Ray3D& r;
+  Sphere3D s;
+  Real closest;
+  int closestpt;
+};
+
+//a cell of some level of a point cloud's cell hierarchy
+struct CellNode
+{
+  int level;
+  IntTriple cell;
+  const std::vector<IntTriple>* children;  //if level > 0
+  const std::vector<int>* points;          //if level == 0
+};
+
+inline void MakeNode(const CollisionPointCloud& pc,int level,const IntTriple& cell,CellNode& n)
+{
+  n.level = level;
+  n.cell = cell;
+  if(level == 0) {
+    n.children = NULL;
+    n.points = &pc.grid.find(cell)->second;
+  }
+  else {
+    n.children = &pc.coarseGrids[level-1].find(cell)->second;
+    n.points = NULL;
+  }
+}
+
+inline void GetTopNodes(const CollisionPointCloud& pc,std::vector<CellNode>& nodes)
+{
+  nodes.resize(0);
+  CellNode n;
+  if(pc.coarseGrids.empty()) {
+    for(CollisionPointCloud::GridHash::const_iterator i=pc.grid.begin();i!=pc.grid.end();i++) {
+      MakeNode(pc,0,i->first,n);
+      nodes.push_back(n);
+    }
+  }
+  else {
+    int level = pc.NumLevels()-1;
+    const CollisionPointCloud::CoarseGridHash& top = pc.coarseGrids.back();
+    for(CollisionPointCloud::CoarseGridHash::const_iterator i=top.begin();i!=top.end();i++) {
+      MakeNode(pc,level,i->first,n);
+      nodes.push_back(n);
+    }
+  }
+}
+
+inline Real CellSize(const CollisionPointCloud& pc,int level)
+{
+  Real h = pc.gridResolution;
+  for(int i=0;i<level;i++) h *= CollisionPointCloud::coarseFactor;
+  return h;
+}
+
+//an entry of a best-first search queue.  The comparison is reversed so that
+//the STL heap functions give the entry with the smallest bound first.
+struct NodeBound
+{
+  NodeBound(Real _bound,const CellNode& _a) : bound(_bound),a(_a) {}
+  NodeBound(Real _bound,const CellNode& _a,const CellNode& _b) : bound(_bound),a(_a),b(_b) {}
+  inline bool operator < (const NodeBound& rhs) const { return bound > rhs.bound; }
+  Real bound;
+  CellNode a,b;
+};
+
+/* Traverses the cell hierarchies of two point clouds together.  Cells of b
+ * are bounded in a's local frame by the bounding box of their transformed
+ * bounding boxes.
+ */
+struct PointCloudPairQuery
+{
+  PointCloudPairQuery(const CollisionPointCloud& _a,const CollisionPointCloud& _b)
+    :a(_a),b(_b)
+  {
+    Tba.mulInverseA(a.currentTransform,b.currentTransform);
+  }
+
+  Real Bound(const CellNode& na,const CellNode& nb) const {
+    AABB3D bba,bbb;
+    Box3D bx;
+    a.GetCellBounds(na.level,na.cell,bba);
+    b.GetCellBounds(nb.level,nb.cell,bbb);
+    bx.setTransformed(bbb,Tba);
+    bx.getAABB(bbb);
+    return Distance(bba,bbb);
+  }
+
+  //returns true if nb should be split rather than na
+  bool SplitB(const CellNode& na,const CellNode& nb) const {
+    if(na.level == 0) return true;
+    if(nb.level == 0) return false;
+    return CellSize(b,nb.level) > CellSize(a,na.level);
+  }
+
+  //sets bpoints to the points of the level 0 cell nb, in a's frame
+  void GetPoints(const CellNode& nb) {
+    bpoints.resize(nb.points->size());
+    for(size_t j=0;j<bpoints.size();j++)
+      bpoints[j] = Tba*b.points[(*nb.points)[j]];
+  }
+
+  //returns false if the search should stop
+  bool Nearby(const CellNode& na,const CellNode& nb,Real tol,std::vector<int>& points1,std::vector<int>& points2,size_t maxContacts) {
+    if(Bound(na,nb) > tol) return true;
+    CellNode c;
+    if(na.level == 0 && nb.level == 0) {
+      GetPoints(nb);
+      Real tol2 = tol*tol;
+      for(size_t j=0;j<bpoints.size();j++) {
+	for(size_t i=0;i<na.points->size();i++) {
+	  if(a.points[(*na.points)[i]].distanceSquared(bpoints[j]) <= tol2) {
+	    points1.push_back((*na.points)[i]);
+	    points2.push_back((*nb.points)[j]);
+	    if(points1.size() >= maxContacts) return false;
+	  }
+	}
+      }
+    }
+    else if(SplitB(na,nb)) {
+      for(size_t j=0;j<nb.children->size();j++) {
+	MakeNode(b,nb.level-1,(*nb.children)[j],c);
+	if(!Nearby(na,c,tol,points1,points2,maxContacts)) return false;
+      }
+    }
+    else {
+      for(size_t i=0;i<na.children->size();i++) {
+	MakeNode(a,na.level-1,(*na.children)[i],c);
+	if(!Nearby(c,nb,tol,points1,points2,maxContacts)) return false;
+      }
+    }
+    return true;
+  }
+
+  //best-first search for the closest pair, ignoring cells farther than
+  //upperBound
+  Real Closest(Real upperBound,int& closest1,int& closest2) {
+    closest1 = closest2 = -1;
+    Real dmin2 = Inf;
+    std::vector<CellNode> atop,btop;
+    GetTopNodes(a,atop);
+    GetTopNodes(b,btop);
+    std::vector<NodeBound> queue;
+    for(size_t i=0;i<atop.size();i++) {
+      for(size_t j=0;j<btop.size();j++) {
+	Real d = Bound(atop[i],btop[j]);
+	if(d <= upperBound) queue.push_back(NodeBound(d,atop[i],btop[j]));
+      }
+    }
+    std::make_heap(queue.begin(),queue.end());
+    CellNode c;
+    while(!queue.empty() && queue.front().bound*queue.front().bound < dmin2) {
+      CellNode na = queue.front().a, nb = queue.front().b;
+      std::pop_heap(queue.begin(),queue.end());
+      queue.pop_back();
+      if(na.level == 0 && nb.level == 0) {
+	GetPoints(nb);
+	for(size_t j=0;j<bpoints.size();j++) {
+	  for(size_t i=0;i<na.points->size();i++) {
+	    Real d2 = a.points[(*na.points)[i]].distanceSquared(bpoints[j]);
+	    if(d2 < dmin2) {
+	      dmin2 = d2;
+	      closest1 = (*na.points)[i];
+	      closest2 = (*nb.points)[j];
+	    }
+	  }
+	}
+	continue;
+      }
+      bool splitB = SplitB(na,nb);
+      const std::vector<IntTriple>& children = (splitB ? *nb.children : *na.children);
+      for(size_t k=0;k<children.size();k++) {
+	Real d;
+	if(splitB) {
+	  MakeNode(b,nb.level-1,children[k],c);
+	  d = Bound(na,c);
+	  if(d <= upperBound && d*d < dmin2) {
+	    queue.push_back(NodeBound(d,na,c));
+	    std::push_heap(queue.begin(),queue.end());
+	  }
+	}
+	else {
+	  MakeNode(a,na.level-1,children[k],c);
+	  d = Bound(c,nb);
+	  if(d <= upperBound && d*d < dmin2) {
+	    queue.push_back(NodeBound(d,c,nb));
+	    std::push_heap(queue.begin(),queue.end());
+	  }
+	}
+      }
+    }
+    if(closest1 < 0 || Sqrt(dmin2) > upperBound) {
+      closest1 = closest2 = -1;
+      return Inf;
+    }
+    return Sqrt(dmin2);
+  }
+
+  const CollisionPointCloud &a,&b;
+  RigidTransform Tba;
+  std::vector<Vector3> bpoints;
+};
+
+//transforms g into the local frame of pc
+inline void GetLocal(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,GeometricPrimitive3D& glocal,AABB3D& gbb)
+{
+  RigidTransform Tinv;
+  Tinv.setInverse(pc.currentTransform);
+  glocal = g;
+  glocal.Transform(Tinv);
+  gbb = glocal.GetAABB();
+}
+
+size_t CollisionPointCloud::CellHash::operator () (const IntTriple& cell) const
+{
+  return size_t(cell.a)*73856093 ^ size_t(cell.b)*19349663 ^ size_t(cell.c)*83492791;
+}
+
 CollisionPointCloud::CollisionPointCloud()
+  :gridResolution(0),gridMin(0,0,0),gridMax(-1,-1,-1)
 {
   currentTransform.setIdentity();
 }
 
 CollisionPointCloud::CollisionPointCloud(const Meshing::PointCloud3D& _pc)
-  :Meshing::PointCloud3D(_pc)
+  :Meshing::PointCloud3D(_pc),gridResolution(0),gridMin(0,0,0),gridMax(-1,-1,-1)
 {
   currentTransform.setIdentity();
   InitCollisions();
@@ -19,6 +406,83 @@ void CollisionPointCloud::InitCollisions()
   bblocal.minimize();
   for(size_t i=0;i<points.size();i++)
     bblocal.expand(points[i]);
+  grid.clear();
+  coarseGrids.clear();
+  gridMin.set(0,0,0);
+  gridMax.set(-1,-1,-1);
+  if(points.empty()) return;
+
+  if(gridResolution <= 0) {
+    //assume the points are evenly distributed over a surface spanning
+    //the two largest dimensions of the bounding box
+    Real dims[3];
+    for(int i=0;i<3;i++) dims[i] = bblocal.bmax[i]-bblocal.bmin[i];
+    std::sort(dims,dims+3);
+    Real numCells = Max(Real(points.size())/kPointsPerCell,Real(1));
+    if(dims[1] > 0) gridResolution = Sqrt(dims[2]*dims[1]/numCells);
+    else if(dims[2] > 0) gridResolution = dims[2]/numCells;
+    else gridResolution = 1;
+    //avoid overflowing the cell indices
+    gridResolution = Max(gridResolution,dims[2]*1e-6);
+  }
+
+  IntTriple cell;
+  GetCell(bblocal.bmin,gridMin);
+  GetCell(bblocal.bmax,gridMax);
+  for(size_t i=0;i<points.size();i++) {
+    GetCell(points[i],cell);
+    grid[cell].push_back(int(i));
+  }
+  //build the cell hierarchy
+  if(grid.size() > 8) {
+    coarseGrids.resize(1);
+    for(GridHash::const_iterator i=grid.begin();i!=grid.end();i++) {
+      GetParentCell(i->first,cell);
+      coarseGrids[0][cell].push_back(i->first);
+    }
+    while(coarseGrids.back().size() > 8) {
+      coarseGrids.resize(coarseGrids.size()+1);
+      const CoarseGridHash& children = coarseGrids[coarseGrids.size()-2];
+      for(CoarseGridHash::const_iterator i=children.begin();i!=children.end();i++) {
+	GetParentCell(i->first,cell);
+	coarseGrids.back()[cell].push_back(i->first);
+      }
+    }
+  }
+}
+
+void CollisionPointCloud::GetCell(const Vector3& p,IntTriple& cell) const
+{
+  cell.a = (int)Floor(p.x/gridResolution);
+  cell.b = (int)Floor(p.y/gridResolution);
+  cell.c = (int)Floor(p.z/gridResolution);
+}
+
+void CollisionPointCloud::GetCellBounds(const IntTriple& cell,AABB3D& bb) const
+{
+  bb.bmin.set(cell.a*gridResolution,cell.b*gridResolution,cell.c*gridResolution);
+  bb.bmax.set((cell.a+1)*gridResolution,(cell.b+1)*gridResolution,(cell.c+1)*gridResolution);
+}
+
+//rounds toward -infinity
+inline int FloorDiv(int i,int n)
+{
+  return (i >= 0 ? i/n : -((-i-1)/n)-1);
+}
+
+void CollisionPointCloud::GetParentCell(const IntTriple& cell,IntTriple& parent) const
+{
+  parent.a = FloorDiv(cell.a,coarseFactor);
+  parent.b = FloorDiv(cell.b,coarseFactor);
+  parent.c = FloorDiv(cell.c,coarseFactor);
+}
+
+void CollisionPointCloud::GetCellBounds(int level,const IntTriple& cell,AABB3D& bb) const
+{
+  Real h = gridResolution;
+  for(int i=0;i<level;i++) h *= coarseFactor;
+  bb.bmin.set(cell.a*h,cell.b*h,cell.c*h);
+  bb.bmax.set((cell.a+1)*h,(cell.b+1)*h,(cell.c+1)*h);
 }
 
 void GetBB(const CollisionPointCloud& pc,Box3D& b)
@@ -33,19 +497,57 @@ bool WithinDistance(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,
   //quick reject test
   if(g.Distance(bb) > tol) return false;
 
-  //test all points, linearly
-  for(size_t i=0;i<pc.points.size();i++)
-    if(g.Distance(pc.points[i]) <= tol) return true;
-  return false;
+  GeometricPrimitive3D glocal;
+  AABB3D gbb;
+  GetLocal(pc,g,glocal,gbb);
+  IntTriple imin,imax;
+  pc.GetCell(gbb.bmin-Vector3(tol),imin);
+  pc.GetCell(gbb.bmax+Vector3(tol),imax);
+  if(!ClampRange(pc,imin,imax)) return false;
+  WithinDistanceVisitor visitor(pc,glocal,gbb,tol,NULL,0);
+  VisitCells(pc,imin,imax,visitor);
+  return visitor.found;
 }
 
 Real Distance(const CollisionPointCloud& pc,const GeometricPrimitive3D& g)
 {
-  Real dmax = Inf;
-  //test all points, linearly
-  for(size_t i=0;i<pc.points.size();i++)
-    dmax = Min(dmax,g.Distance(pc.points[i]));
-  return dmax;
+  if(pc.points.empty()) return Inf;
+  GeometricPrimitive3D glocal;
+  AABB3D gbb;
+  GetLocal(pc,g,glocal,gbb);
+
+  //best-first search over the cell hierarchy, ordered by a lower bound on
+  //the distance to g
+  ClosestPointVisitor visitor(pc,glocal,gbb);
+  std::vector<CellNode> top;
+  GetTopNodes(pc,top);
+  std::vector<NodeBound> queue;
+  AABB3D bb;
+  for(size_t i=0;i<top.size();i++) {
+    pc.GetCellBounds(top[i].level,top[i].cell,bb);
+    queue.push_back(NodeBound(BoxDistance(glocal,gbb,bb),top[i]));
+  }
+  std::make_heap(queue.begin(),queue.end());
+  CellNode c;
+  while(!queue.empty() && queue.front().bound < visitor.dmin) {
+    CellNode n = queue.front().a;
+    std::pop_heap(queue.begin(),queue.end());
+    queue.pop_back();
+    if(n.level == 0) {
+      visitor(n.cell,*n.points);
+      continue;
+    }
+    for(size_t i=0;i<n.children->size();i++) {
+      MakeNode(pc,n.level-1,(*n.children)[i],c);
+      pc.GetCellBounds(c.level,c.cell,bb);
+      Real d = BoxDistance(glocal,gbb,bb);
+      if(d < visitor.dmin) {
+	queue.push_back(NodeBound(d,c));
+	std::push_heap(queue.begin(),queue.end());
+      }
+    }
+  }
+  return visitor.dmin;
 }
 
 void NearbyPoints(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,Real tol,std::vector<int>& points,size_t maxContacts)
@@ -55,12 +557,100 @@ void NearbyPoints(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,Re
   //quick reject test
   if(g.Distance(bb) > tol) return;
 
-  //test all points, linearly
-  for(size_t i=0;i<pc.points.size();i++)
-    if(g.Distance(pc.points[i]) <= tol) {
-      points.push_back(int(i));
-      if(points.size()>=maxContacts) return;
+  GeometricPrimitive3D glocal;
+  AABB3D gbb;
+  GetLocal(pc,g,glocal,gbb);
+  IntTriple imin,imax;
+  pc.GetCell(gbb.bmin-Vector3(tol),imin);
+  pc.GetCell(gbb.bmax+Vector3(tol),imax);
+  if(!ClampRange(pc,imin,imax)) return;
+  WithinDistanceVisitor visitor(pc,glocal,gbb,tol,&points,maxContacts);
+  VisitCells(pc,imin,imax,visitor);
+}
+
+int RayCast(const CollisionPointCloud& pc,Real rad,const Ray3D& r,Vector3& pt)
+{
+  Ray3D rlocal;
+  pc.currentTransform.mulInverse(r.source,rlocal.source);
+  pc.currentTransform.R.mulTranspose(r.direction,rlocal.direction);
+  AABB3D bb = pc.bblocal;
+  bb.bmin -= Vector3(rad);
+  bb.bmax += Vector3(rad);
+  Real tmin=0,tmax=Inf;
+  if(pc.points.empty() || !rlocal.Line3D::intersects(bb,tmin,tmax)) return -1;
+
+  //walk along the cells hit by the ray (3D DDA), visiting all cells within
+  //k cells of each.  Consecutive cells differ by one step along one axis, so
+  //only a new slab of the k-neighborhood needs to be visited.
+  RayCastVisitor visitor(pc,rlocal,rad);
+  Real h = pc.gridResolution;
+  int k = (int)Ceil(rad/h);
+  Vector3 p0 = rlocal.source + tmin*rlocal.direction;
+  IntTriple c;
+  pc.GetCell(p0,c);
+  int step[3];
+  Real tnext[3],tdelta[3];
+  for(int i=0;i<3;i++) {
+    Real d = rlocal.direction[i];
+    if(d > 0) {
+      step[i] = 1;
+      tnext[i] = tmin + ((c[i]+1)*h-p0[i])/d;
+      tdelta[i] = h/d;
+    }
+    else if(d < 0) {
+      step[i] = -1;
+      tnext[i] = tmin + (c[i]*h-p0[i])/d;
+      tdelta[i] = -h/d;
+    }
+    else {
+      step[i] = 0;
+      tnext[i] = tdelta[i] = Inf;
     }
+  }
+  IntTriple smin(c.a-k,c.b-k,c.c-k),smax(c.a+k,c.b+k,c.c+k);
+  if(ClampRange(pc,smin,smax))
+    VisitCells(pc,smin,smax,visitor);
+  for(;;) {
+    int i = 0;
+    if(tnext[1] < tnext[i]) i=1;
+    if(tnext[2] < tnext[i]) i=2;
+    //all points hit before the next cell have been visited
+    if(tnext[i] > tmax || tnext[i] >= visitor.closest) break;
+    c[i] += step[i];
+    tnext[i] += tdelta[i];
+    smin.set(c.a-k,c.b-k,c.c-k);
+    smax.set(c.a+k,c.b+k,c.c+k);
+    smin[i] = smax[i] = c[i]+step[i]*k;
+    if(ClampRange(pc,smin,smax))
+      VisitCells(pc,smin,smax,visitor);
+  }
+  if(visitor.closestpt >= 0)
+    pt = r.source + visitor.closest*r.direction;
+  return visitor.closestpt;
+}
+
+bool WithinDistance(const CollisionPointCloud& a,const CollisionPointCloud& b,Real tol)
+{
+  std::vector<int> points1,points2;
+  NearbyPoints(a,b,tol,points1,points2,1);
+  return !points1.empty();
+}
+
+void NearbyPoints(const CollisionPointCloud& a,const CollisionPointCloud& b,Real tol,std::vector<int>& points1,std::vector<int>& points2,size_t maxContacts)
+{
+  PointCloudPairQuery query(a,b);
+  std::vector<CellNode> atop,btop;
+  GetTopNodes(a,atop);
+  GetTopNodes(b,btop);
+  for(size_t i=0;i<atop.size();i++)
+    for(size_t j=0;j<btop.size();j++)
+      if(!query.Nearby(atop[i],btop[j],tol,points1,points2,maxContacts)) return;
+}
+
+Real Distance(const CollisionPointCloud& a,const CollisionPointCloud& b,int& closest1,int& closest2,Real upperBound)
+{
+  PointCloudPairQuery query(a,b);
+  return query.Closest(upperBound,closest1,closest2);
 }
 
 } //namespace Geometry
@@ -3,30 +3,95 @@
 
 #include <meshing/PointCloud.h>
 #include <math3d/geometry3d.h>
+#include <utils/IntTriple.h>
 #include <limits.h>
+#ifdef _MSC_VER
+//MSVC doesn't put TR1 files in the tr1/ folder
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif //_MSC_VER
 
 namespace Geometry {
 
   using namespace Math3D;
 
+/** @ingroup Geometry
+ * @brief A point cloud with a sparse voxel hash for collision queries.
+ *
+ * InitCollisions() computes the local bounding box and bins the points
+ * into cubic grid cells of size gridResolution, so that queries only test
+ * the points in cells near the query object.  If gridResolution <= 0, a
+ * resolution is picked that puts roughly 8 points in each occupied cell,
+ * assuming that the points sample a surface.
+ *
+ * The occupied cells are also organized into a hierarchy: the cells of
+ * level l+1 are blocks of coarseFactor^3 cells of level l (level 0 being
+ * the grid itself), up to a top level with at most 8 occupied cells.
+ * This lets distance queries and queries between two point clouds cull
+ * large empty or distant regions at once.
+ *
+ * The grid and bounding box are in local coordinates, and currentTransform
+ * gives the transform from local to world coordinates.
+ */
 class CollisionPointCloud : public Meshing::PointCloud3D
 {
  public:
+  struct CellHash
+  {
+    size_t operator () (const IntTriple& cell) const;
+  };
+  typedef std::tr1::unordered_map<IntTriple,std::vector<int>,CellHash> GridHash;
+  typedef std::tr1::unordered_map<IntTriple,std::vector<IntTriple>,CellHash> CoarseGridHash;
+  static const int coarseFactor = 8;
+
   CollisionPointCloud();
   CollisionPointCloud(const Meshing::PointCloud3D& pc);
   ///Needs to be called if this point cloud was loaded or set up any other
   ///way than the constructor
   void InitCollisions();
+  ///Returns the grid cell containing the local point p
+  void GetCell(const Vector3& p,IntTriple& cell) const;
+  ///Returns the local bounding box of a grid cell
+  void GetCellBounds(const IntTriple& cell,AABB3D& bb) const;
+  ///Returns the number of levels in the cell hierarchy
+  inline int NumLevels() const { return (int)coarseGrids.size()+1; }
+  ///Returns the cell of the given level containing the given cell of the
+  ///level below
+  void GetParentCell(const IntTriple& cell,IntTriple& parent) const;
+  ///Returns the local bounding box of a cell of the given level
+  void GetCellBounds(int level,const IntTriple& cell,AABB3D& bb) const;
 
-  //TODO: collision accelerators
   AABB3D bblocal;
   RigidTransform currentTransform;
+  ///Size of the grid cells.  If <= 0, InitCollisions() picks a default
+  Real gridResolution;
+  ///The range of occupied grid cells
+  IntTriple gridMin,gridMax;
+  ///Maps occupied grid cells to the indices of the points they contain
+  GridHash grid;
+  ///coarseGrids[l-1] maps the occupied cells of level l>=1 to the occupied
+  ///cells of level l-1 that they contain
+  std::vector<CoarseGridHash> coarseGrids;
 };
 
 void GetBB(const CollisionPointCloud& pc,Box3D& b);
 bool WithinDistance(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,Real tol);
 Real Distance(const CollisionPointCloud& pc,const GeometricPrimitive3D& g);
 void NearbyPoints(const CollisionPointCloud& pc,const GeometricPrimitive3D& g,Real tol,std::vector<int>& points,size_t maxContacts=INT_MAX);
+///Returns the index of the first point within distance rad of the ray r,
+///or -1 if there is none.  The hit point on the ray is returned in pt.
+///(r and pt are given in world coordinates)
+int RayCast(const CollisionPointCloud& pc,Real rad,const Ray3D& r,Vector3& pt);
+///Returns true if some point of a is within distance tol of some point of b
+bool WithinDistance(const CollisionPointCloud& a,const CollisionPointCloud& b,Real tol);
+///Returns the pairs of points of a and b that are within distance tol of
+///each other, stopping once maxContacts pairs have been found
+void NearbyPoints(const CollisionPointCloud& a,const CollisionPointCloud& b,Real tol,std::vector<int>& points1,std::vector<int>& points2,size_t maxContacts=INT_MAX);
+///Returns the distance between the closest pair of points of a and b,
+///and their indices in closest1 and closest2.  If the distance is greater
+///than upperBound, the search may stop early and return Inf with -1 indices.
+Real Distance(const CollisionPointCloud& a,const CollisionPointCloud& b,int& closest1,int& closest2,Real upperBound=Inf);
 
 } //namespace Geometry
 
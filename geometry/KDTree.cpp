@@ -1,10 +1,16 @@
 #include "KDTree.h"
 #include <math/metric.h>
 #include <utils/arrayutils.h>
+#include <utils/ThreadPool.h>
 #include <errors.h>
+#include <algorithm>
 using namespace Geometry;
 using namespace std;
 
+//number of leaf points whose distances are evaluated together
+const static int kLeafBlockSize = 16;
+const static int kDefaultLeafSize = 16;
+
 struct DDimensionCmp
 {
   typedef KDTree::Point Point;
@@ -15,6 +21,24 @@ struct DDimensionCmp
   int d;
 };
 
+//compares rows of a row-major point array in dimension d
+struct RowDimensionCmp
+{
+  RowDimensionCmp(const Real* _data,int _k,int _d) : data(_data),k(_k),d(_d) {}
+  inline bool operator ()(int a,int b) const { return data[a*k+d] < data[b*k+d]; }
+  const Real* data;
+  int k,d;
+};
+
+struct RowPos
+{
+  RowPos(const Real* _data,int _k,int _d,Real _val) : data(_data),k(_k),d(_d),val(_val) {}
+  inline bool operator ()(int a) const { return data[a*k+d] > val; }
+  const Real* data;
+  int k,d;
+  Real val;
+};
+
 inline bool Pos(const Vector& x,int dim,Real val) { return x(dim)>val; }
 
 inline int _MaxDist(Real* dist, int k)
@@ -23,7 +47,7 @@ inline int _MaxDist(Real* dist, int k)
   for(int i=1;i<k;i++)
     if(dist[i] > dist[imax]) imax=i;
   return imax;
-} 
+}
 
 
 KDTree* KDTree::Create(const std::vector<Vector>& p, int k, int depth)
@@ -36,7 +60,30 @@ KDTree* KDTree::Create(const std::vector<Vector>& p, int k, int depth)
   return new KDTree(pts,k,depth);
 }
 
-KDTree::KDTree(std::vector<Point>& p, int k, int depth, int _d)
+KDTree* KDTree::Build(const std::vector<Vector>& p, int k, int maxLeafSize)
+{
+  int n=(int)p.size();
+  std::vector<Real> data(n*k);
+  std::vector<int> idx(n),order(n);
+  for(int i=0;i<n;i++) {
+    Assert(p[i].n == k);
+    for(int j=0;j<k;j++) data[i*k+j] = p[i](j);
+    idx[i] = i;
+    order[i] = i;
+  }
+  KDTree* tree = new KDTree(k,maxLeafSize);
+  if(n > 0) tree->_Build(&data[0],&idx[0],&order[0],n);
+  return tree;
+}
+
+KDTree::KDTree(int _k, int _maxLeafSize)
+  :dim(-1),val(0),pos(NULL),neg(NULL),k(_k),size(0),buildSize(0),maxLeafSize(_maxLeafSize),capacity(0)
+{
+  Assert(maxLeafSize >= 1);
+}
+
+KDTree::KDTree(std::vector<Point>& p, int _k, int depth, int _d)
+  :dim(-1),val(0),pos(NULL),neg(NULL),k(_k),size((int)p.size()),buildSize((int)p.size()),maxLeafSize(kDefaultLeafSize),capacity(0)
 {
   //the while loop goes through the possibility that the data are all in
   //the d-plane
@@ -60,7 +107,15 @@ KDTree::KDTree(std::vector<Point>& p, int k, int depth, int _d)
   }
   dim=-1;
   pos=neg=NULL;
-  pts=p;
+  _Reserve((int)p.size());
+  for(size_t i=0;i<p.size();i++)
+    _Append(*p[i].pt,p[i].index);
+}
+
+KDTree::~KDTree()
+{
+  SafeDelete(pos);
+  SafeDelete(neg);
 }
 
 int KDTree::MaxDepth() const
@@ -81,13 +136,13 @@ int KDTree::MinDepth() const
 
 int KDTree::MaxLeafSize() const
 {
-  if(IsLeaf()) return pts.size();
+  if(IsLeaf()) return (int)indices.size();
   return Max(pos->MaxLeafSize(),neg->MaxLeafSize());
 }
 
 int KDTree::MinLeafSize() const
 {
-  if(IsLeaf()) return pts.size();
+  if(IsLeaf()) return (int)indices.size();
   return Min(pos->MinLeafSize(),neg->MinLeafSize());
 }
 
@@ -97,18 +152,205 @@ KDTree* KDTree::Locate(const Vector& p)
   if(IsLeaf()) return this;
   if(Pos(p,dim,val)) return pos->Locate(p);
   else return neg->Locate(p);
-} 
+}
+
+void KDTree::Insert(const Vector& p,int index)
+{
+  Assert(p.n == k);
+  //descend to the leaf, remembering the topmost subtree that has become
+  //unbalanced since it was last built
+  KDTree* n=this,*scapegoat=NULL;
+  while(!n->IsLeaf()) {
+    n->size++;
+    KDTree* c = (Pos(p,n->dim,n->val) ? n->pos : n->neg);
+    if(!scapegoat && n->size >= 2*n->buildSize && (c->size+1)*4 > n->size*3)
+      scapegoat = n;
+    n = c;
+  }
+  n->size++;
+  n->_Append(p,index);
+  if(scapegoat)
+    scapegoat->Rebuild();
+  else if(n->size > n->maxLeafSize && (n->buildSize <= n->maxLeafSize || n->size >= 2*n->buildSize))
+    //the second test avoids repeatedly trying to split coincident points
+    n->_Split();
+}
 
 bool KDTree::Remove(int i) {
   Assert(IsLeaf());
-  for(size_t k=0;k<pts.size();k++)
-    if(i == pts[k].index) {
-      pts.erase(pts.begin()+k);
+  for(size_t j=0;j<indices.size();j++)
+    if(i == indices[j]) {
+      _Erase((int)j);
+      size--;
       return true;
     }
   return false;
 }
 
+bool KDTree::Remove(const Vector& p,int i)
+{
+  if(IsLeaf()) return Remove(i);
+  bool res = (Pos(p,dim,val) ? pos->Remove(p,i) : neg->Remove(p,i));
+  if(res) size--;
+  return res;
+}
+
+void KDTree::Rebuild()
+{
+  std::vector<Real> data;
+  std::vector<int> idx;
+  data.reserve(size*k);
+  idx.reserve(size);
+  _Collect(data,idx);
+  SafeDelete(pos);
+  SafeDelete(neg);
+  dim = -1;
+  coords.clear();
+  indices.clear();
+  capacity = 0;
+  size = buildSize = 0;
+  int n=(int)idx.size();
+  if(n == 0) return;
+  std::vector<int> order(n);
+  for(int i=0;i<n;i++) order[i]=i;
+  _Build(&data[0],&idx[0],&order[0],n);
+}
+
+void KDTree::_Split()
+{
+  Assert(IsLeaf());
+  Rebuild();
+  if(IsLeaf()) buildSize = size;
+}
+
+void KDTree::_Build(const Real* data,const int* idx,int* order,int n)
+{
+  size = buildSize = n;
+  if(n > maxLeafSize) {
+    //split the dimension of widest extent
+    Real maxWidth = 0;
+    for(int j=0;j<k;j++) {
+      Real lo=data[order[0]*k+j],hi=lo;
+      for(int i=1;i<n;i++) {
+	Real v=data[order[i]*k+j];
+	if(v < lo) lo=v;
+	else if(v > hi) hi=v;
+      }
+      if(hi-lo > maxWidth) {
+	maxWidth = hi-lo;
+	dim = j;
+	val = (lo+hi)*Half;
+      }
+    }
+    if(dim >= 0) {
+      //median split, unless duplicates of the median would put everything
+      //on one side, in which case the midpoint of the range is used
+      int m=n/2;
+      Real mid=val;
+      std::nth_element(order,order+m,order+n,RowDimensionCmp(data,k,dim));
+      val = data[order[m]*k+dim];
+      int npos = std::partition(order,order+n,RowPos(data,k,dim,val))-order;
+      if(npos == 0 || npos == n) {
+	val = mid;
+	npos = std::partition(order,order+n,RowPos(data,k,dim,val))-order;
+      }
+      Assert(npos > 0 && npos < n);
+      pos = new KDTree(k,maxLeafSize);
+      neg = new KDTree(k,maxLeafSize);
+      pos->_Build(data,idx,order,npos);
+      neg->_Build(data,idx,order+npos,n-npos);
+      return;
+    }
+    //all points coincide, can't split
+  }
+  _Reserve(n);
+  for(int i=0;i<n;i++)
+    _Append(&data[order[i]*k],idx[order[i]]);
+}
+
+void KDTree::_Collect(std::vector<Real>& data,std::vector<int>& idx) const
+{
+  if(!IsLeaf()) {
+    pos->_Collect(data,idx);
+    neg->_Collect(data,idx);
+    return;
+  }
+  for(size_t i=0;i<indices.size();i++) {
+    for(int j=0;j<k;j++)
+      data.push_back(coords[j*capacity+i]);
+    idx.push_back(indices[i]);
+  }
+}
+
+void KDTree::_Reserve(int n)
+{
+  if(n <= capacity) return;
+  std::vector<Real> newCoords(n*k);
+  int m=(int)indices.size();
+  for(int j=0;j<k;j++)
+    std::copy(coords.begin()+j*capacity,coords.begin()+j*capacity+m,newCoords.begin()+j*n);
+  coords.swap(newCoords);
+  capacity = n;
+  indices.reserve(n);
+}
+
+void KDTree::_Append(const Vector& p,int index)
+{
+  int i=(int)indices.size();
+  if(i == capacity) _Reserve(Max(4,capacity*2));
+  for(int j=0;j<k;j++)
+    coords[j*capacity+i] = p(j);
+  indices.push_back(index);
+}
+
+void KDTree::_Append(const Real* p,int index)
+{
+  int i=(int)indices.size();
+  if(i == capacity) _Reserve(Max(4,capacity*2));
+  for(int j=0;j<k;j++)
+    coords[j*capacity+i] = p[j];
+  indices.push_back(index);
+}
+
+void KDTree::_Erase(int i)
+{
+  int last=(int)indices.size()-1;
+  for(int j=0;j<k;j++)
+    coords[j*capacity+i] = coords[j*capacity+last];
+  indices[i] = indices[last];
+  indices.resize(last);
+}
+
+void KDTree::_LeafDistances2(const Vector& pt,int i0,int n,Real* d2) const
+{
+  for(int i=0;i<n;i++) d2[i]=0;
+  for(int j=0;j<k;j++) {
+    const Real* c=&coords[j*capacity+i0];
+    Real x=pt(j);
+    for(int i=0;i<n;i++) {
+      Real e=c[i]-x;
+      d2[i] += e*e;
+    }
+  }
+}
+
+Real KDTree::_LeafDistance(int i,const Vector& pt,Real norm,const Vector& weights) const
+{
+  bool weighted = !weights.empty();
+  Real sum=0;
+  for(int j=0;j<k;j++) {
+    Real e=Abs(coords[j*capacity+i]-pt(j));
+    Real w=(weighted ? weights(j) : One);
+    if(norm == One) sum += w*e;
+    else if(norm == Two) sum += w*e*e;
+    else if(IsInf(norm)) sum = Max(sum,w*e);
+    else sum += w*Pow(e,norm);
+  }
+  if(norm == One || IsInf(norm)) return sum;
+  else if(norm == Two) return Sqrt(sum);
+  else return Pow(sum,Inv(norm));
+}
+
 int KDTree::ClosestPoint(const Vector& pt,Real& dist) const
 {
   dist = Inf;
@@ -152,6 +394,51 @@ void KDTree::KClosestPoints(const Vector& pt,int k,Real n,const Vector& w,Real*
   _KClosestPoints2(pt,k,dist,idx,maxdist,n,w);
 }
 
+namespace Geometry {
+
+//runs a chunk of batch k-nearest queries, using a per-thread scratch heap
+struct KDTreeBatchKNN : public ParallelForBody
+{
+  KDTreeBatchKNN(const KDTree* _tree,const std::vector<Vector>& _pts,int _k,Real* _dist,int* _idx,int numThreads)
+    :tree(_tree),pts(_pts),k(_k),dist(_dist),idx(_idx),heaps(numThreads)
+  {
+    for(int i=0;i<numThreads;i++) heaps[i].resize(k);
+  }
+  virtual void Run(int begin,int end,int thread) {
+    std::pair<Real,int>* heap = &heaps[thread][0];
+    for(int i=begin;i<end;i++) {
+      int n=0;
+      tree->_KClosestPointsHeap(pts[i],k,heap,n);
+      std::sort_heap(heap,heap+n);
+      for(int j=0;j<n;j++) {
+	dist[i*k+j] = heap[j].first;
+	idx[i*k+j] = heap[j].second;
+      }
+      for(int j=n;j<k;j++) {
+	dist[i*k+j] = Inf;
+	idx[i*k+j] = -1;
+      }
+    }
+  }
+
+  const KDTree* tree;
+  const std::vector<Vector>& pts;
+  int k;
+  Real* dist;
+  int* idx;
+  std::vector<std::vector<std::pair<Real,int> > > heaps;
+};
+
+} //namespace Geometry
+
+void KDTree::BatchKClosestPoints(const std::vector<Vector>& pts,int k,Real* dist,int* idx,ThreadPool* pool) const
+{
+  if(k <= 0 || pts.empty()) return;
+  KDTreeBatchKNN body(this,pts,k,dist,idx,(pool ? pool->NumThreads() : 1));
+  if(pool) pool->ParallelFor((int)pts.size(),body);
+  else body.Run(0,(int)pts.size(),0);
+}
+
 Real KDTree::Select(const std::vector<Point>& S, int d, int k)
 {
   return (*ArrayUtils::nth_element(S,k,DDimensionCmp(d)).pt)[d];
@@ -175,12 +462,17 @@ Real KDTree::Select(const std::vector<Point>& S, int d, int k)
 void KDTree::_ClosestPoint(const Vector& pt,Real& dist,int& idx) const
 {
   if(IsLeaf()) {
-    //go through list,return closest pt if less than dist
-    for(size_t i=0;i<pts.size();i++) {
-      Real d=Distance_L2((const Vector&)pts[i],pt);
-      if(d < dist) {
-	idx=pts[i].index;
-	dist = d;
+    //go through list in blocks, return closest pt if less than dist
+    Real d2[kLeafBlockSize];
+    int n=(int)indices.size();
+    for(int i0=0;i0<n;i0+=kLeafBlockSize) {
+      int m=Min(kLeafBlockSize,n-i0);
+      _LeafDistances2(pt,i0,m,d2);
+      for(int i=0;i<m;i++) {
+	if(d2[i] < dist*dist) {
+	  idx=indices[i0+i];
+	  dist = Sqrt(d2[i]);
+	}
       }
     }
     return;
@@ -202,13 +494,18 @@ void KDTree::_ClosestPoint(const Vector& pt,Real& dist,int& idx) const
 void KDTree::_KClosestPoints(const Vector& pt,int k,Real* dist,int* idx,int& maxdist) const
 {
   if(IsLeaf()) {
-    //go through list,return closest pts if less than dist
-    for(size_t i=0;i<pts.size();i++) {
-      Real d=Distance_L2((const Vector&)pts[i],pt);
-      if(d < dist[maxdist]) {
-	idx[maxdist]=pts[i].index;
-	dist[maxdist]=d;
-	maxdist = _MaxDist(dist,k);
+    //go through list in blocks, return closest pts if less than dist
+    Real d2[kLeafBlockSize];
+    int n=(int)indices.size();
+    for(int i0=0;i0<n;i0+=kLeafBlockSize) {
+      int m=Min(kLeafBlockSize,n-i0);
+      _LeafDistances2(pt,i0,m,d2);
+      for(int i=0;i<m;i++) {
+	if(d2[i] < dist[maxdist]*dist[maxdist]) {
+	  idx[maxdist]=indices[i0+i];
+	  dist[maxdist]=Sqrt(d2[i]);
+	  maxdist = _MaxDist(dist,k);
+	}
       }
     }
     return;
@@ -227,23 +524,52 @@ void KDTree::_KClosestPoints(const Vector& pt,int k,Real* dist,int* idx,int& max
   }
 }
 
-
-Real Distance(const Vector& a,const Vector& b,Real norm,const Vector& weights)
+void KDTree::_KClosestPointsHeap(const Vector& pt,int k,std::pair<Real,int>* heap,int& n) const
 {
-  if(weights.empty()) 
-    return Distance(a,b,norm);
-  else 
-    return Distance_Weighted(a,b,norm,weights);
+  //heap[0..n) is a max-heap on distance
+  if(IsLeaf()) {
+    Real d2[kLeafBlockSize];
+    int m=(int)indices.size();
+    for(int i0=0;i0<m;i0+=kLeafBlockSize) {
+      int b=Min(kLeafBlockSize,m-i0);
+      _LeafDistances2(pt,i0,b,d2);
+      for(int i=0;i<b;i++) {
+	if(n < k) {
+	  heap[n] = std::pair<Real,int>(Sqrt(d2[i]),indices[i0+i]);
+	  n++;
+	  std::push_heap(heap,heap+n);
+	}
+	else if(d2[i] < heap[0].first*heap[0].first) {
+	  std::pop_heap(heap,heap+n);
+	  heap[n-1] = std::pair<Real,int>(Sqrt(d2[i]),indices[i0+i]);
+	  std::push_heap(heap,heap+n);
+	}
+      }
+    }
+    return;
+  }
+
+  Real d = pt(dim)-val;
+  if(d >= Zero) { //probably on pos side, check that first
+    pos->_KClosestPointsHeap(pt,k,heap,n);
+    if(n < k || d <= heap[0].first) //check - if necessary
+      neg->_KClosestPointsHeap(pt,k,heap,n);
+  }
+  else if(d <= Zero) { //probably on neg side, check that first
+    neg->_KClosestPointsHeap(pt,k,heap,n);
+    if(n < k || -d <= heap[0].first) //check + if necessary
+      pos->_KClosestPointsHeap(pt,k,heap,n);
+  }
 }
 
 void KDTree::_ClosestPoint2(const Vector& pt,Real& dist,int& idx,Real norm,const Vector& weights) const
 {
   if(IsLeaf()) {
     //go through list,return closest pt if less than dist
-    for(size_t i=0;i<pts.size();i++) {
-      Real d=Distance((const Vector&)pts[i],pt,norm,weights);
+    for(size_t i=0;i<indices.size();i++) {
+      Real d=_LeafDistance((int)i,pt,norm,weights);
       if(d < dist) {
-	idx=pts[i].index;
+	idx=indices[i];
 	dist = d;
       }
     }
@@ -269,27 +595,19 @@ void KDTree::_KClosestPoints2(const Vector& pt,int k,Real* dist,int* idx,int& ma
 {
   if(IsLeaf()) {
     //go through list,return closest pts if less than dist
-    for(size_t i=0;i<pts.size();i++) {
-      Real d=Distance((const Vector&)pts[i],pt,norm,weights);
+    for(size_t i=0;i<indices.size();i++) {
+      Real d=_LeafDistance((int)i,pt,norm,weights);
       if(d < dist[maxdist]) {
-	idx[maxdist]=pts[i].index;
+	idx[maxdist]=indices[i];
 	dist[maxdist]=d;
 	maxdist = _MaxDist(dist,k);
       }
     }
-    /*
-    cout<<"dist: ";
-    for(int i=0;i<k;i++)
-      cout<<dist[i]<<" ";
-    cout<<", max "<<maxDist<<endl;
-    getchar();
-    */
     return;
   }
 
   Real d = pt(dim)-val;
   if(!weights.empty()) d*=weights(dim);
-  //cout<<"plane dist: "<<d<<endl;
   if(d >= Zero) { //probably on pos side, check that first
     pos->_KClosestPoints2(pt,k,dist,idx,maxdist,norm,weights);
     if(d <= dist[maxdist]) //check - if necessary
@@ -5,12 +5,16 @@
 #include <vector>
 using namespace Math;
 
+class ThreadPool;
+
 namespace Geometry {
 
 /** @ingroup Geometry
  * @brief A node of a kd-tree.
  *
- * A whole kd-tree is created from the return value of KDTree::Create().
+ * A whole kd-tree is created from the return value of KDTree::Create()
+ * or KDTree::Build(), or an empty tree can be constructed with
+ * KDTree(k,maxLeafSize) and then grown with Insert().
  * At the end of its life, delete it.
  *
  * Members:
@@ -19,7 +23,15 @@ namespace Geometry {
  * - pos: the node on the positive side of val (that is, the node storing
  *   all points x with x(d)>val)
  * -neg: the node on the negative side of val
- * -pts: if this is a leaf, the set of points contained within
+ * -coords, indices: if this is a leaf, the points contained within.
+ *   Coordinates are stored contiguously in structure-of-arrays layout,
+ *   so that coordinate d of the i'th point is coords[d*capacity+i].
+ *
+ * Insert() splits leaves that grow beyond maxLeafSize at the median, and
+ * rebuilds any subtree on the insertion path that has become unbalanced
+ * (one child holding more than 3/4 of its points) and has at least
+ * doubled in size since it was last built.  This keeps the depth
+ * logarithmic as points are added online.
  */
 class KDTree
 {
@@ -33,10 +45,19 @@ class KDTree
 
   ///Creates a kdtree with the given points, dimension k, and max depth
   static KDTree* Create(const std::vector<Vector>& p, int k, int depth);
+  ///Creates a balanced kdtree with the given points and dimension k by
+  ///splitting at the median of the widest dimension, until leaves have at
+  ///most maxLeafSize points.
+  static KDTree* Build(const std::vector<Vector>& p, int k, int maxLeafSize=16);
 
+  ///Creates an empty tree of dimension k, to be filled using Insert()
+  KDTree(int k, int maxLeafSize=16);
   KDTree(std::vector<Point>& p, int k, int depth, int _d=0);
+  ~KDTree();
 
   inline bool IsLeaf() const { return dim==-1; }
+  ///number of points stored in this subtree
+  inline int Size() const { return size; }
   int MaxDepth() const;
   int MinDepth() const;
 
@@ -46,8 +67,15 @@ class KDTree
 
   ///finds the kdtree leaf in which this point is located
   KDTree* Locate(const Vector& p);
+  ///Inserts the point p with the given index
+  void Insert(const Vector& p,int index);
   ///The node must be a leaf
   bool Remove(int i);
+  ///Removes the point p with index i from the tree.  Returns false if it
+  ///is not found.
+  bool Remove(const Vector& p,int i);
+  ///Rebuilds this subtree with median splits
+  void Rebuild();
 
   ///returns the index of the closest point to pt, and its distance in dist
   int ClosestPoint(const Vector& pt,Real& dist) const;
@@ -64,15 +92,31 @@ class KDTree
   void KClosestPoints(const Vector& pt,int k,Real* dist,int* idx) const;
   ///same, but uses the L-n norm with weights w
   void KClosestPoints(const Vector& pt,int k,Real n,const Vector& w,Real* dist,int* idx) const;
+  ///Batch version of KClosestPoints.  The k closest points to pts[i] are
+  ///written to dist[i*k..(i+1)*k) and idx[i*k..(i+1)*k) in order of
+  ///increasing distance (unfilled entries get Inf and -1).  If pool is
+  ///given, the queries are divided amongst its threads.
+  void BatchKClosestPoints(const std::vector<Vector>& pts,int k,Real* dist,int* idx,ThreadPool* pool=NULL) const;
 
   ///gives a split value (in dim d) that gives the k'th value in the list
   static Real Select(const std::vector<Point>& S, int d, int k);
 
 private:
+  friend struct KDTreeBatchKNN;
   void _ClosestPoint(const Vector& pt,Real& dist,int& idx) const;
   void _KClosestPoints(const Vector& pt,int k,Real* dist,int* idx,int& maxdist) const;
   void _ClosestPoint2(const Vector& pt,Real& dist,int& idx,Real norm,const Vector& weights) const;
   void _KClosestPoints2(const Vector& pt,int k,Real* dist,int* idx,int& maxdist,Real norm,const Vector& weights) const;
+  void _KClosestPointsHeap(const Vector& pt,int k,std::pair<Real,int>* heap,int& n) const;
+  void _Build(const Real* data,const int* idx,int* order,int n);
+  void _Collect(std::vector<Real>& data,std::vector<int>& idx) const;
+  void _Split();
+  void _Reserve(int n);
+  void _Append(const Vector& p,int index);
+  void _Append(const Real* p,int index);
+  void _Erase(int i);
+  void _LeafDistances2(const Vector& pt,int i0,int n,Real* d2) const;
+  Real _LeafDistance(int i,const Vector& pt,Real norm,const Vector& weights) const;
 
   ///can't use copy constructor or assignment operation
   KDTree(const KDTree&) {}
@@ -81,7 +125,13 @@ private:
   int dim;
   Real val;
   KDTree *pos,*neg;
-  std::vector<Point> pts;
+  int k;
+  int size;
+  int buildSize;
+  int maxLeafSize;
+  int capacity;
+  std::vector<Real> coords;
+  std::vector<int> indices;
 };
 
 } //namespace Geometry
@@ -0,0 +1,133 @@
+#include "SweepAndPrune.h"
+#include <errors.h>
+using namespace Geometry;
+using namespace std;
+
+//orders endpoints by value, with minima before maxima at equal values so
+//that touching boxes overlap in the sorted order
+inline bool EndpointLess(const SweepAndPrune::Endpoint& a,const SweepAndPrune::Endpoint& b)
+{
+  if(a.value < b.value) return true;
+  if(a.value > b.value) return false;
+  return !(a.code & 1) && (b.code & 1);
+}
+
+SweepAndPrune::SweepAndPrune()
+  :dirty(false)
+{}
+
+void SweepAndPrune::Clear()
+{
+  boxes.clear();
+  groups.clear();
+  overlaps.clear();
+  for(int k=0;k<3;k++) axes[k].clear();
+  dirty = false;
+}
+
+int SweepAndPrune::Add(const AABB3D& bb,int group)
+{
+  int id = (int)boxes.size();
+  boxes.push_back(bb);
+  groups.push_back(group);
+  overlaps.resize(overlaps.size()+1);
+  //the new endpoints go at the end, where the box overlaps nothing, and
+  //are moved into place by the next Refresh()
+  Endpoint e;
+  for(int k=0;k<3;k++) {
+    e.code = id*2;
+    axes[k].push_back(e);
+    e.code = id*2+1;
+    axes[k].push_back(e);
+  }
+  dirty = true;
+  return id;
+}
+
+void SweepAndPrune::Update(int id,const AABB3D& bb)
+{
+  Assert(id >= 0 && id < (int)boxes.size());
+  boxes[id] = bb;
+  dirty = true;
+}
+
+void SweepAndPrune::Refresh()
+{
+  if(!dirty) return;
+  for(int k=0;k<3;k++) {
+    vector<Endpoint>& axis = axes[k];
+    for(size_t i=0;i<axis.size();i++) {
+      const AABB3D& bb = boxes[axis[i].code >> 1];
+      axis[i].value = ((axis[i].code & 1) ? bb.bmax[k] : bb.bmin[k]);
+    }
+  }
+  //each swap changes the overlap of a pair along one axis.  Overlap()
+  //looks at the new boxes on all axes, so the pairs are up to date once
+  //all axes are sorted
+  for(int k=0;k<3;k++) SortAxis(k);
+  dirty = false;
+}
+
+void SweepAndPrune::GetOverlaps(vector<IntPair>& pairs)
+{
+  Refresh();
+  pairs.resize(0);
+  for(size_t i=0;i<overlaps.size();i++)
+    for(size_t j=0;j<overlaps[i].size();j++)
+      if((int)i < overlaps[i][j]) pairs.push_back(IntPair((int)i,overlaps[i][j]));
+}
+
+void SweepAndPrune::SortAxis(int k)
+{
+  vector<Endpoint>& axis = axes[k];
+  for(size_t i=1;i<axis.size();i++) {
+    Endpoint e = axis[i];
+    size_t j = i;
+    while(j > 0 && EndpointLess(e,axis[j-1])) {
+      const Endpoint& f = axis[j-1];
+      int a = e.code >> 1, b = f.code >> 1;
+      if(a != b) {
+	bool emax = (e.code & 1), fmax = (f.code & 1);
+	if(!emax && fmax) {  //e's minimum passes f's maximum
+	  if(Overlap(a,b)) AddPair(a,b);
+	}
+	else if(emax && !fmax)  //e's maximum passes f's minimum
+	  RemovePair(a,b);
+      }
+      axis[j] = f;
+      j--;
+    }
+    axis[j] = e;
+  }
+}
+
+bool SweepAndPrune::Overlap(int a,int b) const
+{
+  return groups[a] != groups[b] && boxes[a].intersects(boxes[b]);
+}
+
+void SweepAndPrune::AddPair(int a,int b)
+{
+  vector<int>& la = overlaps[a];
+  for(size_t i=0;i<la.size();i++)
+    if(la[i] == b) return;
+  la.push_back(b);
+  overlaps[b].push_back(a);
+}
+
+//removes b from the list l, if present
+inline void EraseOverlap(vector<int>& l,int b)
+{
+  for(size_t i=0;i<l.size();i++)
+    if(l[i] == b) {
+      l[i] = l.back();
+      l.pop_back();
+      return;
+    }
+}
+
+void SweepAndPrune::RemovePair(int a,int b)
+{
+  EraseOverlap(overlaps[a],b);
+  EraseOverlap(overlaps[b],a);
+}
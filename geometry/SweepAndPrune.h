@@ -0,0 +1,68 @@
+#ifndef GEOMETRY_SWEEP_AND_PRUNE_H
+#define GEOMETRY_SWEEP_AND_PRUNE_H
+
+#include <math3d/AABB3D.h>
+#include <utils/IntPair.h>
+#include <vector>
+
+namespace Geometry {
+
+  using namespace Math3D;
+
+/** @ingroup Geometry
+ * @brief An incremental sweep-and-prune broad phase that keeps track of
+ * the overlapping pairs of a set of moving axis-aligned boxes.
+ *
+ * The box endpoints are kept sorted along each axis.  When boxes move,
+ * Refresh() re-sorts the axes by insertion sort, which takes nearly
+ * linear time if the boxes have moved little, and a pair is added to or
+ * removed from the overlap lists whenever two endpoints swap places.
+ * Boxes are closed, so touching boxes overlap.
+ *
+ * Each box belongs to a group, and only pairs of boxes in different
+ * groups are tracked.  E.g., putting all the static obstacles of a scene
+ * in one group skips the obstacle-obstacle pairs.
+ */
+class SweepAndPrune
+{
+ public:
+  SweepAndPrune();
+  void Clear();
+  ///Adds a box and returns its id.  Boxes with bmin > bmax are empty.
+  int Add(const AABB3D& bb,int group=0);
+  ///Changes the box id.  The overlaps are updated on the next Refresh().
+  void Update(int id,const AABB3D& bb);
+  ///Re-sorts the endpoints and updates the overlaps of boxes that moved
+  void Refresh();
+  ///Returns the ids of the boxes overlapping box id.  Refresh() must be
+  ///called first if any box has moved.
+  inline const std::vector<int>& Overlaps(int id) const { return overlaps[id]; }
+  ///Returns all overlapping pairs (a,b), with a < b
+  void GetOverlaps(std::vector<IntPair>& pairs);
+  inline int NumBoxes() const { return (int)boxes.size(); }
+
+  struct Endpoint
+  {
+    Real value;
+    //box id*2, plus 1 for the maximum
+    int code;
+  };
+
+  std::vector<AABB3D> boxes;
+  std::vector<int> groups;
+  ///The boxes each box overlaps
+  std::vector<std::vector<int> > overlaps;
+  ///Endpoints along the x, y, and z axes
+  std::vector<Endpoint> axes[3];
+  bool dirty;
+
+ private:
+  void SortAxis(int axis);
+  bool Overlap(int a,int b) const;
+  void AddPair(int a,int b);
+  void RemovePair(int a,int b);
+};
+
+} //namespace Geometry
+
+#endif
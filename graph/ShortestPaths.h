@@ -342,29 +342,11 @@ template <typename WeightFunc,typename InIterator,typename OutIterator>
 void ShortestPathProblem<Node,Edge>::DeleteUpdate(int u,int v,WeightFunc w,
 						  InIterator in,OutIterator out)
 {
-  if(p[v] == u) {
-    SetDistance(v,inf,-1);
-    //find the best alternate parent
-    for(g.Begin(v,in);!in.end();++in) {
-      int t=in.target();
-      if(p[t] == v) continue;
-      Assert(t != u);
-      double W=w(*in,in.source(),in.target());
-      if(d[v] > d[t]+W) {
-	SetDistance(v,d[t]+W,t);
-      }
-    }
-    if(p[v] != -1) {
-      d[v] = inf;
-      DecreaseUpdate(p[v],v,w,in,out);
-    }
-    else {
-      for(g.Begin(v,out);!out.end();++out) {
-	int t=out.target();
-	IncreaseUpdate(v,t,w,in,out);
-      }
-    }
-  }
+  //the edge must already be removed from g.  Picking a new parent for v
+  //alone may pick one of v's descendants and create a cycle, so the whole
+  //subtree under v is recomputed as though the edge's weight increased
+  if(p[v] == u)
+    IncreaseUpdate(u,v,w,in,out);
 }
 
 template <class Node,class Edge>
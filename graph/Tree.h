@@ -3,6 +3,7 @@
 
 #include "Callback.h"
 #include <errors.h>
+#include <utils/BlockPool.h>
 #include <queue>
 #include <set>
 
@@ -18,6 +19,9 @@ namespace Graph {
  * B as a child of A, first check if A is a descendent of B by calling
  * B.hasDescendant(A) or A.hasAncestor(B).
  *
+ * Nodes may be allocated from a BlockPool with new(&pool) TreeNode(...).
+ * They are deleted like any other node, and the pool must outlive them.
+ *
  * A callbacks for DFS or BFS must be a CallbackBase with a 
  * TreeNode<T,E>* as the template argument.
  */
@@ -32,6 +36,10 @@ public:
   TreeNode(const T& t);
   TreeNode(const MyType& t);
   ~TreeNode();
+  static void* operator new(size_t size) { return BlockPool::New(size,NULL); }
+  static void* operator new(size_t size,BlockPool* pool) { return BlockPool::New(size,pool); }
+  static void operator delete(void* p) { BlockPool::Delete(p); }
+  static void operator delete(void* p,BlockPool* pool) { BlockPool::Delete(p); }
   const MyType& operator =(const MyType&);
   
   inline MyType* getParent() const { return parent; }
@@ -44,6 +44,18 @@ base(0),istride(0),m(0),jstride(0),n(0)
   copy(a);
 }
 
+#if __cplusplus >= 201103L
+//Takes a's storage.  References are copied.
+template <class T>
+MatrixTemplate<T>::MatrixTemplate(MyT&& a)
+:vals(NULL),capacity(0),allocated(false),
+base(0),istride(0),m(0),jstride(0),n(0)
+{
+  if(a.allocated) swap(a);
+  else copy(a);
+}
+#endif
+
 template <class T>
 MatrixTemplate<T>::MatrixTemplate(int _m, int _n)
 :vals(NULL),capacity(0),allocated(false),
@@ -232,6 +244,22 @@ const MatrixTemplate<T>& MatrixTemplate<T>::operator = (const MyT& a)
   return *this;
 }
 
+#if __cplusplus >= 201103L
+template <class T>
+const MatrixTemplate<T>& MatrixTemplate<T>::operator = (MyT&& a)
+{
+  if(this == &a) return *this;
+  //references and matrices of the right size keep their storage, since
+  //other matrices may refer to it
+  if(a.allocated && (isEmpty() || (allocated && !hasDims(a.m,a.n)))) {
+    clear();
+    swap(a);
+    return *this;
+  }
+  return operator = ((const MyT&)a);
+}
+#endif
+
 
 template <class T>
 bool MatrixTemplate<T>::operator == (const MyT& a) const
@@ -75,6 +75,9 @@ public:
   MatrixTemplate(int m, int n, T initval);
   MatrixTemplate(int m, int n, const T* vals);
   MatrixTemplate(int m, int n, const VectorT* rows);
+#if __cplusplus >= 201103L
+  MatrixTemplate(MyT&&);
+#endif
   ~MatrixTemplate();
 
   inline T* getPointer() const { return vals; }
@@ -94,6 +97,11 @@ public:
   void clear();
 
   const MyT& operator = (const MyT&);
+#if __cplusplus >= 201103L
+  ///If this is empty, or must be reallocated to the size of a, takes a's
+  ///elements.  Otherwise, copies them like operator = (const MyT&).
+  const MyT& operator = (MyT&& a);
+#endif
   bool operator == (const MyT&) const;
   inline bool operator != (const MyT& a) const { return !operator==(a); }
   inline const T& operator() (int,int) const;
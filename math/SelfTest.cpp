@@ -12,6 +12,7 @@
 #include "BLASInterface.h"
 #include "LAPACKInterface.h"
 #include "metric.h"
+#include "fastarray.h"
 #include <errors.h>
 #include <utils/fileutils.h>
 #include <string.h>
@@ -108,6 +109,199 @@ void TestVectorBasic()
   Assert(v2.n == 1);
 }
 
+//Small vectors are stored inline, so swaps and resizes have to move their
+//elements between the inline buffer, the heap, and referenced storage
+void TestVectorInline()
+{
+  const int nsmall = 3, nlarge = VECTOR_INLINE_CAPACITY+5;
+  Vector small(nsmall),large(nlarge);
+  for(int i=0;i<nsmall;i++) small(i) = i;
+  for(int i=0;i<nlarge;i++) large(i) = 100+i;
+
+  //copies don't share elements
+  Vector copy(small);
+  copy(0) = -1;
+  Assert(small(0) == 0);
+  copy = large;
+  Assert(copy.n == nlarge);
+  Assert(copy(nlarge-1) == 100+nlarge-1);
+  copy = small;
+  Assert(copy.n == nsmall);
+  Assert(copy(2) == 2);
+
+  //inline with heap, both ways
+  swap(small,large);
+  Assert(small.n == nlarge);
+  Assert(large.n == nsmall);
+  for(int i=0;i<nlarge;i++) Assert(small(i) == 100+i);
+  for(int i=0;i<nsmall;i++) Assert(large(i) == i);
+  swap(small,large);
+  Assert(small.n == nsmall);
+  Assert(large.n == nlarge);
+  for(int i=0;i<nsmall;i++) Assert(small(i) == i);
+  for(int i=0;i<nlarge;i++) Assert(large(i) == 100+i);
+  //the swapped vectors must still own their own elements
+  small(1) = 10;
+  large(1) = 110;
+  Assert(copy(1) == 1);
+
+  //inline with inline
+  Vector small2(2,7.0);
+  swap(small,small2);
+  Assert(small.n == 2 && small(0) == 7.0 && small(1) == 7.0);
+  Assert(small2.n == nsmall && small2(1) == 10 && small2(2) == 2);
+  small(0) = 8;
+  Assert(small2(0) == 0);
+
+  //inline with a reference to every other element of an array
+  Real data[6] = {0,1,2,3,4,5};
+  Vector ref;
+  ref.setRef(data,6,0,2,3);
+  swap(small2,ref);
+  Assert(small2.n == 3 && small2(0) == 0 && small2(1) == 2 && small2(2) == 4);
+  Assert(ref.n == nsmall && ref(1) == 10 && ref(2) == 2);
+  small2(1) = 20;
+  Assert(data[2] == 20);
+  ref(0) = 30;
+  Assert(data[0] == 0);
+  swap(small2,ref);
+  Assert(ref(1) == 20);
+  Assert(small2(0) == 30);
+  ref(2) = 40;
+  Assert(data[4] == 40);
+
+  //growing past the inline capacity keeps the elements
+  Vector grow(nsmall);
+  for(int i=0;i<nsmall;i++) grow(i) = i;
+  grow.resizePersist(nlarge,-1.0);
+  Assert(grow.n == nlarge);
+  for(int i=0;i<nsmall;i++) Assert(grow(i) == i);
+  for(int i=nsmall;i<nlarge;i++) Assert(grow(i) == -1.0);
+  grow.resizePersist(2);
+  Assert(grow.n == 2 && grow(1) == 1);
+  grow.clear();
+  Assert(grow.n == 0);
+  grow.resize(nsmall,5.0);
+  Assert(grow(2) == 5.0);
+}
+
+//Expressions are evaluated in one pass, element by element, so x may appear
+//on its own right-hand side
+void TestVectorExpressions()
+{
+  const int n = VECTOR_INLINE_CAPACITY+5;
+  Vector a(n),b(n),c(n);
+  for(int i=0;i<n;i++) {
+    a(i) = i;
+    b(i) = 2*i+1;
+    c(i) = 3-i;
+  }
+  Real s = 0.5;
+
+  Vector x = a + b*s - c;
+  Assert(x.n == n);
+  for(int i=0;i<n;i++) Assert(x(i) == a(i)+b(i)*s-c(i));
+  x = s*(a - b) + c/s;
+  for(int i=0;i<n;i++) Assert(x(i) == s*(a(i)-b(i))+c(i)/s);
+  x = (a + b) - (b + c);
+  for(int i=0;i<n;i++) Assert(x(i) == (a(i)+b(i))-(b(i)+c(i)));
+
+  //x on the right-hand side
+  x = a;
+  x = a + x*s;
+  for(int i=0;i<n;i++) Assert(x(i) == a(i)+a(i)*s);
+  x = a;
+  x += (a - b)*s;
+  for(int i=0;i<n;i++) Assert(x(i) == a(i)+(a(i)-b(i))*s);
+  x = a;
+  x -= x*s;
+  for(int i=0;i<n;i++) Assert(x(i) == a(i)-a(i)*s);
+
+  //assignment resizes vectors of the wrong size, inline or on the heap
+  Vector y(2,1.0);
+  y = a - c;
+  Assert(y.n == n);
+  for(int i=0;i<n;i++) Assert(y(i) == a(i)-c(i));
+  Vector small(3),z(n+4);
+  for(int i=0;i<3;i++) small(i) = i;
+  z = small*2.0;
+  Assert(z.n == 3 && z(2) == 4);
+
+  //references of the right size are written through
+  Real data[6];
+  for(int i=0;i<6;i++) data[i] = -1;
+  Vector ref;
+  ref.setRef(data,6,1,2,3);
+  ref = small + small;
+  Assert(data[1] == 0 && data[3] == 2 && data[5] == 4);
+  Assert(data[0] == -1 && data[2] == -1 && data[4] == -1);
+  ref += small/2.0;
+  Assert(data[3] == 2.5 && data[5] == 5);
+  ref -= small + small;
+  Assert(data[3] == 0.5 && data[5] == 1);
+  Assert(data[0] == -1 && data[2] == -1 && data[4] == -1);
+}
+
+#if __cplusplus >= 201103L
+//Moves take the heap storage of their source, and copy inline elements and
+//references
+void TestVectorMoves()
+{
+  const int nsmall = 3, nlarge = VECTOR_INLINE_CAPACITY+5;
+  Vector large(nlarge);
+  for(int i=0;i<nlarge;i++) large(i) = i;
+  const Real* largeVals = large.getStart();
+  Vector moved(std::move(large));
+  Assert(moved.n == nlarge && moved.getStart() == largeVals);
+  Assert(large.n == 0);
+  for(int i=0;i<nlarge;i++) Assert(moved(i) == i);
+  Vector assigned;
+  assigned = std::move(moved);
+  Assert(assigned.n == nlarge && assigned.getStart() == largeVals);
+  Assert(moved.n == 0);
+
+  Vector small(nsmall);
+  for(int i=0;i<nsmall;i++) small(i) = i;
+  Vector movedSmall(std::move(small));
+  Assert(movedSmall.n == nsmall && movedSmall(2) == 2);
+  movedSmall(0) = 10;
+  if(small.n == nsmall) Assert(small(0) == 0);
+  Vector assignedSmall(1);
+  assignedSmall = std::move(movedSmall);
+  Assert(assignedSmall.n == nsmall && assignedSmall(0) == 10);
+
+  //moving from a reference copies and leaves the referenced data alone
+  Real data[6] = {0,1,2,3,4,5};
+  Vector ref;
+  ref.setRef(data,6,0,2,3);
+  Vector fromRef(std::move(ref));
+  Assert(fromRef.n == 3 && fromRef(1) == 2);
+  fromRef(1) = 20;
+  Assert(data[2] == 2);
+  //moving into a reference writes through to the referenced data
+  ref.setRef(data,6,0,2,3);
+  Vector src(3,7.0);
+  ref = std::move(src);
+  Assert(ref.n == 3);
+  Assert(data[0] == 7 && data[2] == 7 && data[4] == 7);
+  Assert(data[1] == 1 && data[3] == 3);
+  //as do moves into heap vectors of the right size
+  Vector dest(nlarge,0.0),other(nlarge,1.0);
+  const Real* destVals = dest.getStart();
+  dest = std::move(other);
+  Assert(dest.getStart() == destVals && dest(nlarge-1) == 1.0);
+
+  Matrix A(4,5,2.0);
+  const Real* AVals = A.getStart();
+  Matrix B(std::move(A));
+  Assert(B.m == 4 && B.n == 5 && B.getStart() == AVals && B(3,4) == 2.0);
+  Assert(A.isEmpty());
+  Matrix C(2,2);
+  C = std::move(B);
+  Assert(C.m == 4 && C.n == 5 && C.getStart() == AVals);
+}
+#endif //C++11
+
 void TestVectorOps()
 {
   cout<<"Vector ops test not done"<<endl;
@@ -117,11 +311,157 @@ void VectorSelfTest()
 {
   cout<<"Self-testing vectors"<<endl;
   TestVectorBasic();
+  TestVectorInline();
+  TestVectorExpressions();
+#if __cplusplus >= 201103L
+  TestVectorMoves();
+#endif //C++11
   TestVectorOps();
   cout<<"Done"<<endl;
   getchar();
 }
 
+void RandomMatrix(int m,int n,Matrix& A)
+{
+  A.resize(m,n);
+  for(int i=0;i<m;i++)
+    for(int j=0;j<n;j++)
+      A(i,j) = Rand(-1,1);
+}
+
+//X = A*B (or X += A*B) with a plain loop
+void NaiveMultiply(const Matrix& A,const Matrix& B,Matrix& X,bool accumulate=false)
+{
+  if(!accumulate) X.resize(A.m,B.n,Zero);
+  for(int i=0;i<A.m;i++)
+    for(int j=0;j<B.n;j++)
+      for(int k=0;k<A.n;k++)
+        X(i,j) += A(i,k)*B(k,j);
+}
+
+void CheckProduct(const Matrix& X,const Matrix& Xtrue,const char* name)
+{
+  Real tol = 1e-12*Max(1,Max(X.m,X.n));
+  Assert(X.m == Xtrue.m && X.n == Xtrue.n);
+  if(!X.isEqual(Xtrue,tol)) {
+    cout<<name<<" of size "<<X.m<<"x"<<X.n<<" isn't correct"<<endl;
+    Assert(X.isEqual(Xtrue,tol));
+  }
+}
+
+//The products for doubles use the blocked kernels of fastarray.cpp above
+//a size threshold, which are checked against plain loops for shapes that
+//aren't multiples of the register tiles, strided and transposed operands,
+//and accumulation.
+void TestMatrixProducts()
+{
+  const int shapes[][3] = {{1,1,1},{5,7,3},{6,6,6},{7,13,29},{13,300,17},{6,100,100},{100,6,100},{130,40,9},{97,257,101}};
+  Matrix A,B,At,Bt,X,Xtrue,bigA,bigB,bigX;
+  for(size_t s=0;s<sizeof(shapes)/sizeof(shapes[0]);s++) {
+    int m=shapes[s][0],n=shapes[s][1],p=shapes[s][2];
+    RandomMatrix(m,n,A);
+    RandomMatrix(n,p,B);
+    NaiveMultiply(A,B,Xtrue);
+    X.clear();
+    X.mul(A,B);
+    CheckProduct(X,Xtrue,"A*B");
+
+    //transposed operands
+    Matrix Atrans,Btrans;
+    Atrans.setRefTranspose(A);
+    Btrans.setRefTranspose(B);
+    At.resize(n,m); At.copy(Atrans);
+    Bt.resize(p,n); Bt.copy(Btrans);
+    X.clear();
+    X.mulTransposeA(At,B);
+    CheckProduct(X,Xtrue,"A^T*B");
+    X.clear();
+    X.mulTransposeB(A,Bt);
+    CheckProduct(X,Xtrue,"A*B^T");
+    Atrans.clear(); Btrans.clear();
+    Atrans.setRefTranspose(At);
+    Btrans.setRefTranspose(Bt);
+    X.clear();
+    X.mul(Atrans,Btrans);
+    CheckProduct(X,Xtrue,"transposed reference product");
+
+    //strided operands and result: every 2nd row and 3rd column
+    Matrix Aref,Bref,Xref;
+    RandomMatrix(2*m+1,3*n+2,bigA);
+    RandomMatrix(2*n+1,3*p+2,bigB);
+    RandomMatrix(2*m+1,3*p+2,bigX);
+    Aref.setRef(bigA,1,2,2,3,m,n);
+    Bref.setRef(bigB,1,2,2,3,n,p);
+    Xref.setRef(bigX,1,2,2,3,m,p);
+    Aref.getSubMatrixCopy(0,0,A);
+    Bref.getSubMatrixCopy(0,0,B);
+    NaiveMultiply(A,B,Xtrue);
+    Real corner = bigX(0,0);
+    Xref.mul(Aref,Bref);
+    CheckProduct(Xref,Xtrue,"strided A*B");
+    Assert(bigX(0,0) == corner);
+
+    //X += A*B
+    RandomMatrix(m,p,X);
+    Xtrue = X;
+    NaiveMultiply(A,B,Xtrue,true);
+    blocked_array2d_multiply(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,B.jstride,m,n,p,true);
+    CheckProduct(X,Xtrue,"X+A*B");
+
+    //matrix-vector products, with a strided vector
+    Vector x(n),xt(m),y,ytrue,y0;
+    for(int i=0;i<n;i++) x(i) = Rand(-1,1);
+    for(int i=0;i<m;i++) xt(i) = Rand(-1,1);
+    Matrix xm(n,1),ym;
+    xm.copyCol(0,x);
+    NaiveMultiply(A,xm,ym);
+    ym.getColCopy(0,ytrue);
+    A.mul(x,y);
+    Assert(y.isEqual(ytrue,1e-12*n));
+    Vector bigx(3*n),xref;
+    xref.setRef(bigx,1,3,n);
+    xref.copy(x);
+    y.clear();
+    A.mul(xref,y);
+    Assert(y.isEqual(ytrue,1e-12*n));
+    y0.resize(m);
+    for(int i=0;i<m;i++) y0(i) = Rand(-1,1);
+    y = y0;
+    A.madd(x,y);
+    ytrue += y0;
+    Assert(y.isEqual(ytrue,1e-12*n));
+    //A^T*x
+    Matrix xtm(m,1);
+    xtm.copyCol(0,xt);
+    Atrans.clear();
+    Atrans.setRefTranspose(A);
+    NaiveMultiply(Atrans,xtm,ym);
+    ytrue.clear();
+    ym.getColCopy(0,ytrue);
+    y.clear();
+    A.mulTranspose(xt,y);
+    Assert(y.isEqual(ytrue,1e-12*m));
+    y0.resize(n);
+    for(int i=0;i<n;i++) y0(i) = Rand(-1,1);
+    y = y0;
+    A.maddTranspose(xt,y);
+    ytrue += y0;
+    Assert(y.isEqual(ytrue,1e-12*m));
+  }
+
+  //all the partial register tiles of the blocked product, below the size
+  //at which the Matrix methods use it
+  for(int m=1;m<=13;m++)
+    for(int p=1;p<=17;p++) {
+      RandomMatrix(m,5,A);
+      RandomMatrix(5,p,B);
+      NaiveMultiply(A,B,Xtrue);
+      X.resize(m,p);
+      blocked_array2d_multiply(X.getStart(),X.istride,X.jstride,A.getStart(),A.istride,A.jstride,B.getStart(),B.istride,B.jstride,m,5,p);
+      CheckProduct(X,Xtrue,"small blocked A*B");
+    }
+}
+
 void MatrixSelfTest()
 {
   cout<<"Self-testing matrices"<<endl;
@@ -171,6 +511,7 @@ void MatrixSelfTest()
 
   //cout<<"A^-1*A"<<endl<<MatrixPrinter(m3)<<endl;
   Assert(m3.isEqual(m,1e-6));
+  TestMatrixProducts();
   cout<<"Done"<<endl;
   getchar();
 }
@@ -0,0 +1,182 @@
+#ifndef MATH_VECTOR_EXPRESSION_H
+#define MATH_VECTOR_EXPRESSION_H
+
+#include <errors.h>
+
+namespace Math {
+
+template <class T> class VectorTemplate;
+
+/** @ingroup Math
+ * @brief A lazily evaluated elementwise expression of VectorTemplates.
+ *
+ * The operators +, - between vectors and *, / by scalars return
+ * expressions rather than vectors.  An expression is evaluated when it is
+ * assigned to a vector, used to construct one, or added to one with += or
+ * -=, in a single pass over the elements and without temporary vectors.
+ * For example,
+ *
+ * @code
+ * x = a + b*s - c;    //x(i) = a(i) + b(i)*s - c(i), one loop
+ * x += (a-b)*h;       //an axpy
+ * @endcode
+ *
+ * Assigning resizes x to the size of the expression if they differ, and
+ * += and -= require the sizes to match.  Since element i of the result
+ * only depends on element i of the operands, x may also appear on the
+ * right hand side, but not another vector that refers to x's elements in
+ * a different order.
+ *
+ * An expression refers to the elements of its operands, so it must be
+ * evaluated before they are changed or destroyed.  It converts implicitly
+ * to a VectorTemplate where one is expected, e.g. when passed as a
+ * const VectorTemplate& argument.  Where a vector can't be deduced (e.g.,
+ * calling a method, or a template function) convert it explicitly, as in
+ * VectorTemplate<T>(a-b).norm().
+ */
+template <class T,class E>
+class VectorExpression
+{
+public:
+  explicit VectorExpression(const E& _e) : e(_e) {}
+  inline int size() const { return e.size(); }
+  inline T operator[](int i) const { return e[i]; }
+
+  E e;
+};
+
+///The elements of a vector in an expression
+template <class T>
+struct VectorOperand
+{
+  VectorOperand(const VectorTemplate<T>& v) : vals(v.getStart()),stride(v.stride),n(v.n) {}
+  inline int size() const { return n; }
+  inline T operator[](int i) const { return vals[i*stride]; }
+
+  const T* vals;
+  int stride,n;
+};
+
+struct VectorAddOp { template <class T> static inline T apply(const T& a,const T& b) { return a+b; } };
+struct VectorSubOp { template <class T> static inline T apply(const T& a,const T& b) { return a-b; } };
+
+///a op b, elementwise
+template <class T,class A,class B,class Op>
+struct VectorBinaryOperand
+{
+  VectorBinaryOperand(const A& _a,const B& _b) : a(_a),b(_b) { Assert(a.size() == b.size()); }
+  inline int size() const { return a.size(); }
+  inline T operator[](int i) const { return Op::apply(a[i],b[i]); }
+
+  A a;
+  B b;
+};
+
+///a*c
+template <class T,class A>
+struct VectorScaleOperand
+{
+  VectorScaleOperand(const A& _a,const T& _c) : a(_a),c(_c) {}
+  inline int size() const { return a.size(); }
+  inline T operator[](int i) const { return a[i]*c; }
+
+  A a;
+  T c;
+};
+
+///a/c
+template <class T,class A>
+struct VectorDivideOperand
+{
+  VectorDivideOperand(const A& _a,const T& _c) : a(_a),c(_c) {}
+  inline int size() const { return a.size(); }
+  inline T operator[](int i) const { return a[i]/c; }
+
+  A a;
+  T c;
+};
+
+#define MATH_VECTOR_BINARY_OPERATOR(op,Op) \
+template <class T> \
+inline VectorExpression<T,VectorBinaryOperand<T,VectorOperand<T>,VectorOperand<T>,Op> > \
+operator op (const VectorTemplate<T>& a,const VectorTemplate<T>& b) \
+{ \
+  typedef VectorBinaryOperand<T,VectorOperand<T>,VectorOperand<T>,Op> Operand; \
+  return VectorExpression<T,Operand>(Operand(VectorOperand<T>(a),VectorOperand<T>(b))); \
+} \
+template <class T,class E> \
+inline VectorExpression<T,VectorBinaryOperand<T,VectorExpression<T,E>,VectorOperand<T>,Op> > \
+operator op (const VectorExpression<T,E>& a,const VectorTemplate<T>& b) \
+{ \
+  typedef VectorBinaryOperand<T,VectorExpression<T,E>,VectorOperand<T>,Op> Operand; \
+  return VectorExpression<T,Operand>(Operand(a,VectorOperand<T>(b))); \
+} \
+template <class T,class E> \
+inline VectorExpression<T,VectorBinaryOperand<T,VectorOperand<T>,VectorExpression<T,E>,Op> > \
+operator op (const VectorTemplate<T>& a,const VectorExpression<T,E>& b) \
+{ \
+  typedef VectorBinaryOperand<T,VectorOperand<T>,VectorExpression<T,E>,Op> Operand; \
+  return VectorExpression<T,Operand>(Operand(VectorOperand<T>(a),b)); \
+} \
+template <class T,class E1,class E2> \
+inline VectorExpression<T,VectorBinaryOperand<T,VectorExpression<T,E1>,VectorExpression<T,E2>,Op> > \
+operator op (const VectorExpression<T,E1>& a,const VectorExpression<T,E2>& b) \
+{ \
+  typedef VectorBinaryOperand<T,VectorExpression<T,E1>,VectorExpression<T,E2>,Op> Operand; \
+  return VectorExpression<T,Operand>(Operand(a,b)); \
+}
+
+MATH_VECTOR_BINARY_OPERATOR(+,VectorAddOp)
+MATH_VECTOR_BINARY_OPERATOR(-,VectorSubOp)
+
+#undef MATH_VECTOR_BINARY_OPERATOR
+
+template <class T>
+inline VectorExpression<T,VectorScaleOperand<T,VectorOperand<T> > >
+operator * (const VectorTemplate<T>& a,T c)
+{
+  typedef VectorScaleOperand<T,VectorOperand<T> > Operand;
+  return VectorExpression<T,Operand>(Operand(VectorOperand<T>(a),c));
+}
+
+template <class T>
+inline VectorExpression<T,VectorScaleOperand<T,VectorOperand<T> > >
+operator * (T c,const VectorTemplate<T>& a)
+{
+  return a*c;
+}
+
+template <class T,class E>
+inline VectorExpression<T,VectorScaleOperand<T,VectorExpression<T,E> > >
+operator * (const VectorExpression<T,E>& a,T c)
+{
+  typedef VectorScaleOperand<T,VectorExpression<T,E> > Operand;
+  return VectorExpression<T,Operand>(Operand(a,c));
+}
+
+template <class T,class E>
+inline VectorExpression<T,VectorScaleOperand<T,VectorExpression<T,E> > >
+operator * (T c,const VectorExpression<T,E>& a)
+{
+  return a*c;
+}
+
+template <class T>
+inline VectorExpression<T,VectorDivideOperand<T,VectorOperand<T> > >
+operator / (const VectorTemplate<T>& a,T c)
+{
+  typedef VectorDivideOperand<T,VectorOperand<T> > Operand;
+  return VectorExpression<T,Operand>(Operand(VectorOperand<T>(a),c));
+}
+
+template <class T,class E>
+inline VectorExpression<T,VectorDivideOperand<T,VectorExpression<T,E> > >
+operator / (const VectorExpression<T,E>& a,T c)
+{
+  typedef VectorDivideOperand<T,VectorExpression<T,E> > Operand;
+  return VectorExpression<T,Operand>(Operand(a,c));
+}
+
+} //namespace Math
+
+#endif
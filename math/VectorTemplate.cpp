@@ -2,6 +2,7 @@
 #include "fastarray.h"
 #include "complex.h"
 #include <errors.h>
+#include <algorithm>
 using namespace std;
 
 namespace Math {
@@ -33,6 +34,18 @@ base(v.base),stride(v.stride),n(v.n)
 }
 */
 
+#if __cplusplus >= 201103L
+//Takes v's heap storage.  Inline elements and references are copied.
+template <class T>
+VectorTemplate<T>::VectorTemplate(MyT&& v)
+:vals(NULL),capacity(0),allocated(false),
+base(0),stride(1),n(0)
+{
+  if(v.allocated && !v.isInline()) swap(v);
+  else copy(v);
+}
+#endif
+
 template <class T>
 VectorTemplate<T>::VectorTemplate(int _n)
 :vals(NULL),capacity(0),allocated(false),
@@ -73,6 +86,31 @@ VectorTemplate<T>::~VectorTemplate()
   clear();
 }
 
+//Points vals to storage for _n elements, in the inline buffer if they fit
+template <class T>
+void VectorTemplate<T>::allocate(int _n)
+{
+  if(_n <= InlineCapacity) {
+    vals = inlineVals.get();
+    capacity = InlineCapacity;
+  }
+  else {
+    vals = new T[_n];
+    capacity = _n;
+    if(!vals) {
+      FatalError("Not enough memory to allocate vector of size %d",_n);
+    }
+  }
+}
+
+template <class T>
+void VectorTemplate<T>::deallocate()
+{
+  if(isInline()) vals = NULL;
+  else SafeArrayDelete(vals);
+  capacity = 0;
+}
+
 template <class T>
 void VectorTemplate<T>::resize(int _n)
 {
@@ -91,12 +129,8 @@ void VectorTemplate<T>::resize(int _n)
       clear();
     }
     if(_n > capacity) {
-      SafeArrayDelete(vals);
-      vals = new T[_n];
-      capacity = _n;
-      if(!vals) {
-	FatalError("Not enough memory to allocate vector of size %d",_n);
-      }
+      deallocate();
+      allocate(_n);
     }
     base = 0;
     stride = 1;
@@ -130,15 +164,17 @@ void VectorTemplate<T>::resizePersist(int _n)
       clear();
     }
     if(_n > capacity) {
+      //if the old values are in the inline buffer, _n > InlineCapacity,
+      //so allocate() puts the vector on the heap without touching the
+      //inline buffer, and the old values are still intact to copy.  Only
+      //an empty vector can be given the inline buffer here, and it has
+      //nothing to copy
       T* oldvals = vals;
-      vals = new T[_n];
-      capacity = _n;
-      if(!vals) {
-	FatalError("Not enough memory to allocate vector of size %d",_n);
-      }
+      bool oldInline = isInline();
+      allocate(_n);
       //copy n values 
       gen_array_equal(vals, 1, oldvals, stride, n);
-      SafeArrayDelete(oldvals);
+      if(!oldInline) SafeArrayDelete(oldvals);
     }
     base = 0;
     stride = 1;
@@ -162,7 +198,7 @@ template <class T>
 void VectorTemplate<T>::clear()
 {
   if(allocated) {
-    SafeArrayDelete(vals);
+    deallocate();
   }
   else {
     vals=NULL;
@@ -192,6 +228,22 @@ const VectorTemplate<T>& VectorTemplate<T>::operator = (const MyT& a)
   return *this;
 }
 
+#if __cplusplus >= 201103L
+template <class T>
+const VectorTemplate<T>& VectorTemplate<T>::operator = (MyT&& a)
+{
+  if(this == &a) return *this;
+  //references and vectors of the right size keep their storage, since
+  //other vectors may refer to it
+  if(a.allocated && !a.isInline() && (n == 0 || (allocated && n != a.n))) {
+    clear();
+    swap(a);
+    return *this;
+  }
+  return operator = ((const MyT&)a);
+}
+#endif
+
 template <class T>
 bool VectorTemplate<T>::operator == (const MyT& v) const
 {
@@ -203,7 +255,16 @@ bool VectorTemplate<T>::operator == (const MyT& v) const
 template <class T>
 void VectorTemplate<T>::swap(MyT& a)
 {
-  std::swap(vals,a.vals);
+  if(isInline() || a.isInline()) {
+    //exchange the buffers' contents, and point inline vectors at their own
+    bool inlineThis = isInline(), inlineA = a.isInline();
+    std::swap_ranges(inlineVals.get(),inlineVals.get()+InlineCapacity,a.inlineVals.get());
+    std::swap(vals,a.vals);
+    if(inlineA) vals = inlineVals.get();
+    if(inlineThis) a.vals = a.inlineVals.get();
+  }
+  else
+    std::swap(vals,a.vals);
   std::swap(capacity,a.capacity);
   std::swap(allocated,a.allocated);
   std::swap(base,a.base);
@@ -7,9 +7,40 @@
 #include <myfile.h>
 #include <iostream>
 #include <vector>
+#include "VectorExpression.h"
+
+/// Real-valued VectorTemplates of up to VECTOR_INLINE_CAPACITY elements
+/// store them in the object rather than on the heap.  Define it to 0 to
+/// always allocate.
+#ifndef VECTOR_INLINE_CAPACITY
+#define VECTOR_INLINE_CAPACITY 16
+#endif
 
 namespace Math {
 
+/// Number of elements a VectorTemplate<T> stores inline.  Only float and
+/// double vectors do, since T must be complete wherever the class is used
+/// (complex vectors are used with Complex only forward-declared).
+template <class T> struct VectorInlineCapacity { enum { value = 0 }; };
+template <> struct VectorInlineCapacity<float> { enum { value = VECTOR_INLINE_CAPACITY }; };
+template <> struct VectorInlineCapacity<double> { enum { value = VECTOR_INLINE_CAPACITY }; };
+
+/// Fixed-size element buffer inside a VectorTemplate
+template <class T,int N>
+struct VectorInlineBuffer
+{
+  inline T* get() { return vals; }
+  inline const T* get() const { return vals; }
+  T vals[N];
+};
+
+template <class T>
+struct VectorInlineBuffer<T,0>
+{
+  inline T* get() { return NULL; }
+  inline const T* get() const { return NULL; }
+};
+
 /** @ingroup Math
  * @brief An iterator through VectorTemplate elements.
  *
@@ -92,11 +123,11 @@ public:
  *
  * Standard math operations are provided, add, subtract, multiply, etc.
  * These operations are most often implemented as result.op(arg1,arg2,...).
- * The reason for this interface rather than operators, like a = b+c,
- * is that it avoids unnecessary copying.  A smart compiler might be able
- * to optimize the code a = b+c to avoid copying the result of b+c into a,
- * but this is by no means necessarily implemented.  Specifying the
- * operation directly is necessarily efficient.
+ * The operators +, - between vectors and *, / by scalars are also
+ * provided.  They build a VectorExpression that is evaluated in a single
+ * loop when assigned to a vector, so a = b+c*s makes no temporary vector.
+ * With C++11, vectors are also moved rather than copied out of functions
+ * that return them by value.
  *
  * When an operator is called on an empty vector, the vector is resized
  * to the proper dimensions.  If the vector is non-empty, the vector is
@@ -109,6 +140,14 @@ public:
  * on STL vectors).  resizePersist(n,initVal) only sets uninitialized
  * elements to initVal.
  *
+ * Real vectors of up to VECTOR_INLINE_CAPACITY elements (16 by default) are
+ * stored in a buffer inside the object, so small vectors such as
+ * configurations are created and copied without touching the heap.  A
+ * vector only moves to the heap when it is resized beyond that capacity.
+ * Pointers to the elements of an inline vector, including references made
+ * with setRef, are valid only while the vector itself exists, and swap()
+ * copies the elements of inline vectors rather than exchanging pointers.
+ *
  * Another feature is the ability to access elements stored 
  * non-contiguously in memory.  This is handy for accessing matrix 
  * columns or diagonals directly, as though they were normal vectors.
@@ -133,6 +172,10 @@ public:
   VectorTemplate(int n, T initval);
   VectorTemplate(int n, const T* vals);
   VectorTemplate(const std::vector<T>& vals);
+  template <class E> VectorTemplate(const VectorExpression<T,E>& e);
+#if __cplusplus >= 201103L
+  VectorTemplate(MyT&&);
+#endif
   ~VectorTemplate();
 
   inline T* getPointer() const { return vals; }
@@ -150,6 +193,13 @@ public:
   void clear();
 
   const MyT& operator = (const MyT& v);
+#if __cplusplus >= 201103L
+  ///If this is empty, or must be reallocated to the size of v, takes v's
+  ///elements.  Otherwise, copies them like operator = (const MyT&).
+  const MyT& operator = (MyT&& v);
+#endif
+  ///Evaluates e into this vector, resizing it if its size differs
+  template <class E> const MyT& operator = (const VectorExpression<T,E>& e);
   bool operator == (const MyT&) const;
   inline bool operator != (const MyT& a) const { return !operator==(a); }
   inline operator T* ();
@@ -162,6 +212,8 @@ public:
   inline T& operator[] (int i);
   inline void operator += (const MyT& a) { inc(a); }
   inline void operator -= (const MyT& a) { dec(a); }
+  template <class E> void operator += (const VectorExpression<T,E>& e);
+  template <class E> void operator -= (const VectorExpression<T,E>& e);
   inline void operator *= (T c) { inplaceMul(c); }
   inline void operator /= (T c) { inplaceDiv(c); }
 
@@ -254,10 +306,16 @@ public:
   void inplaceComponentOp(T c,BinaryOp& f);
 
 private:
+  enum { InlineCapacity = VectorInlineCapacity<T>::value };
+  inline bool isInline() const { return InlineCapacity > 0 && vals == inlineVals.get(); }
+  void allocate(int size);
+  void deallocate();
+
   //read only
   T* vals;
   int capacity;
   bool allocated;
+  VectorInlineBuffer<T,InlineCapacity> inlineVals;
 
 public:
   //alterable
@@ -373,6 +431,46 @@ inline VectorTemplate<T>::operator const T* () const
   return vals+base; 
 }
 
+template <class T>
+template <class E>
+VectorTemplate<T>::VectorTemplate(const VectorExpression<T,E>& e)
+:vals(NULL),capacity(0),allocated(false),
+base(0),stride(1),n(0)
+{
+  operator = (e);
+}
+
+template <class T>
+template <class E>
+const VectorTemplate<T>& VectorTemplate<T>::operator = (const VectorExpression<T,E>& e)
+{
+  if(n != e.size()) resize(e.size());
+  T* v=getStart();
+  for(int i=0;i<n;i++,v+=stride)
+    *v = e[i];
+  return *this;
+}
+
+template <class T>
+template <class E>
+void VectorTemplate<T>::operator += (const VectorExpression<T,E>& e)
+{
+  Assert(n == e.size());
+  T* v=getStart();
+  for(int i=0;i<n;i++,v+=stride)
+    *v += e[i];
+}
+
+template <class T>
+template <class E>
+void VectorTemplate<T>::operator -= (const VectorExpression<T,E>& e)
+{
+  Assert(n == e.size());
+  T* v=getStart();
+  for(int i=0;i<n;i++,v+=stride)
+    *v -= e[i];
+}
+
 template <class T>
 inline bool FuzzyEquals(const VectorTemplate<T>& a, const VectorTemplate<T>& b,T eps)
 {
@@ -426,48 +524,7 @@ inline int HasInf(const VectorTemplate<T>& x)
 
 
 
-///The following are potentially very inefficient, depending on the ability
-///of your compiler to optimize the code to eliminate copy constructor calls.
-template <class T>
-inline VectorTemplate<T> operator + (const VectorTemplate<T>& a, const VectorTemplate<T>& b)
-{
-	VectorTemplate<T> v;
-	v.add(a,b);
-	return v;
-}
-
-template <class T>
-inline VectorTemplate<T> operator - (const VectorTemplate<T>& a, const VectorTemplate<T>& b)
-{
-	VectorTemplate<T> v;
-	v.sub(a,b);
-	return v;
-}
-
-template <class T>
-inline VectorTemplate<T> operator * (const VectorTemplate<T>& a, T c)
-{
-	VectorTemplate<T> v;
-	v.mul(a,c);
-	return v;
-}
-
-template <class T>
-inline VectorTemplate<T> operator * (T c, const VectorTemplate<T>& a)
-{
-	VectorTemplate<T> v;
-	v.mul(a,c);
-	return v;
-}
-
-template <class T>
-inline VectorTemplate<T> operator / (const VectorTemplate<T>& a, T c)
-{
-	VectorTemplate<T> v;
-	v.div(a,c);
-	return v;
-}
-
+///+, - and *, / by scalars are defined in VectorExpression.h
 template <class T>
 inline VectorTemplate<T> operator / (T c, const VectorTemplate<T>& a)
 {
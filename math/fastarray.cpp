@@ -0,0 +1,406 @@
+#include "math.h"
+#include "fastarray.h"
+#include <vector>
+#include <string.h>
+
+#if FASTARRAY_SIMD && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define FASTARRAY_AVX2 1
+#include <immintrin.h>
+#else
+#define FASTARRAY_AVX2 0
+#endif
+
+#if FASTARRAY_SIMD && defined(__aarch64__) && defined(__ARM_NEON)
+#define FASTARRAY_NEON 1
+#include <arm_neon.h>
+#else
+#define FASTARRAY_NEON 0
+#endif
+
+namespace Math {
+
+//Blocking of the matrix product (for doubles).  The product is computed in
+//MR x NR tiles of X from packed MR-row slivers of A and NR-column slivers
+//of B.  A KC x NC panel of B (about 4Mb) stays in the L3 cache, an MC x KC
+//block of A (192Kb) in the L2 cache, and a sliver of B in the L1 cache.
+const static int MR = 6;
+const static int NR = 8;
+const static int KC = 256;
+const static int MC = 96;
+const static int NC = 2048;
+
+//The kernels.  gemm sets C (MR x NR, row major) to the product of a packed
+//MR x kc sliver of A and a packed kc x NR sliver of B.  dot4 computes the
+//dot products of the 4 rows a, a+lda, a+2lda, a+3lda with b.  axpy4 adds
+//b[0]*a + b[1]*(a+lda) + b[2]*(a+2lda) + b[3]*(a+3lda) to x.
+struct ArrayKernels
+{
+  void (*gemm)(int kc,const double* a,const double* b,double* C);
+  void (*dot4)(int n,const double* a,int lda,const double* b,double* res);
+  void (*axpy4)(int n,const double* a,int lda,const double* b,double* x);
+};
+
+static void gemm_generic(int kc,const double* a,const double* b,double* C)
+{
+  double c[MR*NR];
+  for(int i=0;i<MR*NR;i++) c[i] = 0;
+  for(int k=0;k<kc;k++,a+=MR,b+=NR) {
+    for(int i=0;i<MR;i++) {
+      double ai = a[i];
+      for(int j=0;j<NR;j++)
+        c[i*NR+j] += ai*b[j];
+    }
+  }
+  memcpy(C,c,sizeof(c));
+}
+
+static void dot4_generic(int n,const double* a,int lda,const double* b,double* res)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  double s0=0,s1=0,s2=0,s3=0;
+  for(int j=0;j<n;j++) {
+    s0 += a0[j]*b[j];
+    s1 += a1[j]*b[j];
+    s2 += a2[j]*b[j];
+    s3 += a3[j]*b[j];
+  }
+  res[0]=s0; res[1]=s1; res[2]=s2; res[3]=s3;
+}
+
+static void axpy4_generic(int n,const double* a,int lda,const double* b,double* x)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  double b0=b[0],b1=b[1],b2=b[2],b3=b[3];
+  for(int i=0;i<n;i++)
+    x[i] += b0*a0[i] + b1*a1[i] + b2*a2[i] + b3*a3[i];
+}
+
+#if FASTARRAY_AVX2
+
+__attribute__((target("avx2,fma")))
+static void gemm_avx2(int kc,const double* a,const double* b,double* C)
+{
+  __m256d c00=_mm256_setzero_pd(),c01=_mm256_setzero_pd();
+  __m256d c10=_mm256_setzero_pd(),c11=_mm256_setzero_pd();
+  __m256d c20=_mm256_setzero_pd(),c21=_mm256_setzero_pd();
+  __m256d c30=_mm256_setzero_pd(),c31=_mm256_setzero_pd();
+  __m256d c40=_mm256_setzero_pd(),c41=_mm256_setzero_pd();
+  __m256d c50=_mm256_setzero_pd(),c51=_mm256_setzero_pd();
+  for(int k=0;k<kc;k++,a+=MR,b+=NR) {
+    __m256d b0 = _mm256_loadu_pd(b);
+    __m256d b1 = _mm256_loadu_pd(b+4);
+    __m256d ai;
+    ai = _mm256_broadcast_sd(a);
+    c00 = _mm256_fmadd_pd(ai,b0,c00); c01 = _mm256_fmadd_pd(ai,b1,c01);
+    ai = _mm256_broadcast_sd(a+1);
+    c10 = _mm256_fmadd_pd(ai,b0,c10); c11 = _mm256_fmadd_pd(ai,b1,c11);
+    ai = _mm256_broadcast_sd(a+2);
+    c20 = _mm256_fmadd_pd(ai,b0,c20); c21 = _mm256_fmadd_pd(ai,b1,c21);
+    ai = _mm256_broadcast_sd(a+3);
+    c30 = _mm256_fmadd_pd(ai,b0,c30); c31 = _mm256_fmadd_pd(ai,b1,c31);
+    ai = _mm256_broadcast_sd(a+4);
+    c40 = _mm256_fmadd_pd(ai,b0,c40); c41 = _mm256_fmadd_pd(ai,b1,c41);
+    ai = _mm256_broadcast_sd(a+5);
+    c50 = _mm256_fmadd_pd(ai,b0,c50); c51 = _mm256_fmadd_pd(ai,b1,c51);
+  }
+  _mm256_storeu_pd(C,c00); _mm256_storeu_pd(C+4,c01);
+  _mm256_storeu_pd(C+8,c10); _mm256_storeu_pd(C+12,c11);
+  _mm256_storeu_pd(C+16,c20); _mm256_storeu_pd(C+20,c21);
+  _mm256_storeu_pd(C+24,c30); _mm256_storeu_pd(C+28,c31);
+  _mm256_storeu_pd(C+32,c40); _mm256_storeu_pd(C+36,c41);
+  _mm256_storeu_pd(C+40,c50); _mm256_storeu_pd(C+44,c51);
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_avx2(__m256d v)
+{
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v),_mm256_extractf128_pd(v,1));
+  return _mm_cvtsd_f64(_mm_add_sd(s,_mm_unpackhi_pd(s,s)));
+}
+
+__attribute__((target("avx2,fma")))
+static void dot4_avx2(int n,const double* a,int lda,const double* b,double* res)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  __m256d s0=_mm256_setzero_pd(),s1=_mm256_setzero_pd();
+  __m256d s2=_mm256_setzero_pd(),s3=_mm256_setzero_pd();
+  int j=0;
+  for(;j+4<=n;j+=4) {
+    __m256d bj = _mm256_loadu_pd(b+j);
+    s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0+j),bj,s0);
+    s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1+j),bj,s1);
+    s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2+j),bj,s2);
+    s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3+j),bj,s3);
+  }
+  double r0=hsum_avx2(s0),r1=hsum_avx2(s1),r2=hsum_avx2(s2),r3=hsum_avx2(s3);
+  for(;j<n;j++) {
+    r0 += a0[j]*b[j];
+    r1 += a1[j]*b[j];
+    r2 += a2[j]*b[j];
+    r3 += a3[j]*b[j];
+  }
+  res[0]=r0; res[1]=r1; res[2]=r2; res[3]=r3;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy4_avx2(int n,const double* a,int lda,const double* b,double* x)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  __m256d b0=_mm256_set1_pd(b[0]),b1=_mm256_set1_pd(b[1]);
+  __m256d b2=_mm256_set1_pd(b[2]),b3=_mm256_set1_pd(b[3]);
+  int i=0;
+  for(;i+4<=n;i+=4) {
+    __m256d xi = _mm256_loadu_pd(x+i);
+    xi = _mm256_fmadd_pd(b0,_mm256_loadu_pd(a0+i),xi);
+    xi = _mm256_fmadd_pd(b1,_mm256_loadu_pd(a1+i),xi);
+    xi = _mm256_fmadd_pd(b2,_mm256_loadu_pd(a2+i),xi);
+    xi = _mm256_fmadd_pd(b3,_mm256_loadu_pd(a3+i),xi);
+    _mm256_storeu_pd(x+i,xi);
+  }
+  for(;i<n;i++)
+    x[i] += b[0]*a0[i] + b[1]*a1[i] + b[2]*a2[i] + b[3]*a3[i];
+}
+
+#endif //FASTARRAY_AVX2
+
+#if FASTARRAY_NEON
+
+static void gemm_neon(int kc,const double* a,const double* b,double* C)
+{
+  float64x2_t c[MR][NR/2];
+  for(int i=0;i<MR;i++)
+    for(int j=0;j<NR/2;j++)
+      c[i][j] = vdupq_n_f64(0);
+  for(int k=0;k<kc;k++,a+=MR,b+=NR) {
+    float64x2_t b0=vld1q_f64(b),b1=vld1q_f64(b+2),b2=vld1q_f64(b+4),b3=vld1q_f64(b+6);
+    for(int i=0;i<MR;i++) {
+      float64x2_t ai = vdupq_n_f64(a[i]);
+      c[i][0] = vfmaq_f64(c[i][0],ai,b0);
+      c[i][1] = vfmaq_f64(c[i][1],ai,b1);
+      c[i][2] = vfmaq_f64(c[i][2],ai,b2);
+      c[i][3] = vfmaq_f64(c[i][3],ai,b3);
+    }
+  }
+  for(int i=0;i<MR;i++)
+    for(int j=0;j<NR/2;j++)
+      vst1q_f64(C+i*NR+j*2,c[i][j]);
+}
+
+static void dot4_neon(int n,const double* a,int lda,const double* b,double* res)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  float64x2_t s0=vdupq_n_f64(0),s1=vdupq_n_f64(0),s2=vdupq_n_f64(0),s3=vdupq_n_f64(0);
+  int j=0;
+  for(;j+2<=n;j+=2) {
+    float64x2_t bj = vld1q_f64(b+j);
+    s0 = vfmaq_f64(s0,vld1q_f64(a0+j),bj);
+    s1 = vfmaq_f64(s1,vld1q_f64(a1+j),bj);
+    s2 = vfmaq_f64(s2,vld1q_f64(a2+j),bj);
+    s3 = vfmaq_f64(s3,vld1q_f64(a3+j),bj);
+  }
+  double r0=vaddvq_f64(s0),r1=vaddvq_f64(s1),r2=vaddvq_f64(s2),r3=vaddvq_f64(s3);
+  for(;j<n;j++) {
+    r0 += a0[j]*b[j];
+    r1 += a1[j]*b[j];
+    r2 += a2[j]*b[j];
+    r3 += a3[j]*b[j];
+  }
+  res[0]=r0; res[1]=r1; res[2]=r2; res[3]=r3;
+}
+
+static void axpy4_neon(int n,const double* a,int lda,const double* b,double* x)
+{
+  const double* a0=a,*a1=a+lda,*a2=a+2*lda,*a3=a+3*lda;
+  float64x2_t b0=vdupq_n_f64(b[0]),b1=vdupq_n_f64(b[1]);
+  float64x2_t b2=vdupq_n_f64(b[2]),b3=vdupq_n_f64(b[3]);
+  int i=0;
+  for(;i+2<=n;i+=2) {
+    float64x2_t xi = vld1q_f64(x+i);
+    xi = vfmaq_f64(xi,b0,vld1q_f64(a0+i));
+    xi = vfmaq_f64(xi,b1,vld1q_f64(a1+i));
+    xi = vfmaq_f64(xi,b2,vld1q_f64(a2+i));
+    xi = vfmaq_f64(xi,b3,vld1q_f64(a3+i));
+    vst1q_f64(x+i,xi);
+  }
+  for(;i<n;i++)
+    x[i] += b[0]*a0[i] + b[1]*a1[i] + b[2]*a2[i] + b[3]*a3[i];
+}
+
+#endif //FASTARRAY_NEON
+
+//Picks the kernels for the processor this runs on
+static ArrayKernels SelectKernels()
+{
+  ArrayKernels k;
+  k.gemm = gemm_generic;
+  k.dot4 = dot4_generic;
+  k.axpy4 = axpy4_generic;
+#if FASTARRAY_AVX2
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    k.gemm = gemm_avx2;
+    k.dot4 = dot4_avx2;
+    k.axpy4 = axpy4_avx2;
+  }
+#endif
+#if FASTARRAY_NEON
+  k.gemm = gemm_neon;
+  k.dot4 = dot4_neon;
+  k.axpy4 = axpy4_neon;
+#endif
+  return k;
+}
+
+//Selected on first use, since matrices may be multiplied during static
+//initialization
+static const ArrayKernels& Kernels()
+{
+  static ArrayKernels kernels = SelectKernels();
+  return kernels;
+}
+
+const char* blocked_array_kernel_name()
+{
+  const ArrayKernels& k = Kernels();
+#if FASTARRAY_AVX2
+  if(k.gemm == gemm_avx2) return "avx2";
+#endif
+#if FASTARRAY_NEON
+  if(k.gemm == gemm_neon) return "neon";
+#endif
+  return "generic";
+}
+
+//Packs the mc x kc block of A into MR-row slivers, each stored column by
+//column and padded with zeros to MR rows
+static void PackA(const double* A,int ais,int ajs,int mc,int kc,double* Ap)
+{
+  for(int i=0;i<mc;i+=MR,A+=MR*ais) {
+    int mr = Min(MR,mc-i);
+    const double* Ak = A;
+    for(int k=0;k<kc;k++,Ak+=ajs,Ap+=MR) {
+      const double* Aik = Ak;
+      int r=0;
+      for(;r<mr;r++,Aik+=ais) Ap[r] = *Aik;
+      for(;r<MR;r++) Ap[r] = 0;
+    }
+  }
+}
+
+//Packs the kc x nc panel of B into NR-column slivers, each stored row by
+//row and padded with zeros to NR columns
+static void PackB(const double* B,int bis,int bjs,int kc,int nc,double* Bp)
+{
+  for(int j=0;j<nc;j+=NR,B+=NR*bjs) {
+    int nr = Min(NR,nc-j);
+    const double* Bk = B;
+    for(int k=0;k<kc;k++,Bk+=bis,Bp+=NR) {
+      const double* Bkj = Bk;
+      int c=0;
+      for(;c<nr;c++,Bkj+=bjs) Bp[c] = *Bkj;
+      for(;c<NR;c++) Bp[c] = 0;
+    }
+  }
+}
+
+void blocked_array2d_multiply(double* X,int xis,int xjs,
+                              const double* A,int ais,int ajs,
+                              const double* B,int bis,int bjs,
+                              int m,int n,int p,bool accumulate)
+{
+  if(m == 0 || p == 0) return;
+  if(n == 0) {
+    if(!accumulate) gen_array2d_fill(X,xis,xjs,0.0,m,p);
+    return;
+  }
+  const ArrayKernels& kernels = Kernels();
+  int kcmax = Min(KC,n);
+  std::vector<double> Apack(MR*kcmax*((Min(m,MC)+MR-1)/MR));
+  std::vector<double> Bpack(NR*kcmax*((Min(p,NC)+NR-1)/NR));
+  double C[MR*NR];
+  for(int jc=0;jc<p;jc+=NC) {
+    int nc = Min(NC,p-jc);
+    for(int pc=0;pc<n;pc+=KC) {
+      int kc = Min(KC,n-pc);
+      bool add = (accumulate || pc > 0);
+      PackB(B+pc*bis+jc*bjs,bis,bjs,kc,nc,&Bpack[0]);
+      for(int ic=0;ic<m;ic+=MC) {
+        int mc = Min(MC,m-ic);
+        PackA(A+ic*ais+pc*ajs,ais,ajs,mc,kc,&Apack[0]);
+        for(int jr=0;jr<nc;jr+=NR) {
+          int nr = Min(NR,nc-jr);
+          const double* Bp = &Bpack[jr*kc];
+          for(int ir=0;ir<mc;ir+=MR) {
+            int mr = Min(MR,mc-ir);
+            kernels.gemm(kc,&Apack[ir*kc],Bp,C);
+            double* Xij = X+(ic+ir)*xis+(jc+jr)*xjs;
+            for(int i=0;i<mr;i++,Xij+=xis) {
+              double* Xj = Xij;
+              const double* Ci = C+i*NR;
+              if(add)
+                for(int j=0;j<nr;j++,Xj+=xjs) *Xj += Ci[j];
+              else
+                for(int j=0;j<nr;j++,Xj+=xjs) *Xj = Ci[j];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void blocked_array2d_vector_multiply(double* x,int xs,
+                                     const double* A,int ais,int ajs,
+                                     const double* b,int bs,
+                                     int m,int n,bool accumulate)
+{
+  if(m == 0) return;
+  if(n == 0) {
+    if(!accumulate) gen_array_fill(x,xs,0.0,m);
+    return;
+  }
+  const ArrayKernels& kernels = Kernels();
+  if(ajs == 1) {
+    //rows are contiguous: dot products of 4 rows at a time with b
+    std::vector<double> bcopy;
+    if(bs != 1) {
+      bcopy.resize(n);
+      gen_array_equal(&bcopy[0],1,b,bs,n);
+      b = &bcopy[0];
+    }
+    double res[4];
+    int i=0;
+    for(;i+4<=m;i+=4,A+=4*ais) {
+      kernels.dot4(n,A,ais,b,res);
+      for(int r=0;r<4;r++,x+=xs) {
+        if(accumulate) *x += res[r];
+        else *x = res[r];
+      }
+    }
+    for(;i<m;i++,A+=ais,x+=xs) {
+      double s = gen_array_sum_product(A,1,b,1,n);
+      if(accumulate) *x += s;
+      else *x = s;
+    }
+  }
+  else if(ais == 1) {
+    //columns are contiguous: add 4 scaled columns at a time to x
+    std::vector<double> xcopy(m,0.0);
+    if(accumulate) gen_array_equal(&xcopy[0],1,x,xs,m);
+    double bj[4];
+    int j=0;
+    for(;j+4<=n;j+=4,A+=4*ajs) {
+      for(int c=0;c<4;c++) bj[c] = b[(j+c)*bs];
+      kernels.axpy4(m,A,ajs,bj,&xcopy[0]);
+    }
+    for(;j<n;j++,A+=ajs)
+      gen_array_madd(&xcopy[0],1,A,1,b[j*bs],m);
+    gen_array_equal(x,xs,&xcopy[0],1,m);
+  }
+  else {
+    if(accumulate) gen_array2d_vector_madd<double>(x,xs,A,ais,ajs,b,bs,m,n);
+    else gen_array2d_vector_multiply<double>(x,xs,A,ais,ajs,b,bs,m,n);
+  }
+}
+
+} //namespace Math
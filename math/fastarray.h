@@ -3,6 +3,12 @@
 
 #include <utils.h>
 
+/// Define FASTARRAY_SIMD to 0 to use only the portable kernels in the
+/// blocked matrix products of fastarray.cpp.
+#ifndef FASTARRAY_SIMD
+#define FASTARRAY_SIMD 1
+#endif
+
 namespace Math {
 
 template <class T>
@@ -674,6 +680,39 @@ inline void gen_array2d_multiply(T* X,int xis,int xjs,
   }
 }
 
+/// X = A*B (or X += A*B if accumulate is set) for doubles, with any
+/// strides.  Packs blocks of A and B to fit in the caches and computes
+/// the product in register tiles with AVX2 or NEON kernels, chosen at run
+/// time for the processor (see FASTARRAY_SIMD).  Defined in fastarray.cpp.
+void blocked_array2d_multiply(double* X,int xis,int xjs,
+                              const double* A,int ais,int ajs,
+                              const double* B,int bis,int bjs,
+                              int m,int n,int p,bool accumulate=false);
+
+/// x = A*b (or x += A*b if accumulate is set) for doubles.  Uses SIMD
+/// kernels when the rows or columns of A are contiguous.
+void blocked_array2d_vector_multiply(double* x,int xs,
+                                     const double* A,int ais,int ajs,
+                                     const double* b,int bs,
+                                     int m,int n,bool accumulate=false);
+
+/// Name of the kernels used by the blocked products: "avx2", "neon", or
+/// "generic"
+const char* blocked_array_kernel_name();
+
+//X = A*B for doubles.  Products with fewer than 6 rows or columns are
+//faster with the plain loop.
+inline void gen_array2d_multiply(double* X,int xis,int xjs,
+                                 const double* A,int ais,int ajs,
+                                 const double* B,int bis,int bjs,
+                                 int m,int n,int p)
+{
+  if(m >= 6 && p >= 6 && double(m)*double(n)*double(p) >= 512)
+    blocked_array2d_multiply(X,xis,xjs,A,ais,ajs,B,bis,bjs,m,n,p);
+  else
+    gen_array2d_multiply<double>(X,xis,xjs,A,ais,ajs,B,bis,bjs,m,n,p);
+}
+
 //X = A^t*B.  X is mxp, A is nxm, B is nxp
 template <class T>
 inline void gen_array2d_multiply_transposeA(T* X,int xis,int xjs,
@@ -711,6 +750,18 @@ inline void gen_array2d_vector_multiply(T* x,int xs,
     *x = gen_array_sum_product(A,ajs, b,bs, n);
 }
 
+//x = A*b for doubles
+inline void gen_array2d_vector_multiply(double* x,int xs,
+                                        const double* A,int ais,int ajs,
+                                        const double* b,int bs,
+                                        int m, int n)
+{
+  if(m >= 8 && n >= 8 && m*n >= 256)
+    blocked_array2d_vector_multiply(x,xs,A,ais,ajs,b,bs,m,n);
+  else
+    gen_array2d_vector_multiply<double>(x,xs,A,ais,ajs,b,bs,m,n);
+}
+
 //x = A^t*b
 template <class T>
 inline void gen_array2d_vector_multiply_transpose(T* x,int xs,
@@ -732,6 +783,18 @@ inline void gen_array2d_vector_madd(T* x,int xs,
     *x += gen_array_sum_product(A,ajs, b,bs, n);
 }
 
+//x += A*b for doubles
+inline void gen_array2d_vector_madd(double* x,int xs,
+                                    const double* A,int ais,int ajs,
+                                    const double* b,int bs,
+                                    int m, int n)
+{
+  if(m >= 8 && n >= 8 && m*n >= 256)
+    blocked_array2d_vector_multiply(x,xs,A,ais,ajs,b,bs,m,n,true);
+  else
+    gen_array2d_vector_madd<double>(x,xs,A,ais,ajs,b,bs,m,n);
+}
+
 //x += A^t*b
 template <class T>
 inline void gen_array2d_vector_madd_transpose(T* x,int xs,
@@ -68,9 +68,8 @@ Real Box3D::distanceSquared(const Point3D& pt,Point3D& out) const
   if(loc.x > dims.x) loc.x = dims.x;
   if(loc.y > dims.y) loc.y = dims.y;
   if(loc.z > dims.z) loc.z = dims.z;
-  Real norm2 = loc.normSquared();
   fromLocal(loc,out);
-  return norm2;
+  return out.distanceSquared(pt);
 }
 
 bool Box3D::intersects(const Box3D& b) const
@@ -1,11 +1,40 @@
 #include "AnyMotionPlanner.h"
 #include "OptimalMotionPlanner.h"
 #include "SBL.h"
+#include <utils/ThreadPool.h>
 
 #if HAVE_TINYXML
 #include <tinyxml.h>
 #endif
 
+//Rough estimates of the memory used by the planners' data structures, in
+//bytes.  The data held by the edge planners and the point location
+//indices isn't counted.
+
+size_t ConfigBytes(int n)
+{
+  //small configs are stored inside the Config object
+  if(n <= VECTOR_INLINE_CAPACITY) return sizeof(Config);
+  return sizeof(Config)+n*sizeof(Real);
+}
+
+size_t RoadmapBytes(const RoadmapPlanner::Roadmap& roadmap)
+{
+  size_t n = roadmap.nodes.size();
+  if(n == 0) return 0;
+  //each edge is in the edge data list, and in an adjacency map of both
+  //of its nodes
+  size_t edgeBytes = sizeof(SmartPointer<EdgePlanner>)+2*sizeof(void*) + 2*(sizeof(int)+5*sizeof(void*));
+  return n*(ConfigBytes(roadmap.nodes[0].n)+2*sizeof(int)) + roadmap.NumEdges()*edgeBytes;
+}
+
+size_t TreeBytes(const TreeRoadmapPlanner& planner)
+{
+  if(planner.milestones.empty()) return 0;
+  int n = planner.milestones[0]->x.n;
+  return planner.pointLocationNodes.size()*(sizeof(TreeRoadmapPlanner::Node)+(ConfigBytes(n)-sizeof(Config)));
+}
+
 class RoadmapPlannerInterface  : public MotionPlannerInterface
 {
  public:
@@ -37,7 +66,7 @@ class RoadmapPlannerInterface  : public MotionPlannerInterface
   }
   virtual int PlanMore() { 
     Config q;
-    prm.space->Sample(q);
+    prm.GenerateConfig(q);
     int n=prm.TestAndAddMilestone(q);
     if(n>=0) {
       ConnectHint(n);
@@ -45,12 +74,34 @@ class RoadmapPlannerInterface  : public MotionPlannerInterface
     numIters++;
     return n;
   }
+  virtual void PlanMore(int n) {
+    //Generate() connects by radius, across components, as ConnectHint
+    //does when knn is 0
+    if(prm.numThreads > 1 && knn == 0 && !ignoreConnectedComponents) {
+      int first = prm.roadmap.NumNodes();
+      prm.Generate(n,connectionThreshold);
+      if(!storeEdges) {
+	for(int i=first;i<prm.roadmap.NumNodes();i++) {
+	  RoadmapPlanner::Roadmap::Iterator e;
+	  for(prm.roadmap.Begin(i,e);!e.end();++e)
+	    *e = NULL;
+	}
+      }
+      numIters += n;
+      return;
+    }
+    MotionPlannerInterface::PlanMore(n);
+  }
   virtual int NumIterations() const { return numIters; }
   virtual int NumMilestones() const { return prm.roadmap.NumNodes(); }
   virtual int NumComponents() const { return prm.ccs.NumComponents(); }
   virtual bool IsConnected(int ma,int mb) const { return prm.AreConnected(ma,mb); }
   virtual void GetPath(int ma,int mb,MilestonePath& path) { prm.CreatePath(ma,mb,path); }
   virtual void GetRoadmap(RoadmapPlanner& roadmap) { roadmap = prm; }
+  virtual void GetStats(StatDatabase& stats) const {
+    prm.stats.Get(stats);
+    stats.AddValue("memory",RoadmapBytes(prm.roadmap));
+  }
 
   RoadmapPlanner prm;
   int knn;
@@ -105,6 +156,10 @@ class RRTInterface  : public MotionPlannerInterface
   virtual bool IsConnected(int ma,int mb) const { return rrt.milestones[ma]->connectedComponent == rrt.milestones[mb]->connectedComponent; }
   virtual void GetPath(int ma,int mb,MilestonePath& path) { rrt.CreatePath(rrt.milestones[ma],rrt.milestones[mb],path); }
   virtual void GetRoadmap(RoadmapPlanner& roadmap) { ::GetRoadmap(rrt,roadmap); }
+  virtual void GetStats(StatDatabase& stats) const {
+    rrt.stats.Get(stats);
+    stats.AddValue("memory",TreeBytes(rrt));
+  }
 
   RRTPlanner rrt;
   int numIters;
@@ -138,6 +193,10 @@ class BiRRTInterface  : public MotionPlannerInterface
     rrt.CreatePath(path);
   }
   virtual void GetRoadmap(RoadmapPlanner& roadmap) { ::GetRoadmap(rrt,roadmap); }
+  virtual void GetStats(StatDatabase& stats) const {
+    rrt.stats.Get(stats);
+    stats.AddValue("memory",TreeBytes(rrt));
+  }
 
   BidirectionalRRTPlanner rrt;
   int numIters;
@@ -208,6 +267,11 @@ class SBLInterface  : public MotionPlannerInterface
   virtual bool IsConnected(int ma,int mb) const { return sbl->IsDone(); }
   virtual void GetPath(int ma,int mb,MilestonePath& path) { sbl->CreatePath(path); if(ma == 1) ReversePath(path); }
   virtual void GetRoadmap(RoadmapPlanner& roadmap) { printf("TODO: get SBL roadmap\n"); }
+  virtual void GetStats(StatDatabase& stats) const {
+    sbl->stats.Get(stats);
+    if(qStart.n != 0)
+      stats.AddValue("memory",NumMilestones()*(sizeof(SBLTree::Node)+ConfigBytes(qStart.n)));
+  }
 
   SmartPointer<SBLPlanner> sbl;
   Config qStart,qGoal;
@@ -245,6 +309,13 @@ class SBLPRTInterface  : public MotionPlannerInterface
   virtual int NumComponents() const { return sblprt.ccs.NumComponents(); }
   virtual bool IsConnected(int ma,int mb) const { return sblprt.AreSeedsConnected(ma,mb); }
   virtual void GetPath(int ma,int mb,MilestonePath& path) { sblprt.CreatePath(ma,mb,path); }
+  virtual void GetStats(StatDatabase& stats) const {
+    sblprt.stats.Get(stats);
+    if(!sblprt.roadmap.nodes.empty()) {
+      int n = sblprt.roadmap.nodes[0]->root->n;
+      stats.AddValue("memory",NumMilestones()*(sizeof(SBLTree::Node)+ConfigBytes(n)));
+    }
+  }
 
   SBLPRT sblprt;
 };
@@ -289,11 +360,149 @@ class PRMStarInterface  : public MotionPlannerInterface
     planner.GetPath(path);
   }
   virtual void GetRoadmap(RoadmapPlanner& roadmap) { roadmap.roadmap = planner.roadmap; }
+  virtual void GetStats(StatDatabase& stats) const {
+    planner.stats.Get(stats);
+    //the shortest path tree holds a distance and a parent per node
+    stats.AddValue("memory",RoadmapBytes(planner.roadmap)+planner.spp.d.size()*(sizeof(Real)+sizeof(int)));
+  }
 
   PRMStarPlanner planner;
   Config qStart,qGoal;
 };
 
+//Replaces the edges of a path or roadmap with edges on space, so that they
+//don't refer to the clone of the planner that found them
+static void RebindEdges(CSpace* space,MilestonePath& path)
+{
+  for(size_t i=0;i<path.edges.size();i++)
+    path.edges[i] = space->LocalPlanner(path.edges[i]->Start(),path.edges[i]->Goal());
+}
+
+static void RebindEdges(CSpace* space,RoadmapPlanner::Roadmap& roadmap)
+{
+  for(list<SmartPointer<EdgePlanner> >::iterator i=roadmap.edgeData.begin();i!=roadmap.edgeData.end();i++)
+    if(*i) *i = space->LocalPlanner((*i)->Start(),(*i)->Goal());
+}
+
+//runs each planner for up to numIters iterations, until one of them
+//connects milestones 0 and 1
+class ORParallelRound : public ParallelForBody
+{
+ public:
+  ORParallelRound(ThreadPool& _pool,vector<MotionPlannerInterface*>& _planners,vector<int>& _iters,int _numIters,bool _checkSolved)
+    :pool(_pool),planners(_planners),iters(_iters),numIters(_numIters),checkSolved(_checkSolved),solved(-1)
+  {}
+  bool Solved() {
+    pool.Lock();
+    bool res = (solved >= 0);
+    pool.Unlock();
+    return res;
+  }
+  virtual void Run(int begin,int end,int thread) {
+    for(int i=begin;i<end;i++) {
+      for(int k=0;k<numIters;k++) {
+	if(Solved()) return;
+	planners[i]->PlanMore();
+	iters[i]++;
+	if(checkSolved && planners[i]->IsConnected(0,1)) {
+	  pool.Lock();
+	  if(solved < 0) solved = i;
+	  pool.Unlock();
+	  return;
+	}
+      }
+    }
+  }
+  ThreadPool& pool;
+  vector<MotionPlannerInterface*>& planners;
+  vector<int>& iters;
+  int numIters;
+  bool checkSolved;
+  //guarded by the pool's mutex
+  int solved;
+};
+
+/** @brief Runs several independent planners in parallel, each on its own
+ * clone of the space, until one of them solves the query.
+ *
+ * Milestones are added to every planner, so they must assign the same
+ * ids.  Each PlanMore() call runs up to iterationsPerRound iterations of
+ * each planner.  Queries are answered by the first planner to connect
+ * milestones 0 and 1, or by planner 0 before that.  The edges of the
+ * returned paths and roadmaps are on the caller's space, so they stay
+ * valid after the interface is destroyed.
+ */
+class ORParallelInterface : public MotionPlannerInterface
+{
+ public:
+  ORParallelInterface(CSpace* _space,const vector<MotionPlannerInterface*>& _planners,const vector<SmartPointer<CSpace> >& _spaces)
+    :space(_space),planners(_planners),spaces(_spaces),iters(_planners.size(),0),numMilestones(0),winner(-1),iterationsPerRound(10),pool((int)_planners.size())
+  {}
+  virtual ~ORParallelInterface() {
+    for(size_t i=0;i<planners.size();i++) delete planners[i];
+  }
+  MotionPlannerInterface* Best() const { return planners[winner >= 0 ? winner : 0]; }
+  virtual bool CanAddMilestone() const { return planners[0]->CanAddMilestone(); }
+  virtual int AddMilestone(const Config& q) {
+    int id = planners[0]->AddMilestone(q);
+    for(size_t i=1;i<planners.size();i++) {
+      int idi = planners[i]->AddMilestone(q);
+      if(idi != id) FatalError("ORParallelInterface: planners assigned different milestone ids");
+    }
+    if(id >= 0) numMilestones++;
+    return id;
+  }
+  virtual void GetMilestone(int i,Config& q) { Best()->GetMilestone(i,q); }
+  virtual int PlanMore() {
+    if(winner >= 0) return -1;
+    ORParallelRound round(pool,planners,iters,iterationsPerRound,numMilestones >= 2);
+    pool.ParallelFor((int)planners.size(),round,1);
+    if(round.solved >= 0) winner = round.solved;
+    return -1;
+  }
+  virtual int NumIterations() const {
+    int n=0;
+    for(size_t i=0;i<iters.size();i++) n += iters[i];
+    return n;
+  }
+  virtual void GetThreadIterations(vector<int>& _iters) const { _iters = iters; }
+  virtual int NumMilestones() const { return Best()->NumMilestones(); }
+  virtual int NumComponents() const { return Best()->NumComponents(); }
+  virtual bool IsConnected(int ma,int mb) const {
+    if(winner >= 0) return planners[winner]->IsConnected(ma,mb);
+    for(size_t i=0;i<planners.size();i++)
+      if(planners[i]->IsConnected(ma,mb)) return true;
+    return false;
+  }
+  virtual void GetPath(int ma,int mb,MilestonePath& path) {
+    for(size_t i=0;i<planners.size();i++)
+      if(planners[i]->IsConnected(ma,mb)) {
+	planners[i]->GetPath(ma,mb,path);
+	if(i > 0) RebindEdges(space,path);
+	return;
+      }
+  }
+  virtual void GetRoadmap(RoadmapPlanner& roadmap) {
+    Best()->GetRoadmap(roadmap);
+    if(winner > 0) RebindEdges(space,roadmap.roadmap);
+  }
+  virtual void GetStats(StatDatabase& stats) const {
+    //counts add up, and each planner adds one sample to the times and
+    //memory
+    for(size_t i=0;i<planners.size();i++) planners[i]->GetStats(stats);
+  }
+
+  CSpace* space;
+  vector<MotionPlannerInterface*> planners;
+  //the clones used by planners 1,...
+  vector<SmartPointer<CSpace> > spaces;
+  vector<int> iters;
+  int numMilestones;
+  int winner;
+  int iterationsPerRound;
+  ThreadPool pool;
+};
+
 
 MotionPlannerFactory::MotionPlannerFactory()
   :type(Any),
@@ -303,11 +512,31 @@ MotionPlannerFactory::MotionPlannerFactory()
    perturbationRadius(0.1),perturbationIters(5),
    bidirectional(true),
    useGrid(true),gridResolution(0.1),randomizeFrequency(50),
-   storeEdges(false)
+   storeEdges(false),numThreads(1)
 {}
 
 MotionPlannerInterface* MotionPlannerFactory::Create(CSpace* space)
 {
+  if(numThreads > 1 && (type == Any || type == RRT || type == SBL || type == SBLPRT)) {
+    vector<SmartPointer<CSpace> > spaces(numThreads);
+    for(int i=1;i<numThreads;i++) {
+      spaces[i] = space->Clone();
+      if(!spaces[i]) {
+	spaces.resize(0);
+	break;
+      }
+    }
+    if(!spaces.empty()) {
+      MotionPlannerFactory single(*this);
+      single.numThreads = 1;
+      vector<MotionPlannerInterface*> planners(numThreads);
+      planners[0] = single.Create(space);
+      for(int i=1;i<numThreads;i++)
+	planners[i] = single.Create(spaces[i]);
+      return new ORParallelInterface(space,planners,spaces);
+    }
+    fprintf(stderr,"MotionPlannerFactory: space can't be cloned, planning on a single thread\n");
+  }
   switch(type) {
   case PRM:
     {
@@ -316,6 +545,7 @@ MotionPlannerInterface* MotionPlannerFactory::Create(CSpace* space)
     prm->connectionThreshold = connectionThreshold;
     prm->ignoreConnectedComponents = ignoreConnectedComponents;
     prm->storeEdges=storeEdges;
+    prm->prm.numThreads=numThreads;
     return prm;
     }
   case Any:
@@ -362,6 +592,7 @@ MotionPlannerInterface* MotionPlannerFactory::Create(CSpace* space)
       PRMStarInterface* prm = new PRMStarInterface(space);
       prm->planner.lazy = true;
       prm->planner.connectionThreshold = connectionThreshold;
+      prm->planner.numCheckThreads = numThreads;
       return prm;
     }
   default:
@@ -414,6 +645,7 @@ bool MotionPlannerFactory::Load(TiXmlElement* e)
   e->QueryValueAttribute("useGrid",&useGrid);
   e->QueryValueAttribute("gridResolution",&gridResolution);
   e->QueryValueAttribute("randomizeFrequency",&randomizeFrequency);
+  e->QueryValueAttribute("numThreads",&numThreads);
   return true;
 #else
   return false;
@@ -2,6 +2,7 @@
 #define ANY_MOTION_PLANNER_H
 
 #include "MotionPlanner.h"
+#include <utils/StatCollector.h>
 
 class TiXmlElement;
 
@@ -28,6 +29,8 @@ class MotionPlannerInterface
   virtual void PlanMore(int numIters) { for(int i=0;i<numIters;i++) PlanMore(); }
   ///Returns the number of elaped planning units
   virtual int NumIterations() const=0;
+  ///Returns the number of planning units performed by each thread
+  virtual void GetThreadIterations(std::vector<int>& iters) const { iters.assign(1,NumIterations()); }
   ///Returns the number of milestones stored by the planner
   virtual int NumMilestones() const=0;
   ///Returns the number of connected components stored by the planner
@@ -56,12 +59,30 @@ class MotionPlannerInterface
   virtual void GetPath(int ma,int mb,MilestonePath& path)=0;
   ///Returns a full-blown roadmap representation of the roadmap
   virtual void GetRoadmap(RoadmapPlanner& roadmap) {}
+  ///Adds the planner's performance statistics to stats.  The number of
+  ///samples, feasibility tests, edge checks, nearest neighbor queries and
+  ///graph searches is stored in the count of the items "sample",
+  ///"feasibility", "edgeCheck", "nearestNeighbor", and "graphSearch",
+  ///and their cumulative time in seconds in the value of the item's
+  ///"time" child, e.g., "nearestNeighbor:time" (see PlannerStats).  The
+  ///value of "memory" is an estimate of the bytes used by the planner's
+  ///data structures.  Planners may add further items.
+  virtual void GetStats(StatDatabase& stats) const {}
 };
 
 /** @brief A motion planner creator.
  * 
  * The planner type can be left as Any, in which a default planner will be
  * used. Otherwise, a given planner type can be designated.
+ *
+ * If numThreads > 1, the tree-based planners (RRT, SBL, and SBLPRT) are
+ * run OR-parallel: numThreads independent planners, each on its own
+ * clone of the space (see CSpace::Clone()), race each other and the first
+ * to connect milestones 0 and 1 wins.  If the space can't be cloned, a
+ * single planner is created.  Lazy PRM* instead checks the edges of its
+ * candidate paths on numThreads threads, also on clones of the space.
+ * PRM with knn = 0 generates the samples of each PlanMore(numIters) call
+ * in parallel (see RoadmapPlanner::Generate()).
  */
 class MotionPlannerFactory
 {
@@ -85,6 +106,7 @@ class MotionPlannerFactory
   Real gridResolution;     //for SBL
   int randomizeFrequency;  //for SBL
   bool storeEdges;         //if local planner data is stored during planning
+  int numThreads;          //for PRM,LazyPRM*,RRT,SBL,SBLPRT, number of threads
 };
 
 
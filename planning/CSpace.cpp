@@ -2,6 +2,13 @@
 #include <math/random.h>
 using namespace std;
 
+int CSpace::IsFeasibleBatch(const vector<Config>& x)
+{
+  for(size_t i=0;i<x.size();i++)
+    if(!IsFeasible(x[i])) return (int)i;
+  return -1;
+}
+
 void CSpace::SampleNeighborhood(const Config& c,Real r,Config& x)
 {
   x.resize(c.n);
@@ -3,6 +3,8 @@
 
 #include <math/vector.h>
 #include <math/metric.h>
+#include <vector>
+#include <typeinfo>
 using namespace Math;
 typedef Vector Config;
 
@@ -10,14 +12,31 @@ class EdgePlanner;
 
 /** @ingroup MotionPlanning
  * @brief Motion planning configuration space base class.
+ *
+ * A CSpace may keep mutable state (e.g., a robot's configuration or
+ * collision queries), so a single instance must not be used from multiple
+ * threads at once.  Spaces that support multithreaded planning override
+ * Clone() to return an independent instance for each thread.
  */
 class CSpace
 {
 public:
   virtual ~CSpace() {}
+  ///Returns a new instance of this space that may be used concurrently
+  ///with this one, or NULL if not supported (the default).  The caller
+  ///owns the result.  Clones must give the same answers as the original,
+  ///so a subclass that overrides other methods must also override Clone()
+  ///(see CloneExact()).
+  virtual CSpace* Clone() const { return NULL; }
   virtual void Sample(Config& x)=0;
   virtual void SampleNeighborhood(const Config& c,Real r,Config& x);
   virtual bool IsFeasible(const Config&)=0;
+  ///Returns the index of the first infeasible configuration in x, or -1
+  ///if all are feasible.  Edge planners call this with blocks of
+  ///configurations along a path, so spaces that can share work between
+  ///the checks (forward kinematics, collision setup) may override it.
+  ///The default calls IsFeasible() on each in order.
+  virtual int IsFeasibleBatch(const std::vector<Config>& x);
   virtual EdgePlanner* LocalPlanner(const Config& a,const Config& b) =0;
 
   ///optionally overrideable (default uses euclidean space)
@@ -29,4 +48,18 @@ public:
   virtual Real ObstacleDistance(const Config& a) { return Inf; }
 };
 
+/** @brief Helper for CSpace::Clone(): returns a copy of space if its type
+ * is exactly T, or NULL if it is a subclass of T.
+ *
+ * A copy of a subclass made by T's copy constructor would lose the
+ * subclass's overrides, so subclasses must override Clone() themselves
+ * to be cloned.
+ */
+template <class T>
+CSpace* CloneExact(const T* space)
+{
+  if(typeid(*space) != typeid(T)) return NULL;
+  return new T(*space);
+}
+
 #endif
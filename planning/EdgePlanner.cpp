@@ -15,6 +15,40 @@ PiggybackEdgePlanner::PiggybackEdgePlanner(CSpace* _space,const Config& _a,const
   :a(_a),b(_b),space(_space),e(_e)
 {}
 
+LazyEdgePlanner::LazyEdgePlanner(const SmartPointer<EdgePlanner>& _e)
+  :e(_e),checked(false),visible(false)
+{}
+
+bool LazyEdgePlanner::IsVisible()
+{
+  if(!checked) SetChecked(e->IsVisible());
+  return visible;
+}
+
+EdgePlanner* LazyEdgePlanner::Copy() const
+{
+  LazyEdgePlanner* c = new LazyEdgePlanner(e->Copy());
+  c->checked = checked;
+  c->visible = visible;
+  return c;
+}
+
+EdgePlanner* LazyEdgePlanner::ReverseCopy() const
+{
+  LazyEdgePlanner* c = new LazyEdgePlanner(e->ReverseCopy());
+  c->checked = checked;
+  c->visible = visible;
+  return c;
+}
+
+void LazyEdgePlanner::SetChecked(bool _visible)
+{
+  checked = true;
+  visible = _visible;
+}
+
+const int StraightLineEpsilonPlanner::batchSize;
+
 StraightLineEpsilonPlanner::StraightLineEpsilonPlanner(CSpace* _space,const Config& _a,const Config& _b,Real _epsilon)
   :a(_a),b(_b),space(_space),epsilon(_epsilon)
 {
@@ -28,21 +62,33 @@ Real Log2(Real r) { return Log(r)*Log2e; }
 
 bool StraightLineEpsilonPlanner::IsVisible()
 {
+  if(foundInfeasible) return false;
+  vector<Config> batch;
   while(dist > epsilon) {
-    depth++;
-    segs *= 2;
-    dist *= Half;
-    Real du = One / (Real)segs;
-    Real u = du;
-    for(int k=1;k<segs;k+=2,u+=du+du) {
-      space->Interpolate(a,b,u,m);
-      if(!space->IsFeasible(m)) {
-	foundInfeasible = true;
-	return false;
-      }
+    if(!CheckLevel(batch)) {
+      foundInfeasible = true;
+      return false;
     }
   }
-  return !foundInfeasible;
+  return true;
+}
+
+bool StraightLineEpsilonPlanner::CheckLevel(vector<Config>& batch)
+{
+  depth++;
+  segs *= 2;
+  dist *= Half;
+  Real du = One / (Real)segs;
+  Real u = du;
+  int k=1;
+  while(k < segs) {
+    int n = Min(batchSize,(segs-k+1)/2);
+    batch.resize(n);
+    for(int i=0;i<n;i++,k+=2,u+=du+du)
+      space->Interpolate(a,b,u,batch[i]);
+    if(space->IsFeasibleBatch(batch) >= 0) return false;
+  }
+  return true;
 }
 
 void StraightLineEpsilonPlanner::Eval(Real u,Config& x) const
@@ -74,18 +120,11 @@ Real StraightLineEpsilonPlanner::Priority() const { return dist; }
 
 bool StraightLineEpsilonPlanner::Plan() 
 {
-  depth++;
-  segs *= 2;
-  dist *= Half;
-  Real du = One / (Real)segs;
-  Real u = du;
-  for(int k=1;k<segs;k+=2,u+=du+du) {
-    space->Interpolate(a,b,u,m);
-    if(!space->IsFeasible(m)) {
-      dist = Inf;
-      foundInfeasible=true;
-      return false;
-    }
+  vector<Config> batch;
+  if(!CheckLevel(batch)) {
+    dist = Inf;
+    foundInfeasible=true;
+    return false;
   }
   return true;
 }
@@ -170,7 +209,7 @@ BisectionEpsilonEdgePlanner::BisectionEpsilonEdgePlanner(CSpace* _space,Real _ep
 bool BisectionEpsilonEdgePlanner::IsVisible()
 {
   while(!Done()) {
-    if(!Plan()) return false;
+    if(!PlanAll()) return false;
   }
   return true;
 }
@@ -310,6 +349,58 @@ bool BisectionEpsilonEdgePlanner::Plan(Config*& pre,Config*& post)
   return true;
 }
 
+bool BisectionEpsilonEdgePlanner::PlanAll()
+{
+  vector<Segment> pending;
+  while(!q.empty() && q.top().length > epsilon) {
+    pending.push_back(q.top());
+    q.pop();
+  }
+  vector<Config> batch(pending.size());
+  for(size_t i=0;i<pending.size();i++) {
+    list<Config>::iterator a=pending[i].prev, b=a; b++;
+    space->Midpoint(*a,*b,batch[i]);
+  }
+  int failed = space->IsFeasibleBatch(batch);
+  if(failed >= 0) {
+    x = batch[failed];
+    for(size_t i=0;i<pending.size();i++) {
+      if((int)i == failed) pending[i].length = Inf;
+      q.push(pending[i]);
+    }
+    return false;
+  }
+  for(size_t i=0;i<pending.size();i++) {
+    Segment s=pending[i];
+    list<Config>::iterator a=s.prev, b=a; b++;
+    //insert the split segments back in the queue
+    Real l1=space->Distance(*a,batch[i]);
+    Real l2=space->Distance(batch[i],*b);
+    if(l1 > 0.9*s.length || l2 > 0.9*s.length) {
+      printf("Midpoint exceeded 0.9 time segment distance: %g, %g > 0.9*%g\n",l1,l2,s.length);
+      for(size_t j=i+1;j<pending.size();j++) q.push(pending[j]);
+      s.length = Inf;
+      q.push(s);
+      return false;
+    }
+    list<Config>::iterator m=path.insert(b,batch[i]);
+    s.length = l1;
+    if(s.length > epsilon) q.push(s);
+    s.prev = m;
+    s.length = l2;
+    if(s.length > epsilon) q.push(s);
+  }
+  if(Real(q.size())*epsilon > 4.0*space->Distance(Start(),Goal())) {
+    Segment s=q.top(); q.pop();
+    s.length = Inf;
+    q.push(s);
+    cout<<"BisectionEpsilonEdgePlanner: Over 4 times as many iterations as needed, quitting."<<endl;
+    cout<<"Original length "<<space->Distance(Start(),Goal())<<", epsilon "<<epsilon<<endl;
+    return false;
+  }
+  return true;
+}
+
 bool BisectionEpsilonEdgePlanner::Done() const
 {
   return q.empty() || q.top().length <= epsilon;
@@ -105,9 +105,37 @@ public:
   SmartPointer<EdgePlanner> e;
 };
 
+/** @ingroup MotionPlanning
+ * @brief Edge planner that remembers whether another planner's edge has
+ * been checked, and the result.
+ *
+ * Used by lazy planners, whose edges may be checked in another space
+ * (e.g., a clone used by a worker thread); SetChecked() records the
+ * result of such a check.
+ */
+class LazyEdgePlanner : public EdgePlanner
+{
+public:
+  LazyEdgePlanner(const SmartPointer<EdgePlanner>& e);
+  virtual bool IsVisible();
+  virtual void Eval(Real u,Config& x) const { e->Eval(u,x); }
+  virtual const Config& Start() const { return e->Start(); }
+  virtual const Config& Goal() const { return e->Goal(); }
+  virtual CSpace* Space() const { return e->Space(); }
+  virtual EdgePlanner* Copy() const;
+  virtual EdgePlanner* ReverseCopy() const;
+  void SetChecked(bool visible);
+
+  SmartPointer<EdgePlanner> e;
+  bool checked,visible;
+};
+
 /** @ingroup MotionPlanning
  * @brief Straight-line edge planner that divides the segment until 
  * epsilon is reached.
+ *
+ * The configurations of each subdivision level are checked with
+ * CSpace::IsFeasibleBatch(), in blocks of at most batchSize.
  */
 class StraightLineEpsilonPlanner : public EdgePlanner
 {
@@ -129,12 +157,17 @@ public:
   CSpace* space;
   Real epsilon;
 
+  static const int batchSize = 16;
+
 private:
+  //checks the midpoints of the next subdivision level, using batch as
+  //scratch space
+  bool CheckLevel(std::vector<Config>& batch);
+
   bool foundInfeasible;
   Real dist;
   int depth;
   int segs;
-  Config m;
 };
 
 /** @ingroup MotionPlanning
@@ -165,6 +198,9 @@ public:
  *
  * Used in constrained configuration spaces where CSpace.Midpoint() doesn't
  * necessarily return a configuration whose distance is half of the endpoints.
+ *
+ * IsVisible() splits all the pending segments at once and checks their
+ * midpoints with CSpace::IsFeasibleBatch().
  */
 class BisectionEpsilonEdgePlanner : public EdgePlanner
 {
@@ -184,6 +220,8 @@ public:
   virtual bool Failed() const;
   //on failure, returns the segment last checked
   bool Plan(Config*& pre,Config*& post);
+  //splits all segments longer than epsilon
+  bool PlanAll();
 
   const std::list<Config>& GetPath() const { return path; }
   const Config& InfeasibleConfig() const { return x; }
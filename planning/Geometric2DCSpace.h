@@ -80,6 +80,7 @@ public:
   bool ObstacleOverlap(const Triangle2D& tri) const;
   bool ObstacleOverlap(const Segment2D& s,int obstacle) const;
 
+  virtual CSpace* Clone() const { return CloneExact(this); }
   virtual void Sample(Config& x);
   virtual void SampleNeighborhood(const Config& c,Real r,Config& x);
   virtual int NumObstacles();
@@ -143,6 +143,18 @@ bool GivenPathEdgePlanner::Failed() const
 
 
 
+void KinodynamicCSpace::BiasedSampleControl(const State& x,const State& xGoal,ControlInput& u)
+{
+  if(controlSampler) controlSampler->ChoiceBiasedSampleControl(x,xGoal,u,10);
+  else ChoiceBiasedSampleControl(x,xGoal,u,10);
+}
+
+void KinodynamicCSpace::BiasedSampleReverseControl(const State& x1,const State& xDest,ControlInput& u)
+{
+  if(controlSampler) controlSampler->ChoiceBiasedSampleReverseControl(x1,xDest,u,10);
+  else ChoiceBiasedSampleReverseControl(x1,xDest,u,10);
+}
+
 void KinodynamicCSpace::ChoiceBiasedSampleControl(const State& x,const State& xGoal,ControlInput& u,int numSamples)
 {
   Real closest=Inf;
@@ -192,6 +204,96 @@ void KinodynamicCSpace::ChoiceBiasedSampleReverseControl(const State& x,const St
   }
 }
 
+//simulates a batch of controls, forward or in reverse, and records the
+//distance from the end of each trace to xDest
+struct ControlPropagationBatch : public ParallelForBody
+{
+  ControlPropagationBatch(const vector<KinodynamicCSpace*>& _spaces,const State& _x,const State& _xDest,const vector<ControlInput>& _controls,bool _reverse)
+    :spaces(_spaces),x(_x),xDest(_xDest),controls(_controls),reverse(_reverse),distances(_controls.size())
+  {}
+  virtual void Run(int begin,int end,int thread) {
+    KinodynamicCSpace* space = spaces[thread];
+    vector<State> xtrace;
+    State x2;
+    for(int i=begin;i<end;i++) {
+      if(reverse) {
+	xtrace.resize(0);
+	bool res=space->ReverseSimulate(x,controls[i],xtrace);
+	Assert(res==true);
+	Assert(!xtrace.empty());
+	distances[i] = space->Distance(xDest,xtrace.front());
+      }
+      else {
+	space->SimulateEndpoint(x,controls[i],x2);
+	distances[i] = space->Distance(xDest,x2);
+      }
+    }
+  }
+  const vector<KinodynamicCSpace*>& spaces;
+  const State& x;
+  const State& xDest;
+  const vector<ControlInput>& controls;
+  bool reverse;
+  vector<Real> distances;
+};
+
+ParallelControlSampler::ParallelControlSampler(KinodynamicCSpace* _space,int numThreads)
+  :space(_space),spaces(1,_space),pool(numThreads)
+{
+  for(int t=1;t<numThreads;t++) {
+    CSpace* clone = space->Clone();
+    KinodynamicCSpace* kclone = dynamic_cast<KinodynamicCSpace*>(clone);
+    if(!kclone) {
+      delete clone;
+      spaces.resize(1);
+      clones.clear();
+      break;
+    }
+    clones.push_back(clone);
+    spaces.push_back(kclone);
+  }
+}
+
+void ParallelControlSampler::ChoiceBiasedSampleControl(const State& x,const State& xDest,ControlInput& u,int numSamples)
+{
+  if(spaces.size() == 1) {
+    space->ChoiceBiasedSampleControl(x,xDest,u,numSamples);
+    return;
+  }
+  vector<ControlInput> controls(numSamples);
+  for(int i=0;i<numSamples;i++)
+    space->SampleControl(x,controls[i]);
+  ControlPropagationBatch batch(spaces,x,xDest,controls,false);
+  pool.ParallelFor(numSamples,batch,1);
+  Real closest=Inf;
+  for(int i=0;i<numSamples;i++) {
+    if(batch.distances[i] < closest) {
+      closest = batch.distances[i];
+      u = controls[i];
+    }
+  }
+}
+
+void ParallelControlSampler::ChoiceBiasedSampleReverseControl(const State& x1,const State& xDest,ControlInput& u,int numSamples)
+{
+  if(spaces.size() == 1) {
+    space->ChoiceBiasedSampleReverseControl(x1,xDest,u,numSamples);
+    return;
+  }
+  vector<ControlInput> controls(numSamples);
+  for(int i=0;i<numSamples;i++)
+    space->SampleReverseControl(x1,controls[i]);
+  ControlPropagationBatch batch(spaces,x1,xDest,controls,true);
+  pool.ParallelFor(numSamples,batch,1);
+  Real closest=Inf;
+  for(int i=0;i<numSamples;i++) {
+    if(batch.distances[i] < closest) {
+      closest = batch.distances[i];
+      u = controls[i];
+    }
+  }
+}
+
 bool KinodynamicCSpace::NextState(const State& x0,const ControlInput& u,State& x)
 {
   vector<State> p;
@@ -4,6 +4,8 @@
 #include "CSpace.h"
 #include "EdgePlanner.h"
 #include <errors.h>
+#include <utils/SmartPointer.h>
+#include <utils/ThreadPool.h>
 #include <queue>
 typedef Vector State;
 typedef Vector ControlInput;
@@ -81,9 +83,12 @@ class GivenPathEdgePlanner : public EdgePlanner
  * u = [dt, v], and g = g(x,v).  This allows some flexibility in choosing the
  * time step during sampling.
  */
+class ParallelControlSampler;
+
 class KinodynamicCSpace : public CSpace
 {
 public:
+  KinodynamicCSpace() : controlSampler(NULL) {}
   virtual EdgePlanner* LocalPlanner(const Config& a,const Config& b) { FatalError("Visibility not checked using LocalPlanner for kinodynamic planning"); return NULL; }
 
   ///Executes the simulation function f(x0,u) and records its trace in p.
@@ -108,8 +113,9 @@ public:
   virtual void SampleControl(const State& x,ControlInput& u)=0;
 
   ///Pick control input u that, starting from x, is expected to get closer
-  ///to xGoal than a random u
-  virtual void BiasedSampleControl(const State& x,const State& xGoal,ControlInput& u) { ChoiceBiasedSampleControl(x,xGoal,u,10); }
+  ///to xGoal than a random u.  The default picks the best of 10 random
+  ///controls, simulated in parallel if controlSampler is set.
+  virtual void BiasedSampleControl(const State& x,const State& xGoal,ControlInput& u);
 
   ///Calculate the control input that reaches xGoal from x, return true if
   ///successful.  Required for bidirectional planning.
@@ -133,8 +139,8 @@ public:
   virtual void SampleReverseControl(const State& x,ControlInput& u) { SampleControl(x,u); }
 
   ///Pick control input u that, reverse-simulating from x1 will get
-  ///closer to xStart
-  virtual void BiasedSampleReverseControl(const State& x1,const State& xDest,ControlInput& u) { ChoiceBiasedSampleReverseControl(x1,xDest,u,10); }
+  ///closer to xStart.  The default is like that of BiasedSampleControl().
+  virtual void BiasedSampleReverseControl(const State& x1,const State& xDest,ControlInput& u);
 
   ///Simple implementation of BiasedSampleControl(). numSamples controls
   ///are chosen uniformly at random, and the best one is picked
@@ -153,6 +159,35 @@ public:
   ///to the initial state and returns true.
   ///(implementation calls ReverseSimulate() and  TrajectoryChecker()->IsVisible())
   bool PreviousState(const State& x1,const ControlInput& u,State& x0);
+
+  ///Set by the kinodynamic planners with numThreads > 1 while they call
+  ///BiasedSampleControl() or BiasedSampleReverseControl(), so the default
+  ///implementations simulate their candidates on the sampler's threads
+  ParallelControlSampler* controlSampler;
+};
+
+/** @brief Parallel versions of KinodynamicCSpace::ChoiceBiasedSampleControl
+ * and ChoiceBiasedSampleReverseControl.
+ *
+ * The candidate controls are sampled in order on the calling thread, and
+ * then simulated on numThreads threads, each using its own clone of the
+ * space (see CSpace::Clone()).  The closest candidate is picked, the
+ * first one on ties, so the result is the same as that of the serial
+ * version given the same random seed.  If the space can't be cloned, the
+ * serial versions are used.
+ */
+class ParallelControlSampler
+{
+ public:
+  ParallelControlSampler(KinodynamicCSpace* space,int numThreads);
+  void ChoiceBiasedSampleControl(const State& x,const State& xDest,ControlInput& u,int numSamples);
+  void ChoiceBiasedSampleReverseControl(const State& x1,const State& xDest,ControlInput& u,int numSamples);
+
+  KinodynamicCSpace* space;
+  ///spaces[t] is the space used by thread t.  spaces[0] is space itself
+  std::vector<KinodynamicCSpace*> spaces;
+  std::vector<SmartPointer<CSpace> > clones;
+  ThreadPool pool;
 };
 
 /** @brief Implements a simulation function by integrating forward dynamics.
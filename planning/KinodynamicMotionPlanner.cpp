@@ -60,7 +60,7 @@ struct VectorizeCallback : public Node::Callback
 
 
 KinodynamicTree::KinodynamicTree(KinodynamicCSpace* s)
-  :space(s),root(NULL)
+  :space(s),root(NULL),pointLocation(new GNATPointLocation(s))
 {
 }
 
@@ -72,14 +72,17 @@ KinodynamicTree::~KinodynamicTree()
 void KinodynamicTree::Init(const State& initialState)
 {
   Clear();
-  root = new Node(initialState);
+  root = new(&nodePool) Node(initialState);
   index.push_back(root);
+  pointLocation->Add(0,*root);
 }
 
 void KinodynamicTree::Clear()
 {
   index.clear();
+  pointLocation->Clear();
   SafeDelete(root);
+  nodePool.Clear();
 }
 
 
@@ -87,9 +90,10 @@ Node* KinodynamicTree::AddMilestone(Node* parent, const ControlInput& u,const St
 {
   FatalError("AddMilestone(parent,u,x) deprecated");
 
-  Node* c=parent->addChild(x);
+  Node* c=parent->addChild(new(&nodePool) Node(x));
   c->edgeFromParent().u = u;
   c->edgeFromParent().e = NULL;
+  pointLocation->Add((int)index.size(),*c);
   index.push_back(c);
   return c;
 }
@@ -98,15 +102,16 @@ Node* KinodynamicTree::AddMilestone(Node* parent,const ControlInput& u,const vec
 {
   Node* c;
   if(e->Start() == *parent) {
-    c=parent->addChild(e->Goal());
+    c=parent->addChild(new(&nodePool) Node(e->Goal()));
   }
   else {
     Assert(e->Goal() == *parent);
-    c=parent->addChild(e->Start());
+    c=parent->addChild(new(&nodePool) Node(e->Start()));
   }
   c->edgeFromParent().u = u;
   c->edgeFromParent().path = path;
   c->edgeFromParent().e = e;
+  pointLocation->Add((int)index.size(),*c);
   index.push_back(c);
   return c;
 }
@@ -126,28 +131,16 @@ void KinodynamicTree::Reroot(Node* n)
   FatalError("TODO: KinodynamicTree::Reroot");
 }
 
-Node* KinodynamicTree::FindClosest(const State& x) const
+Node* KinodynamicTree::FindClosest(const State& x)
 {
   EZCallTrace tr("KinodynamicTree::FindClosest()");
   
   if(!root) return NULL;
 
-  //iterating is faster
-  Node* closest=NULL;
-  double dclosest=Inf;
-  for(size_t i=0;i<index.size();i++) {
-    double d=space->Distance(x,*index[i]);
-    if(d < dclosest) {
-      dclosest=d;
-      closest=index[i];
-    }
-  }
-  return closest;
-    /*
-  ClosestMilestoneCallback callback(space,x);
-  root->DFS(callback);
-  return callback.closestMilestone;
-    */
+  Real d;
+  int id=pointLocation->NN(x,d);
+  if(id < 0) return NULL;
+  return index[id];
 }
 
 Node* KinodynamicTree::PickRandom() const
@@ -229,22 +222,54 @@ void KinodynamicTree::GetPath(Node* start,Node* goal,KinodynamicMilestonePath& p
 void KinodynamicTree::DeleteSubTree(Node* n)
 {
   EZCallTrace tr("KinodynamicTree::DeleteSubTree()");
+  //the deleted nodes, sorted for lookup
+  VectorizeCallback callback;
+  n->DFS(callback);
+  vector<Node*>& deleted = callback.nodes;
+  sort(deleted.begin(),deleted.end());
+
   if(n == root) root = NULL;
   Node* p=n->getParent();
   if(p) p->detachChild(n);
   delete n;  //this automatically deletes n and all children
 
-  VectorizeCallback callback;
-  if(root) root->DFS(callback);
-  index = callback.nodes;
+  //node ids are their positions in index, so the last node is moved into
+  //the place of each deleted one
+  for(int i=(int)index.size()-1;i>=0;i--) {
+    if(!binary_search(deleted.begin(),deleted.end(),index[i])) continue;
+    pointLocation->Remove(i);
+    int last=(int)index.size()-1;
+    if(i != last) {
+      index[i] = index[last];
+      pointLocation->Remove(last);
+      pointLocation->Add(i,*index[i]);
+    }
+    index.resize(last);
+  }
 }
 
 
 
 
 
+//Picks a control with the space's BiasedSampleControl(), or
+//BiasedSampleReverseControl() if reverse is true.  If numThreads > 1 and
+//the space can be cloned, the default implementations of those methods
+//simulate their candidate controls on the sampler's threads, while spaces
+//that override them are unaffected.
+static void PickBiasedControl(KinodynamicCSpace* space,int numThreads,SmartPointer<ParallelControlSampler>& sampler,const State& x,const State& xDest,ControlInput& u,bool reverse)
+{
+  if(numThreads > 1 && (!sampler || sampler->pool.NumThreads() != numThreads))
+    sampler = new ParallelControlSampler(space,numThreads);
+  bool parallel = (numThreads > 1 && sampler->spaces.size() > 1);
+  if(parallel) space->controlSampler = sampler;
+  if(reverse) space->BiasedSampleReverseControl(x,xDest,u);
+  else space->BiasedSampleControl(x,xDest,u);
+  if(parallel) space->controlSampler = NULL;
+}
+
 RRTKinodynamicPlanner::RRTKinodynamicPlanner(KinodynamicCSpace* s)
-  :space(s),goalSeekProbability(0.1),goalSet(NULL),tree(s),goalNode(NULL)
+  :space(s),goalSeekProbability(0.1),goalSet(NULL),tree(s),numThreads(1),goalNode(NULL)
 {}
 
 Node* RRTKinodynamicPlanner::Plan(int maxIters)
@@ -328,7 +353,7 @@ void RRTKinodynamicPlanner::CreatePath(KinodynamicMilestonePath& path) const
 }
 
 void RRTKinodynamicPlanner::PickControl(const State& x0, const State& xDest, ControlInput& u) {
-  space->BiasedSampleControl(x0,xDest,u);
+  PickBiasedControl(space,numThreads,controlSampler,x0,xDest,u,false);
 }
 
 
@@ -421,7 +446,7 @@ bool LazyRRTKinodynamicPlanner::CheckPath(Node* n)
 
 
 BidirectionalRRTKP::BidirectionalRRTKP(KinodynamicCSpace* s)
-  :space(s),start(s),goal(s),connectionTolerance(1.0)
+  :space(s),start(s),goal(s),connectionTolerance(1.0),numThreads(1)
 {
   bridge.nStart=NULL;
   bridge.nGoal=NULL;
@@ -527,11 +552,11 @@ bool BidirectionalRRTKP::ConnectTrees(Node* a,Node* b)
 }
 
 void BidirectionalRRTKP::PickControl(const State& x0, const State& xDest, ControlInput& u) {
-  space->BiasedSampleControl(x0,xDest,u);
+  PickBiasedControl(space,numThreads,controlSampler,x0,xDest,u,false);
 }
 
 void BidirectionalRRTKP::PickReverseControl(const State& x1, const State& xStart, ControlInput& u) {
-  space->BiasedSampleReverseControl(x1,xStart,u);
+  PickBiasedControl(space,numThreads,controlSampler,x1,xStart,u,true);
 }
 
 
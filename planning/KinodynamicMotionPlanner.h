@@ -3,6 +3,7 @@
 
 #include "KinodynamicCSpace.h"
 #include "KinodynamicPath.h"
+#include "PointLocation.h"
 #include <graph/Tree.h>
 #include <queue>
 typedef Vector State;
@@ -16,7 +17,10 @@ typedef Vector ControlInput;
  * x2=f(x1,u), the trace from x1->x2, and the edge planner for that trace.
  * This data can be retrieved using x2->getEdgeFromParent().
  *
- * Potential improvement can speed up point location using Kd trees.
+ * FindClosest() queries the pointLocation index, in which node index[i]
+ * is stored under id i.  By default it is a GNATPointLocation, which
+ * requires the space's Distance to be a metric; if it isn't, replace it
+ * with a NaivePointLocation before calling Init().
  */
 class KinodynamicTree
 {
@@ -37,7 +41,7 @@ public:
   void AddPath(Node* n0,const KinodynamicMilestonePath& path,std::vector<Node*>& res);
   void Reroot(Node* n);
   Node* PickRandom() const;
-  Node* FindClosest(const State& x) const;
+  Node* FindClosest(const State& x);
   Node* ApproximateRandomClosest(const State& x,int numIters) const;
   void DeleteSubTree(Node* n);
 
@@ -46,6 +50,9 @@ public:
   KinodynamicCSpace* space;
   Node* root;
   std::vector<Node*> index;
+  SmartPointer<PointLocationBase> pointLocation;
+  ///Nodes are allocated from this pool, which is released by Clear()
+  BlockPool nodePool;
 };
 
 
@@ -66,13 +73,20 @@ public:
   bool IsDone() const;
   void CreatePath(KinodynamicMilestonePath& path) const;
 
-  //default move uses space->BiasedSampleControl()
+  //default move uses space->BiasedSampleControl().  If numThreads > 1,
+  //its default implementation simulates the candidates in parallel
   virtual void PickControl(const State& x0, const State& xDest, ControlInput& u);
 
   KinodynamicCSpace* space;
   Real goalSeekProbability;
   CSpace* goalSet;
   KinodynamicTree tree;
+  ///If > 1, the candidate controls of the space's default
+  ///BiasedSampleControl() are propagated on this many threads, each with
+  ///its own clone of the space (default 1).  If the space can't be cloned
+  ///or overrides BiasedSampleControl(), controls are picked serially.
+  int numThreads;
+  SmartPointer<ParallelControlSampler> controlSampler;
 
   //temporary output
   Node* goalNode;
@@ -110,13 +124,20 @@ public:
   //bridge is filled out with the connection information.
   bool ConnectTrees(Node* nStart,Node* nGoal);
 
-  //default move uses space->BiasedSampleControl()
+  //default move uses space->BiasedSampleControl().  If numThreads > 1,
+  //its default implementation simulates the candidates in parallel
   virtual void PickControl(const State& x0, const State& xDest, ControlInput& u);
   virtual void PickReverseControl(const State& x1, const State& xDest, ControlInput& u);
 
   KinodynamicCSpace* space;
   KinodynamicTree start,goal;
   Real connectionTolerance;
+  ///If > 1, the candidate controls of the space's default
+  ///BiasedSampleControl() are propagated on this many threads, each with
+  ///its own clone of the space (default 1).  If the space can't be cloned
+  ///or overrides BiasedSampleControl(), controls are picked serially.
+  int numThreads;
+  SmartPointer<ParallelControlSampler> controlSampler;
 
   struct Bridge 
   {
@@ -14,11 +14,11 @@ const static double gSubdivideThreshold = 1e-3;
 //on some platforms, timing takes a non-negligible amount of time
 #define DO_TIMING 1
 
-inline Real WeightedCost(const Subset& s,const vector<Real>& weights)
+inline Real WeightedCost(const ExplanationSet& s,const vector<Real>& weights)
 {
+  if(weights.empty()) return Real(s.size());
   Real sum=0.0;
-  //for(set<int>::const_iterator i=s.items.begin();i!=s.items.end();i++) {
-  for(vector<int>::const_iterator i=s.items.begin();i!=s.items.end();i++) {
+  for(ExplanationSet::const_iterator i=s.begin();i!=s.end();i++) {
     sum += weights[*i];
     if(IsInf(sum)) return sum;
   }
@@ -26,14 +26,14 @@ inline Real WeightedCost(const Subset& s,const vector<Real>& weights)
 }
 
 
-Subset Violations(ExplicitCSpace* space,const Config& q)
+ExplanationSet Violations(ExplicitCSpace* space,const Config& q)
 {
   vector<bool> vis;
   space->CheckObstacles(q,vis);
-  return Subset(vis);
+  return ExplanationSet(vis);
 }
 
-Subset Violations(ExplicitCSpace* space,const Config& a,const Config& b)
+ExplanationSet Violations(ExplicitCSpace* space,const Config& a,const Config& b)
 {
   vector<bool> vis(space->NumObstacles());
   for(size_t i=0;i<vis.size();i++) {
@@ -41,7 +41,7 @@ Subset Violations(ExplicitCSpace* space,const Config& a,const Config& b)
     vis[i] = !e->IsVisible();
     delete e;
   }
-  return Subset(vis);
+  return ExplanationSet(vis);
 }
 
 
@@ -64,9 +64,9 @@ MCRPlanner::MCRPlanner(ExplicitCSpace* _space)
   bidirectional = false;
 }
 
-Real MCRPlanner::Cost(const Subset& s) const
+Real MCRPlanner::Cost(const ExplanationSet& s) const
 {
-  if(obstacleWeights.empty()) return Real(s.items.size());
+  if(obstacleWeights.empty()) return Real(s.size());
   return WeightedCost(s,obstacleWeights);
 }
 
@@ -115,7 +115,7 @@ void MCRPlanner::UpdatePathsGreedy()
 
   int m0=roadmap.nodes[0].mode;
   int mg=roadmap.nodes[1].mode;
-  Subset sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;;
+  ExplanationSet sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;;
   modeGraph.nodes[m0].pathCovers.resize(1);
   modeGraph.nodes[m0].pathCovers[0] = sgCover;
   Real c0=Cost(sgCover);
@@ -136,7 +136,7 @@ void MCRPlanner::UpdatePathsGreedy()
     for(modeGraph.Begin(m,e);!e.end();e++) {
       //compute propagated cost
       Mode& modet=modeGraph.nodes[e.target()];
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[0];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[0];
       Real cs=Cost(s);
       if(modet.minCost <= cs)
 	continue;
@@ -168,7 +168,7 @@ void MCRPlanner::UpdatePathsGreedy2(int nstart)
   int mg=roadmap.nodes[1].mode;
   if(nstart <= 0) {
     int m0=roadmap.nodes[0].mode;
-    Subset sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
+    ExplanationSet sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
     modeGraph.nodes[m0].pathCovers.resize(1);
     modeGraph.nodes[m0].pathCovers[0] = sgCover;
     Real c0=Cost(sgCover);
@@ -185,7 +185,7 @@ void MCRPlanner::UpdatePathsGreedy2(int nstart)
     for(modeGraph.Begin(m0,e);!e.end();e++) {
       Mode& modet = modeGraph.nodes[e.target()];
       if(modet.minCost >= mode0.minCost) continue;
-      Subset s = mode0.subset+modet.pathCovers[0];
+      ExplanationSet s = mode0.subset+modet.pathCovers[0];
       Real cs=Cost(s);
       if(cs < mode0.minCost) {
 	mode0.pathCovers[0] = s;
@@ -207,7 +207,7 @@ void MCRPlanner::UpdatePathsGreedy2(int nstart)
     for(modeGraph.Begin(m,e);!e.end();e++) {
       //compute propagated cost
       Mode& modet=modeGraph.nodes[e.target()];
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[0];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[0];
       Real cs=Cost(s);
 
       if(!modet.pathCovers.empty()) {
@@ -253,7 +253,7 @@ void MCRPlanner::UpdatePathsComplete()
 
   int m0=roadmap.nodes[0].mode;
   int mg=roadmap.nodes[1].mode;
-  Subset sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
+  ExplanationSet sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
   modeGraph.nodes[m0].pathCovers.resize(1);
   modeGraph.nodes[m0].pathCovers[0] = sgCover;
   q.insert(pair<int,int>(m0,0),Cost(sgCover));
@@ -277,7 +277,7 @@ void MCRPlanner::UpdatePathsComplete()
       if((int)modet.pathCovers.size() >= updatePathsMax)
 	continue;
 
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
 
       if(visited[e.target()] == 1) { //visited already, look to see if the mode contains a subset of s
 	bool skip=false;
@@ -344,7 +344,7 @@ void MCRPlanner::UpdatePathsComplete2(int nstart)
     for(size_t i=0;i<modeGraph.nodes.size();i++)
       modeGraph.nodes[i].pathCovers.resize(0);
     int m0=roadmap.nodes[0].mode;
-    Subset sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
+    ExplanationSet sgCover = modeGraph.nodes[m0].subset+modeGraph.nodes[mg].subset;
     modeGraph.nodes[m0].pathCovers.resize(1);
     modeGraph.nodes[m0].pathCovers[0] = sgCover;
     Real c0=Cost(sgCover);
@@ -362,7 +362,7 @@ void MCRPlanner::UpdatePathsComplete2(int nstart)
       Mode& modet = modeGraph.nodes[e.target()];
       if(modet.minCost > mode0.minCost) continue;
       for(size_t j=0;j<modet.pathCovers.size();j++) {
-	Subset s = mode0.subset+modet.pathCovers[j];
+	ExplanationSet s = mode0.subset+modet.pathCovers[j];
 	bool skip=false;
 	for(size_t i=0;i<mode0.pathCovers.size();i++) {
 	  if(s.is_subset(mode0.pathCovers[i])) {
@@ -402,7 +402,7 @@ void MCRPlanner::UpdatePathsComplete2(int nstart)
       if((int)modet.pathCovers.size() >= updatePathsMax)
 	continue;
 
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
 
       bool skip=false;
       vector<int> replace;
@@ -446,7 +446,7 @@ bool MCRPlanner::CanImproveConnectivity(const Mode& ma,const Mode& mb,Real maxEx
   if(&ma == &mb) return false;
   if(ma.pathCovers.empty() || mb.pathCovers.empty()) return true;
   for(size_t i=0;i<ma.pathCovers.size();i++) {
-    Subset next=(ma.pathCovers[i] + mb.subset);
+    ExplanationSet next=(ma.pathCovers[i] + mb.subset);
     Real cnext = Cost(next);
     if(cnext <= maxExplanationCost) {
       if(updatePathsComplete) {
@@ -461,7 +461,7 @@ bool MCRPlanner::CanImproveConnectivity(const Mode& ma,const Mode& mb,Real maxEx
     }
   }
   for(size_t i=0;i<mb.pathCovers.size();i++) {
-    Subset next=(mb.pathCovers[i] + ma.subset);
+    ExplanationSet next=(mb.pathCovers[i] + ma.subset);
     Real cnext = Cost(next);
     if(cnext <= maxExplanationCost) {
       if(updatePathsComplete) {
@@ -481,7 +481,7 @@ bool MCRPlanner::CanImproveConnectivity(const Mode& ma,const Mode& mb,Real maxEx
 
 //If there are more violations than the limit, return true.
 //Otherwise, return false and compute the subset of violations
-bool MCRPlanner::ExceedsCostLimit(const Config& q,Real limit,Subset& violations)
+bool MCRPlanner::ExceedsCostLimit(const Config& q,Real limit,ExplanationSet& violations)
 {
   int n=space->NumObstacles();
   /*
@@ -502,13 +502,13 @@ bool MCRPlanner::ExceedsCostLimit(const Config& q,Real limit,Subset& violations)
     else
       vis[i] = false;
   }
-  violations = Subset(vis);
+  violations = ExplanationSet(vis);
   return false;
 }
 
 //If there are more violations than the limit, return true.
 //Otherwise, return false and compute the subset of violations
-bool MCRPlanner::ExceedsCostLimit(const Config& a,const Config& b,Real limit,Subset& violations)
+bool MCRPlanner::ExceedsCostLimit(const Config& a,const Config& b,Real limit,ExplanationSet& violations)
 {
   int n=space->NumObstacles();
   /*
@@ -534,7 +534,7 @@ bool MCRPlanner::ExceedsCostLimit(const Config& a,const Config& b,Real limit,Sub
       if(vcount > limit) return true;
     }
   }
-  violations = Subset(vis);
+  violations = ExplanationSet(vis);
   return false;
 }
 
@@ -543,10 +543,10 @@ int MCRPlanner::AddNode(const Config& q,int parent)
 {
   vector<bool> subsetbits;
   space->CheckObstacles(q,subsetbits);
-  return AddNode(q,Subset(subsetbits),parent);
+  return AddNode(q,ExplanationSet(subsetbits),parent);
 }
 
-int MCRPlanner::AddNode(const Config& q,const Subset& subset,int parent)
+int MCRPlanner::AddNode(const Config& q,const ExplanationSet& subset,int parent)
 {
 #if DO_TIMING
   Timer timer;
@@ -559,7 +559,7 @@ int MCRPlanner::AddNode(const Config& q,const Subset& subset,int parent)
   //Sanity check?
   vector<bool> subsetbits;
   space->CheckObstacles(q,subsetbits);
-  assert(subset == Subset(subsetbits));
+  assert(subset == ExplanationSet(subsetbits));
   */
 
   if(parent < 0 || modeGraph.nodes[roadmap.nodes[parent].mode].subset != subset)  {
@@ -614,7 +614,7 @@ bool MCRPlanner::AddEdge(int i,int j,int depth)
   assert(j >= 0 && j < (int)roadmap.nodes.size());
   assert(!roadmap.HasEdge(i,j));
   numEdgeChecks++;
-  Subset ev=Violations(space,roadmap.nodes[i].q,roadmap.nodes[j].q);
+  ExplanationSet ev=Violations(space,roadmap.nodes[i].q,roadmap.nodes[j].q);
   int mi = roadmap.nodes[i].mode;
   int mj = roadmap.nodes[j].mode;
   assert(mi >= 0 && mi < (int)modeGraph.nodes.size());
@@ -640,7 +640,7 @@ bool WithinThreshold(const MCRPlanner::Mode& mode,Real maxExplanationCost)
   return mode.minCost <= maxExplanationCost;
 }
 
-bool WithinThreshold(const MCRPlanner::Mode& mode,const Subset& extra,Real maxExplanationCost,const vector<Real>& weights)
+bool WithinThreshold(const MCRPlanner::Mode& mode,const ExplanationSet& extra,Real maxExplanationCost,const vector<Real>& weights)
 {
   if(mode.minCost > maxExplanationCost) return false;
   for(size_t i=0;i<mode.pathCovers.size();i++) {
@@ -653,7 +653,7 @@ bool WithinThreshold(const MCRPlanner::Mode& mode,const Subset& extra,Real maxEx
 int MCRPlanner::AddEdge(int i,const Config& q,Real maxExplanationCost)
 {
   numEdgeChecks++;
-  Subset ev,qv;
+  ExplanationSet ev,qv;
   numConfigChecks++;
   if(ExceedsCostLimit(q,maxExplanationCost,qv))
     return -1;
@@ -665,7 +665,7 @@ int MCRPlanner::AddEdge(int i,const Config& q,Real maxExplanationCost)
     return -1;
   if(!WithinThreshold(modeGraph.nodes[mi],ev,maxExplanationCost,obstacleWeights)) 
     return -1;
-  const Subset& qiv = modeGraph.nodes[mi].subset;
+  const ExplanationSet& qiv = modeGraph.nodes[mi].subset;
   if(Cost((qiv + qv)) < Cost(ev)) {
     if(space->Distance(roadmap.nodes[i].q,q) < gSubdivideThreshold)
       return -1;
@@ -735,7 +735,7 @@ void MCRPlanner::AddEdgeRaw(int i,int j)
     */
     if(updatePathsComplete) {
       //do a proper update of the irreducible covers
-      vector<Subset> newCovers;
+      vector<ExplanationSet> newCovers;
       for(size_t p=0;p<ma.pathCovers.size();p++) {
 	bool subset = false;
 	bool equal = false;
@@ -851,12 +851,12 @@ void MCRPlanner::AddEdgeRaw(int i,int j)
 int MCRPlanner::ExtendToward(int i,const Config& qdest,Real maxExplorationCost)
 {
   int mi = roadmap.nodes[i].mode;
-  const Subset& ei = modeGraph.nodes[mi].subset;
+  const ExplanationSet& ei = modeGraph.nodes[mi].subset;
 
   assert(gMaxExtendTowardIters == 1);
 
   numConfigChecks++;
-  Subset qv,ev;
+  ExplanationSet qv,ev;
   if(ExceedsCostLimit(qdest,maxExplorationCost,qv))
     return -1;
   if(!WithinThreshold(modeGraph.nodes[mi],qv,maxExplorationCost,obstacleWeights)) 
@@ -1011,7 +1011,7 @@ void MCRPlanner::Expand(Real maxExplanationCost,vector<int>& newNodes)
   //attempt connections
   bool didRefine = false;
   newNodes.resize(0);
-  Subset qsubset;
+  ExplanationSet qsubset;
   Real minDist = Inf;
   size_t closestIndex = 0;
   for(size_t j=0;j<kclosest.size();j++) 
@@ -1026,7 +1026,7 @@ void MCRPlanner::Expand(Real maxExplanationCost,vector<int>& newNodes)
     numConfigChecks++;
     vector<bool> subsetbits;
     space->CheckObstacles(q,subsetbits);
-    qsubset = Subset(subsetbits);
+    qsubset = ExplanationSet(subsetbits);
     
     int nearmode = roadmap.nodes[kneighbors[closestIndex]].mode;
     if(WithinThreshold(modeGraph.nodes[nearmode],qsubset,maxExplanationCost,obstacleWeights)) { //if config itself violates too many constraints, we're not going to connect any nodes
@@ -1149,7 +1149,7 @@ void MCRPlanner::Expand2(Real maxExplanationCost,vector<int>& newNodes)
   //attempt connections
   bool didRefine = false;
   newNodes.resize(0);
-  Subset qsubset;
+  ExplanationSet qsubset;
   if(closest[0] < expandDistance) {
     numRefinementAttempts++;
     
@@ -1157,7 +1157,7 @@ void MCRPlanner::Expand2(Real maxExplanationCost,vector<int>& newNodes)
     numConfigChecks++;
     vector<bool> subsetbits;
     space->CheckObstacles(q,subsetbits);
-    qsubset = Subset(subsetbits);
+    qsubset = ExplanationSet(subsetbits);
 
     int nearmode = roadmap.nodes[neighbor[0]].mode;    
     if(WithinThreshold(modeGraph.nodes[nearmode],qsubset,maxExplanationCost,obstacleWeights)) { //if config itself violates too many constraints, we're not going to connect any nodes
@@ -1240,9 +1240,9 @@ void MCRPlanner::Expand2(Real maxExplanationCost,vector<int>& newNodes)
 	    printf("Added edge to goal!\n");
 	    printf("Cost to node %g\n",modeGraph.nodes[mode].minCost);
 	    printf("Cost to goal %g\n",modeGraph.nodes[gmode].minCost);
-	    Subset vn = Violations(space,roadmap.nodes[newNodes[i]].q);
-	    Subset vg = Violations(space,roadmap.nodes[1].q);
-	    Subset ve = Violations(space,roadmap.nodes[1].q,roadmap.nodes[newNodes[i]].q);
+	    ExplanationSet vn = Violations(space,roadmap.nodes[newNodes[i]].q);
+	    ExplanationSet vg = Violations(space,roadmap.nodes[1].q);
+	    ExplanationSet ve = Violations(space,roadmap.nodes[1].q,roadmap.nodes[newNodes[i]].q);
 	    cout<<"Vn "<<vn<<endl;
 	    cout<<"Vg "<<vg<<endl;
 	    cout<<"Ve "<<ve<<endl;
@@ -1278,17 +1278,17 @@ void MCRPlanner::Expand2(Real maxExplanationCost,vector<int>& newNodes)
   }
 }
 
-void MCRPlanner::Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,Subset& bestCover)
+void MCRPlanner::Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,ExplanationSet& bestCover)
 {
   Completion(0,0,1,bestCover);
 
-  Subset lowerCover;
+  ExplanationSet lowerCover;
   vector<bool> violations;
   numConfigChecks += 2;
   space->CheckObstacles(start,violations);
-  lowerCover=Subset(violations);
+  lowerCover=ExplanationSet(violations);
   space->CheckObstacles(goal,violations);
-  lowerCover=lowerCover+Subset(violations);
+  lowerCover=lowerCover+ExplanationSet(violations);
 
   Real lowerCost = Cost(lowerCover);
   Real bestCost = Cost(bestCover);
@@ -1407,7 +1407,7 @@ void UniformModeDFS(MCRPlanner* eep,int mode,int vertex,vector<bool>& marked,vec
   }
 }
 
-void MCRPlanner::BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G)
+void MCRPlanner::BuildCCGraph(Graph::UndirectedGraph<ExplanationSet,int>& G)
 {
   vector<int> nodeCCs(roadmap.nodes.size(),-1);
   vector<bool> marked(roadmap.nodes.size(),false);
@@ -1447,25 +1447,25 @@ void MCRPlanner::BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G)
 struct CoverageLimitedPathCallback: public Graph::PathIntCallback
 {
   MCRPlanner* planner;
-  const Subset& cover;
+  const ExplanationSet& cover;
 
-  CoverageLimitedPathCallback(MCRPlanner* _planner,const Subset& _cover,int _target=-1)
+  CoverageLimitedPathCallback(MCRPlanner* _planner,const ExplanationSet& _cover,int _target=-1)
     :PathIntCallback(_planner->roadmap.nodes.size(),_target),planner(_planner),cover(_cover)
   {}
 
   virtual bool ForwardEdge(int i,int j) {
     int modej = planner->roadmap.nodes[j].mode;
-    const Subset& subj = planner->modeGraph.nodes[modej].subset;
+    const ExplanationSet& subj = planner->modeGraph.nodes[modej].subset;
     return subj.is_subset(cover);
   }
 };
 
-bool MCRPlanner::CoveragePath(int s,int t,const Subset& cover,vector<int>& path,Subset& pathCover)
+bool MCRPlanner::CoveragePath(int s,int t,const ExplanationSet& cover,vector<int>& path,ExplanationSet& pathCover)
 {
   CoverageLimitedPathCallback callback(this,cover,t);
   roadmap._DFS(s,callback);
   if(Graph::GetAncestorPath(callback.parents,t,s,path)) {
-    pathCover = Subset();
+    pathCover = ExplanationSet();
     for(size_t i=0;i<path.size();i++)
       pathCover = pathCover + modeGraph.nodes[roadmap.nodes[path[i]].mode].subset;
     return true;
@@ -1479,7 +1479,7 @@ bool MCRPlanner::CoveragePath(int s,int t,const Subset& cover,vector<int>& path,
  */
 struct SubsetCost
 {
-  Subset subset;
+  ExplanationSet subset;
   Real pathCost;
   vector<Real>* weights;
 
@@ -1487,7 +1487,7 @@ struct SubsetCost
     :subset(maxItem),pathCost(cost),weights(_weights)
   {}
 
-  SubsetCost(const Subset& s,Real cost=0,vector<Real>* _weights=NULL)
+  SubsetCost(const ExplanationSet& s,Real cost=0,vector<Real>* _weights=NULL)
     :subset(s),pathCost(cost),weights(_weights)
   {}
 
@@ -1596,19 +1596,19 @@ struct GreedySubsetAStar : public GeneralizedAStar<int,SubsetCost>
 };
 
 
-struct OptimalSubsetAStar : public GeneralizedAStar<pair<int,Subset>,SubsetCost>
+struct OptimalSubsetAStar : public GeneralizedAStar<pair<int,ExplanationSet>,SubsetCost>
 {
-  typedef pair<int,Subset> State;
+  typedef pair<int,ExplanationSet> State;
   typedef GeneralizedAStar<State,SubsetCost>::Node Node;
   MCRPlanner* planner;
   int startNode,targetNode;
-  vector<vector<pair<Subset,Node*> > > visited;
+  vector<vector<pair<ExplanationSet,Node*> > > visited;
 
   OptimalSubsetAStar(MCRPlanner* _planner,int _start,int _target)
     :planner(_planner),startNode(_start),targetNode(_target)
   {
-    const Subset& m0=planner->modeGraph.nodes[planner->roadmap.nodes[startNode].mode].subset;
-    SetStart(pair<int,Subset>(_start,m0));
+    const ExplanationSet& m0=planner->modeGraph.nodes[planner->roadmap.nodes[startNode].mode].subset;
+    SetStart(pair<int,ExplanationSet>(_start,m0));
     root.g = SubsetCost(m0,0,&planner->obstacleWeights);
     root.f = root.g;
   }
@@ -1632,7 +1632,7 @@ struct OptimalSubsetAStar : public GeneralizedAStar<pair<int,Subset>,SubsetCost>
 	SubsetCost c(planner->space->NumObstacles(),dist,&planner->obstacleWeights);
 	cost.push_back(c);
       }
-      successors.push_back(pair<int,Subset>(e.target(),cost.back().subset+s.second));
+      successors.push_back(pair<int,ExplanationSet>(e.target(),cost.back().subset+s.second));
     }
   }
 
@@ -1644,7 +1644,7 @@ struct OptimalSubsetAStar : public GeneralizedAStar<pair<int,Subset>,SubsetCost>
 
   virtual void Visit(const State& s,Node* n)
   {
-    visited[s.first].push_back(pair<Subset,Node*>(s.second,n));
+    visited[s.first].push_back(pair<ExplanationSet,Node*>(s.second,n));
   }
 
   virtual Node* VisitedStateNode(const State& s)
@@ -1658,7 +1658,7 @@ struct OptimalSubsetAStar : public GeneralizedAStar<pair<int,Subset>,SubsetCost>
 };
 
 
-bool MCRPlanner::GreedyPath(int s,int t,vector<int>& path,Subset& pathCover)
+bool MCRPlanner::GreedyPath(int s,int t,vector<int>& path,ExplanationSet& pathCover)
 {
   GreedySubsetAStar astar(this,s,t);
   if(!astar.Search()) {
@@ -1679,7 +1679,7 @@ bool MCRPlanner::GreedyPath(int s,int t,vector<int>& path,Subset& pathCover)
 }
 
 
-bool MCRPlanner::OptimalPath(int s,int t,vector<int>& path,Subset& pathCover)
+bool MCRPlanner::OptimalPath(int s,int t,vector<int>& path,ExplanationSet& pathCover)
 {
   OptimalSubsetAStar astar(this,s,t);
   if(!astar.Search()) {
@@ -1699,7 +1699,7 @@ bool MCRPlanner::OptimalPath(int s,int t,vector<int>& path,Subset& pathCover)
   }
 }
 
-void MCRPlanner::Completion(int s,int node,int t,Subset& pathCover)
+void MCRPlanner::Completion(int s,int node,int t,ExplanationSet& pathCover)
 {
   GreedySubsetAStar astar(this,s,node);
   if(!astar.Search()) {
@@ -4,6 +4,21 @@
 #include "MotionPlanner.h"
 #include "ExplicitCSpace.h"
 #include <utils/Subset.h>
+#include <utils/BitSubset.h>
+
+/// Define MCR_BITSET_EXPLANATIONS to 0 to store the MCR planners'
+/// explanation sets as sorted vectors (Subset) rather than bit-vectors
+/// (BitSubset).  Bit-vectors are faster unless the number of obstacles is
+/// very large and explanations are sparse.
+#ifndef MCR_BITSET_EXPLANATIONS
+#define MCR_BITSET_EXPLANATIONS 1
+#endif
+
+#if MCR_BITSET_EXPLANATIONS
+typedef BitSubset ExplanationSet;
+#else
+typedef Subset ExplanationSet;
+#endif
 
 /** @brief A planner that minimizes the the number of violated constraints
  * using a RRT-like strategy.
@@ -18,7 +33,7 @@
  *   schedule.push_back(limit1);
  *     ...
  *   schedule.push_back(limitN);
- *   Subset cover;
+ *   ExplanationSet cover;
  *   vector<int> bestPlan;
  *   planner.Plan(0,schedule,bestPlan,cover);
  *
@@ -40,9 +55,9 @@ class MCRPlanner
   typedef Graph::UndirectedGraph<Milestone,Edge> Roadmap;
 
   struct Mode {
-    Subset subset;      //subset covered by this mode
+    ExplanationSet subset;      //subset covered by this mode
     std::vector<int> roadmapNodes;
-    std::vector<Subset> pathCovers;   //minimal covers leading from the start to this mode
+    std::vector<ExplanationSet> pathCovers;   //minimal covers leading from the start to this mode
     Real minCost;
   };
   struct Transition {
@@ -56,27 +71,27 @@ class MCRPlanner
   void Expand(Real maxExplanationCost,vector<int>& newNodes);
   void Expand2(Real maxExplanationCost,vector<int>& newNodes);
   ///Performs bottom-up planning according to a given limit expansion schedule
-  void Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,Subset& cover);
+  void Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,ExplanationSet& cover);
   ///Outputs the graph with the given explanation limit
   void BuildRoadmap(Real maxExplanationCost,RoadmapPlanner& prm);
   ///Outputs the CC graph.  Each node is a connected component of the roadmap
   ///within the same subset.
-  void BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G);
+  void BuildCCGraph(Graph::UndirectedGraph<ExplanationSet,int>& G);
   ///A search that finds a path subject to a coverage constraint
-  bool CoveragePath(int s,int t,const Subset& cover,std::vector<int>& path,Subset& pathCover);
+  bool CoveragePath(int s,int t,const ExplanationSet& cover,std::vector<int>& path,ExplanationSet& pathCover);
   ///A greedy heuristic that performs smallest cover given predecessor
-  bool GreedyPath(int s,int t,std::vector<int>& path,Subset& pathCover);
+  bool GreedyPath(int s,int t,std::vector<int>& path,ExplanationSet& pathCover);
   ///An optimal search
-  bool OptimalPath(int s,int t,std::vector<int>& path,Subset& pathCover);
+  bool OptimalPath(int s,int t,std::vector<int>& path,ExplanationSet& pathCover);
   ///Returns the cover of the path from s->node + completion(node,goal)
   ///where the path cover is determined using the greedy
   ///heuristic
-  void Completion(int s,int node,int t,Subset& pathCover);
+  void Completion(int s,int node,int t,ExplanationSet& pathCover);
 
   //helpers
-  Real Cost(const Subset& s) const;
+  Real Cost(const ExplanationSet& s) const;
   int AddNode(const Config& q,int parent=-1);
-  int AddNode(const Config& q,const Subset& subset,int parent=-1);
+  int AddNode(const Config& q,const ExplanationSet& subset,int parent=-1);
   bool AddEdge(int i,int j,int depth=0);
   int AddEdge(int i,const Config& q,Real maxExplanationCost);  //returns index of q
   void AddEdgeRaw(int i,int j);
@@ -94,13 +109,13 @@ class MCRPlanner
   void UpdateMinCost(Mode& m);
   //fast checking of whether the cost of the local constraints at q exceed the
   //given limit
-  bool ExceedsCostLimit(const Config& q,Real limit,Subset& violations);
+  bool ExceedsCostLimit(const Config& q,Real limit,ExplanationSet& violations);
   //fast checking of whether the cost of the local constraints violated on 
   //the edge ab exceed the given limit
-  bool ExceedsCostLimit(const Config& a,const Config& b,Real limit,Subset& violations);
+  bool ExceedsCostLimit(const Config& a,const Config& b,Real limit,ExplanationSet& violations);
 
   ///Computes the cover of the path
-  void GetCover(const std::vector<int>& path,Subset& cover) const;
+  void GetCover(const std::vector<int>& path,ExplanationSet& cover) const;
   ///Computes the length of the path
   Real GetLength(const std::vector<int>& path) const;
   ///Returns the MilestonePath
@@ -16,15 +16,15 @@ const static double gSubdivideThreshold = 1e-3;
 
 
 //defined in MCRPlanner.cpp
-Subset Violations(ExplicitCSpace* space,const Config& q);
-Subset Violations(ExplicitCSpace* space,const Config& a,const Config& b);
+ExplanationSet Violations(ExplicitCSpace* space,const Config& q);
+ExplanationSet Violations(ExplicitCSpace* space,const Config& a,const Config& b);
 
 
-inline Real WeightedCost(const Subset& s,const vector<Real>& weights)
+inline Real WeightedCost(const ExplanationSet& s,const vector<Real>& weights)
 {
+  if(weights.empty()) return Real(s.size());
   Real sum=0.0;
-  //for(set<int>::const_iterator i=s.items.begin();i!=s.items.end();i++) {
-  for(vector<int>::const_iterator i=s.items.begin();i!=s.items.end();i++) {
+  for(ExplanationSet::const_iterator i=s.begin();i!=s.end();i++) {
     sum += weights[*i];
     if(IsInf(sum)) return sum;
   }
@@ -37,7 +37,7 @@ bool WithinThreshold(const MCRPlannerGoalSet::Mode& mode,Real maxExplanationCost
 }
 
 //checks whether the mode's cover + the extra cover exceed the given cost
-bool WithinThreshold(const MCRPlannerGoalSet::Mode& mode,const Subset& extra,Real maxExplanationCost,const vector<Real>& weights)
+bool WithinThreshold(const MCRPlannerGoalSet::Mode& mode,const ExplanationSet& extra,Real maxExplanationCost,const vector<Real>& weights)
 {
   if(mode.minCost > maxExplanationCost) return false;
   for(size_t i=0;i<mode.pathCovers.size();i++) {
@@ -66,9 +66,9 @@ MCRPlannerGoalSet::MCRPlannerGoalSet(ExplicitCSpace* _space)
   bidirectional = false;
 }
 
-Real MCRPlannerGoalSet::Cost(const Subset& s) const
+Real MCRPlannerGoalSet::Cost(const ExplanationSet& s) const
 {
-  if(obstacleWeights.empty()) return Real(s.items.size());
+  if(obstacleWeights.empty()) return Real(s.size());
   return WeightedCost(s,obstacleWeights);
 }
 
@@ -119,7 +119,7 @@ void MCRPlannerGoalSet::UpdatePathsGreedy()
   set<int> mg;
   for(size_t i=0;i<goalNodes.size();i++)
     mg.insert(roadmap.nodes[goalNodes[i]].mode);
-  Subset sgCover = modeGraph.nodes[m0].subset;
+  ExplanationSet sgCover = modeGraph.nodes[m0].subset;
   modeGraph.nodes[m0].pathCovers.resize(1);
   modeGraph.nodes[m0].pathCovers[0] = sgCover;
   Real c0=Cost(sgCover);
@@ -140,7 +140,7 @@ void MCRPlannerGoalSet::UpdatePathsGreedy()
     for(modeGraph.Begin(m,e);!e.end();e++) {
       //compute propagated cost
       Mode& modet=modeGraph.nodes[e.target()];
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[0];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[0];
       Real cs=Cost(s);
       if(modet.minCost <= cs)
 	continue;
@@ -174,7 +174,7 @@ void MCRPlannerGoalSet::UpdatePathsGreedy2(int nstart)
     mg.insert(roadmap.nodes[goalNodes[i]].mode);
   if(nstart <= 0) {
     int m0=roadmap.nodes[0].mode;
-    Subset sgCover = modeGraph.nodes[m0].subset;
+    ExplanationSet sgCover = modeGraph.nodes[m0].subset;
     modeGraph.nodes[m0].pathCovers.resize(1);
     modeGraph.nodes[m0].pathCovers[0] = sgCover;
     Real c0=Cost(sgCover);
@@ -191,7 +191,7 @@ void MCRPlannerGoalSet::UpdatePathsGreedy2(int nstart)
     for(modeGraph.Begin(m0,e);!e.end();e++) {
       Mode& modet = modeGraph.nodes[e.target()];
       if(modet.minCost >= mode0.minCost) continue;
-      Subset s = mode0.subset+modet.pathCovers[0];
+      ExplanationSet s = mode0.subset+modet.pathCovers[0];
       Real cs=Cost(s);
       if(cs < mode0.minCost) {
 	mode0.pathCovers[0] = s;
@@ -213,7 +213,7 @@ void MCRPlannerGoalSet::UpdatePathsGreedy2(int nstart)
     for(modeGraph.Begin(m,e);!e.end();e++) {
       //compute propagated cost
       Mode& modet=modeGraph.nodes[e.target()];
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[0];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[0];
       Real cs=Cost(s);
 
       if(!modet.pathCovers.empty()) {
@@ -261,7 +261,7 @@ void MCRPlannerGoalSet::UpdatePathsComplete()
   set<int> mg;
   for(size_t i=0;i<goalNodes.size();i++)
     mg.insert(roadmap.nodes[goalNodes[i]].mode);
-  Subset sgCover = modeGraph.nodes[m0].subset;
+  ExplanationSet sgCover = modeGraph.nodes[m0].subset;
   modeGraph.nodes[m0].pathCovers.resize(1);
   modeGraph.nodes[m0].pathCovers[0] = sgCover;
   q.insert(pair<int,int>(m0,0),Cost(sgCover));
@@ -285,7 +285,7 @@ void MCRPlannerGoalSet::UpdatePathsComplete()
       if((int)modet.pathCovers.size() >= updatePathsMax)
 	continue;
 
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
 
       if(visited[e.target()] == 1) { //visited already, look to see if the mode contains a subset of s
 	bool skip=false;
@@ -354,7 +354,7 @@ void MCRPlannerGoalSet::UpdatePathsComplete2(int nstart)
     for(size_t i=0;i<modeGraph.nodes.size();i++)
       modeGraph.nodes[i].pathCovers.resize(0);
     int m0=roadmap.nodes[0].mode;
-    Subset sgCover = modeGraph.nodes[m0].subset;
+    ExplanationSet sgCover = modeGraph.nodes[m0].subset;
     modeGraph.nodes[m0].pathCovers.resize(1);
     modeGraph.nodes[m0].pathCovers[0] = sgCover;
     Real c0=Cost(sgCover);
@@ -372,7 +372,7 @@ void MCRPlannerGoalSet::UpdatePathsComplete2(int nstart)
       Mode& modet = modeGraph.nodes[e.target()];
       if(modet.minCost > mode0.minCost) continue;
       for(size_t j=0;j<modet.pathCovers.size();j++) {
-	Subset s = mode0.subset+modet.pathCovers[j];
+	ExplanationSet s = mode0.subset+modet.pathCovers[j];
 	bool skip=false;
 	for(size_t i=0;i<mode0.pathCovers.size();i++) {
 	  if(s.is_subset(mode0.pathCovers[i])) {
@@ -412,7 +412,7 @@ void MCRPlannerGoalSet::UpdatePathsComplete2(int nstart)
       if((int)modet.pathCovers.size() >= updatePathsMax)
 	continue;
 
-      Subset s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
+      ExplanationSet s = modet.subset+modeGraph.nodes[m].pathCovers[subsetIndex];
 
       bool skip=false;
       vector<int> replace;
@@ -456,7 +456,7 @@ bool MCRPlannerGoalSet::CanImproveConnectivity(const Mode& ma,const Mode& mb,Rea
   if(&ma == &mb) return false;
   if(ma.pathCovers.empty() || mb.pathCovers.empty()) return true;
   for(size_t i=0;i<ma.pathCovers.size();i++) {
-    Subset next=(ma.pathCovers[i] + mb.subset);
+    ExplanationSet next=(ma.pathCovers[i] + mb.subset);
     Real cnext = Cost(next);
     if(cnext <= maxExplanationCost) {
       if(updatePathsComplete) {
@@ -471,7 +471,7 @@ bool MCRPlannerGoalSet::CanImproveConnectivity(const Mode& ma,const Mode& mb,Rea
     }
   }
   for(size_t i=0;i<mb.pathCovers.size();i++) {
-    Subset next=(mb.pathCovers[i] + ma.subset);
+    ExplanationSet next=(mb.pathCovers[i] + ma.subset);
     Real cnext = Cost(next);
     if(cnext <= maxExplanationCost) {
       if(updatePathsComplete) {
@@ -491,7 +491,7 @@ bool MCRPlannerGoalSet::CanImproveConnectivity(const Mode& ma,const Mode& mb,Rea
 
 //If there are more violations than the limit, return true.
 //Otherwise, return false and compute the subset of violations
-bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& q,Real limit,Subset& violations)
+bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& q,Real limit,ExplanationSet& violations)
 {
   int n=space->NumObstacles();
   /*
@@ -512,13 +512,13 @@ bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& q,Real limit,Subset& viol
     else
       vis[i] = false;
   }
-  violations = Subset(vis);
+  violations = ExplanationSet(vis);
   return false;
 }
 
 //If there are more violations than the limit, return true.
 //Otherwise, return false and compute the subset of violations
-bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& a,const Config& b,Real limit,Subset& violations)
+bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& a,const Config& b,Real limit,ExplanationSet& violations)
 {
   int n=space->NumObstacles();
   /*
@@ -544,7 +544,7 @@ bool MCRPlannerGoalSet::ExceedsCostLimit(const Config& a,const Config& b,Real li
       if(vcount > limit) return true;
     }
   }
-  violations = Subset(vis);
+  violations = ExplanationSet(vis);
   return false;
 }
 
@@ -553,10 +553,10 @@ int MCRPlannerGoalSet::AddNode(const Config& q,int parent)
 {
   vector<bool> subsetbits;
   space->CheckObstacles(q,subsetbits);
-  return AddNode(q,Subset(subsetbits),parent);
+  return AddNode(q,ExplanationSet(subsetbits),parent);
 }
 
-int MCRPlannerGoalSet::AddNode(const Config& q,const Subset& subset,int parent)
+int MCRPlannerGoalSet::AddNode(const Config& q,const ExplanationSet& subset,int parent)
 {
 #if DO_TIMING
   Timer timer;
@@ -569,7 +569,7 @@ int MCRPlannerGoalSet::AddNode(const Config& q,const Subset& subset,int parent)
   //Sanity check?
   vector<bool> subsetbits;
   space->CheckObstacles(q,subsetbits);
-  assert(subset == Subset(subsetbits));
+  assert(subset == ExplanationSet(subsetbits));
   */
 
   if(parent < 0 || modeGraph.nodes[roadmap.nodes[parent].mode].subset != subset)  {
@@ -624,7 +624,7 @@ bool MCRPlannerGoalSet::AddEdge(int i,int j,int depth)
   assert(j >= 0 && j < (int)roadmap.nodes.size());
   assert(!roadmap.HasEdge(i,j));
   numEdgeChecks++;
-  Subset ev=Violations(space,roadmap.nodes[i].q,roadmap.nodes[j].q);
+  ExplanationSet ev=Violations(space,roadmap.nodes[i].q,roadmap.nodes[j].q);
   int mi = roadmap.nodes[i].mode;
   int mj = roadmap.nodes[j].mode;
   assert(mi >= 0 && mi < (int)modeGraph.nodes.size());
@@ -648,7 +648,7 @@ bool MCRPlannerGoalSet::AddEdge(int i,int j,int depth)
 int MCRPlannerGoalSet::AddEdge(int i,const Config& q,Real maxExplanationCost)
 {
   numEdgeChecks++;
-  Subset ev,qv;
+  ExplanationSet ev,qv;
   numConfigChecks++;
   if(ExceedsCostLimit(q,maxExplanationCost,qv))
     return -1;
@@ -660,7 +660,7 @@ int MCRPlannerGoalSet::AddEdge(int i,const Config& q,Real maxExplanationCost)
     return -1;
   if(!WithinThreshold(modeGraph.nodes[mi],ev,maxExplanationCost,obstacleWeights)) 
     return -1;
-  const Subset& qiv = modeGraph.nodes[mi].subset;
+  const ExplanationSet& qiv = modeGraph.nodes[mi].subset;
   if(Cost((qiv + qv)) < Cost(ev)) {
     if(space->Distance(roadmap.nodes[i].q,q) < gSubdivideThreshold)
       return -1;
@@ -730,7 +730,7 @@ void MCRPlannerGoalSet::AddEdgeRaw(int i,int j)
     */
     if(updatePathsComplete) {
       //do a proper update of the irreducible covers
-      vector<Subset> newCovers;
+      vector<ExplanationSet> newCovers;
       for(size_t p=0;p<ma.pathCovers.size();p++) {
 	bool subset = false;
 	bool equal = false;
@@ -846,12 +846,12 @@ void MCRPlannerGoalSet::AddEdgeRaw(int i,int j)
 int MCRPlannerGoalSet::ExtendToward(int i,const Config& qdest,Real maxExplorationCost)
 {
   int mi = roadmap.nodes[i].mode;
-  const Subset& ei = modeGraph.nodes[mi].subset;
+  const ExplanationSet& ei = modeGraph.nodes[mi].subset;
 
   assert(gMaxExtendTowardIters == 1);
 
   numConfigChecks++;
-  Subset qv,ev;
+  ExplanationSet qv,ev;
   if(ExceedsCostLimit(qdest,maxExplorationCost,qv))
     return -1;
   if(!WithinThreshold(modeGraph.nodes[mi],qv,maxExplorationCost,obstacleWeights)) 
@@ -1006,7 +1006,7 @@ void MCRPlannerGoalSet::Expand(Real maxExplanationCost,vector<int>& newNodes)
   //attempt connections
   bool didRefine = false;
   newNodes.resize(0);
-  Subset qsubset;
+  ExplanationSet qsubset;
   Real minDist = Inf;
   size_t closestIndex = 0;
   for(size_t j=0;j<kclosest.size();j++) 
@@ -1021,7 +1021,7 @@ void MCRPlannerGoalSet::Expand(Real maxExplanationCost,vector<int>& newNodes)
     numConfigChecks++;
     vector<bool> subsetbits;
     space->CheckObstacles(q,subsetbits);
-    qsubset = Subset(subsetbits);
+    qsubset = ExplanationSet(subsetbits);
     
     int nearmode = roadmap.nodes[kneighbors[closestIndex]].mode;
     if(WithinThreshold(modeGraph.nodes[nearmode],qsubset,maxExplanationCost,obstacleWeights)) { //if config itself violates too many constraints, we're not going to connect any nodes
@@ -1150,7 +1150,7 @@ void MCRPlannerGoalSet::Expand2(Real maxExplanationCost,vector<int>& newNodes)
   //attempt connections
   bool didRefine = false;
   newNodes.resize(0);
-  Subset qsubset;
+  ExplanationSet qsubset;
   if(closest[0] < expandDistance) {
     numRefinementAttempts++;
     
@@ -1158,7 +1158,7 @@ void MCRPlannerGoalSet::Expand2(Real maxExplanationCost,vector<int>& newNodes)
     numConfigChecks++;
     vector<bool> subsetbits;
     space->CheckObstacles(q,subsetbits);
-    qsubset = Subset(subsetbits);
+    qsubset = ExplanationSet(subsetbits);
 
     int nearmode = roadmap.nodes[neighbor[0]].mode;    
     if(WithinThreshold(modeGraph.nodes[nearmode],qsubset,maxExplanationCost,obstacleWeights)) { //if config itself violates too many constraints, we're not going to connect any nodes
@@ -1268,18 +1268,15 @@ void MCRPlannerGoalSet::Expand2(Real maxExplanationCost,vector<int>& newNodes)
   }
 }
 
-void MCRPlannerGoalSet::Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,Subset& bestCover)
+void MCRPlannerGoalSet::Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,ExplanationSet& bestCover)
 {
-  bestCover.maxItem = space->NumObstacles();
-  bestCover.items.resize(bestCover.maxItem);
-  for(int i=0;i<bestCover.maxItem;i++)
-    bestCover.items[i] = (int)i;
+  bestCover = -ExplanationSet(space->NumObstacles());
 
-  Subset lowerCover;
+  ExplanationSet lowerCover;
   vector<bool> violations;
   numConfigChecks += 2;
   space->CheckObstacles(start,violations);
-  lowerCover=Subset(violations);
+  lowerCover=ExplanationSet(violations);
 
   Real lowerCost = Cost(lowerCover);
   Real bestCost = Cost(bestCover);
@@ -1403,7 +1400,7 @@ void UniformModeDFS(MCRPlannerGoalSet* eep,int mode,int vertex,vector<bool>& mar
   }
 }
 
-void MCRPlannerGoalSet::BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G)
+void MCRPlannerGoalSet::BuildCCGraph(Graph::UndirectedGraph<ExplanationSet,int>& G)
 {
   vector<int> nodeCCs(roadmap.nodes.size(),-1);
   vector<bool> marked(roadmap.nodes.size(),false);
@@ -1443,25 +1440,25 @@ void MCRPlannerGoalSet::BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G)
 struct CoverageLimitedPathCallback: public Graph::PathIntCallback
 {
   MCRPlannerGoalSet* planner;
-  const Subset& cover;
+  const ExplanationSet& cover;
 
-  CoverageLimitedPathCallback(MCRPlannerGoalSet* _planner,const Subset& _cover,int _target=-1)
+  CoverageLimitedPathCallback(MCRPlannerGoalSet* _planner,const ExplanationSet& _cover,int _target=-1)
     :PathIntCallback(_planner->roadmap.nodes.size(),_target),planner(_planner),cover(_cover)
   {}
 
   virtual bool ForwardEdge(int i,int j) {
     int modej = planner->roadmap.nodes[j].mode;
-    const Subset& subj = planner->modeGraph.nodes[modej].subset;
+    const ExplanationSet& subj = planner->modeGraph.nodes[modej].subset;
     return subj.is_subset(cover);
   }
 };
 
-bool MCRPlannerGoalSet::CoveragePath(int s,int t,const Subset& cover,vector<int>& path,Subset& pathCover)
+bool MCRPlannerGoalSet::CoveragePath(int s,int t,const ExplanationSet& cover,vector<int>& path,ExplanationSet& pathCover)
 {
   CoverageLimitedPathCallback callback(this,cover,t);
   roadmap._DFS(s,callback);
   if(Graph::GetAncestorPath(callback.parents,t,s,path)) {
-    pathCover = Subset();
+    pathCover = ExplanationSet();
     for(size_t i=0;i<path.size();i++)
       pathCover = pathCover + modeGraph.nodes[roadmap.nodes[path[i]].mode].subset;
     return true;
@@ -1475,7 +1472,7 @@ bool MCRPlannerGoalSet::CoveragePath(int s,int t,const Subset& cover,vector<int>
  */
 struct SubsetCost
 {
-  Subset subset;
+  ExplanationSet subset;
   Real pathCost;
   vector<Real>* weights;
 
@@ -1483,7 +1480,7 @@ struct SubsetCost
     :subset(maxItem),pathCost(cost),weights(_weights)
   {}
 
-  SubsetCost(const Subset& s,Real cost=0,vector<Real>* _weights=NULL)
+  SubsetCost(const ExplanationSet& s,Real cost=0,vector<Real>* _weights=NULL)
     :subset(s),pathCost(cost),weights(_weights)
   {}
 
@@ -1593,20 +1590,20 @@ struct GreedySubsetAStar2 : public GeneralizedAStar<int,SubsetCost>
 };
 
 
-struct OptimalSubsetAStar2 : public GeneralizedAStar<pair<int,Subset>,SubsetCost>
+struct OptimalSubsetAStar2 : public GeneralizedAStar<pair<int,ExplanationSet>,SubsetCost>
 {
-  typedef pair<int,Subset> State;
+  typedef pair<int,ExplanationSet> State;
   typedef GeneralizedAStar<State,SubsetCost>::Node Node;
   MCRPlannerGoalSet* planner;
   int startNode;
   set<int> targetNodes;
-  vector<vector<pair<Subset,Node*> > > visited;
+  vector<vector<pair<ExplanationSet,Node*> > > visited;
 
   OptimalSubsetAStar2(MCRPlannerGoalSet* _planner,int _start,const vector<int>& _targets)
     :planner(_planner),startNode(_start),targetNodes(_targets.begin(),_targets.end())
   {
-    const Subset& m0=planner->modeGraph.nodes[planner->roadmap.nodes[startNode].mode].subset;
-    SetStart(pair<int,Subset>(_start,m0));
+    const ExplanationSet& m0=planner->modeGraph.nodes[planner->roadmap.nodes[startNode].mode].subset;
+    SetStart(pair<int,ExplanationSet>(_start,m0));
     root.g = SubsetCost(m0,0,&planner->obstacleWeights);
     root.f = root.g;
   }
@@ -1630,7 +1627,7 @@ struct OptimalSubsetAStar2 : public GeneralizedAStar<pair<int,Subset>,SubsetCost
 	SubsetCost c(planner->space->NumObstacles(),dist,&planner->obstacleWeights);
 	cost.push_back(c);
       }
-      successors.push_back(pair<int,Subset>(e.target(),cost.back().subset+s.second));
+      successors.push_back(pair<int,ExplanationSet>(e.target(),cost.back().subset+s.second));
     }
   }
 
@@ -1642,7 +1639,7 @@ struct OptimalSubsetAStar2 : public GeneralizedAStar<pair<int,Subset>,SubsetCost
 
   virtual void Visit(const State& s,Node* n)
   {
-    visited[s.first].push_back(pair<Subset,Node*>(s.second,n));
+    visited[s.first].push_back(pair<ExplanationSet,Node*>(s.second,n));
   }
 
   virtual Node* VisitedStateNode(const State& s)
@@ -1656,7 +1653,7 @@ struct OptimalSubsetAStar2 : public GeneralizedAStar<pair<int,Subset>,SubsetCost
 };
 
 
-bool MCRPlannerGoalSet::GreedyPath(int s,int t,vector<int>& path,Subset& pathCover)
+bool MCRPlannerGoalSet::GreedyPath(int s,int t,vector<int>& path,ExplanationSet& pathCover)
 {
   vector<int> tgts(1,t);
   GreedySubsetAStar2 astar(this,s,tgts);
@@ -1678,7 +1675,7 @@ bool MCRPlannerGoalSet::GreedyPath(int s,int t,vector<int>& path,Subset& pathCov
 }
 
 
-bool MCRPlannerGoalSet::OptimalPath(int s,int t,vector<int>& path,Subset& pathCover)
+bool MCRPlannerGoalSet::OptimalPath(int s,int t,vector<int>& path,ExplanationSet& pathCover)
 {
   vector<int> tgts(1,t);
   OptimalSubsetAStar2 astar(this,s,tgts);
@@ -1700,7 +1697,7 @@ bool MCRPlannerGoalSet::OptimalPath(int s,int t,vector<int>& path,Subset& pathCo
 }
 
 
-bool MCRPlannerGoalSet::GreedyPath(vector<int>& path,Subset& pathCover)
+bool MCRPlannerGoalSet::GreedyPath(vector<int>& path,ExplanationSet& pathCover)
 {
   GreedySubsetAStar2 astar(this,0,goalNodes);
   if(!astar.Search()) {
@@ -1721,7 +1718,7 @@ bool MCRPlannerGoalSet::GreedyPath(vector<int>& path,Subset& pathCover)
 }
 
 
-bool MCRPlannerGoalSet::OptimalPath(vector<int>& path,Subset& pathCover)
+bool MCRPlannerGoalSet::OptimalPath(vector<int>& path,ExplanationSet& pathCover)
 {
   OptimalSubsetAStar2 astar(this,0,goalNodes);
   if(!astar.Search()) {
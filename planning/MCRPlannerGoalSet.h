@@ -1,9 +1,7 @@
 #ifndef MCR_PLANNER_GOAL_SET_H
 #define MCR_PLANNER_GOAL_SET_H
 
-#include "MotionPlanner.h"
-#include "ExplicitCSpace.h"
-#include <utils/Subset.h>
+#include "MCRPlanner.h"
 
 /** @brief A subset of a configuration space equipped with a projection
  * mechanism.
@@ -45,7 +43,7 @@ class SingletonSetProjector : public SubsetProjector
  *   schedule.push_back(limit1);
  *     ...
  *   schedule.push_back(limitN);
- *   Subset cover;
+ *   ExplanationSet cover;
  *   vector<int> bestPlan;
  *   planner.Plan(0,schedule,bestPlan,cover);
  *
@@ -67,9 +65,9 @@ class MCRPlannerGoalSet
   typedef Graph::UndirectedGraph<Milestone,Edge> Roadmap;
 
   struct Mode {
-    Subset subset;      //subset covered by this mode
+    ExplanationSet subset;      //subset covered by this mode
     std::vector<int> roadmapNodes;
-    std::vector<Subset> pathCovers;   //minimal covers leading from the start to this mode
+    std::vector<ExplanationSet> pathCovers;   //minimal covers leading from the start to this mode
     Real minCost;
   };
   struct Transition {
@@ -83,27 +81,27 @@ class MCRPlannerGoalSet
   void Expand(Real maxExplanationCost,vector<int>& newNodes);
   void Expand2(Real maxExplanationCost,vector<int>& newNodes);
   ///Performs bottom-up planning according to a given limit expansion schedule
-  void Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,Subset& cover);
+  void Plan(int initialLimit,const vector<int>& expansionSchedule,vector<int>& bestPath,ExplanationSet& cover);
   ///Outputs the graph with the given explanation limit
   void BuildRoadmap(Real maxExplanationCost,RoadmapPlanner& prm);
   ///Outputs the CC graph.  Each node is a connected component of the roadmap
   ///within the same subset.
-  void BuildCCGraph(Graph::UndirectedGraph<Subset,int>& G);
+  void BuildCCGraph(Graph::UndirectedGraph<ExplanationSet,int>& G);
   ///A search that finds a path subject to a coverage constraint
-  bool CoveragePath(int s,int t,const Subset& cover,std::vector<int>& path,Subset& pathCover);
+  bool CoveragePath(int s,int t,const ExplanationSet& cover,std::vector<int>& path,ExplanationSet& pathCover);
   ///A greedy heuristic that performs smallest cover given predecessor
-  bool GreedyPath(int s,int t,std::vector<int>& path,Subset& pathCover);
+  bool GreedyPath(int s,int t,std::vector<int>& path,ExplanationSet& pathCover);
   ///An optimal search
-  bool OptimalPath(int s,int t,std::vector<int>& path,Subset& pathCover);
+  bool OptimalPath(int s,int t,std::vector<int>& path,ExplanationSet& pathCover);
   /// Returns the best GreedyPath out of any start->goal path
-  bool GreedyPath(std::vector<int>& path,Subset& pathCover);
+  bool GreedyPath(std::vector<int>& path,ExplanationSet& pathCover);
   /// Returns the best OptimalPath out of any start->goal path
-  bool OptimalPath(std::vector<int>& path,Subset& pathCover);
+  bool OptimalPath(std::vector<int>& path,ExplanationSet& pathCover);
 
   //helpers
-  Real Cost(const Subset& s) const;
+  Real Cost(const ExplanationSet& s) const;
   int AddNode(const Config& q,int parent=-1);
-  int AddNode(const Config& q,const Subset& subset,int parent=-1);
+  int AddNode(const Config& q,const ExplanationSet& subset,int parent=-1);
   bool AddEdge(int i,int j,int depth=0);
   int AddEdge(int i,const Config& q,Real maxExplanationCost);  //returns index of q
   void AddEdgeRaw(int i,int j);
@@ -121,13 +119,13 @@ class MCRPlannerGoalSet
   void UpdateMinCost(Mode& m);
   //fast checking of whether the cost of the local constraints at q exceed the
   //given limit
-  bool ExceedsCostLimit(const Config& q,Real limit,Subset& violations);
+  bool ExceedsCostLimit(const Config& q,Real limit,ExplanationSet& violations);
   //fast checking of whether the cost of the local constraints violated on 
   //the edge ab exceed the given limit
-  bool ExceedsCostLimit(const Config& a,const Config& b,Real limit,Subset& violations);
+  bool ExceedsCostLimit(const Config& a,const Config& b,Real limit,ExplanationSet& violations);
 
   ///Computes the cover of the path
-  void GetCover(const std::vector<int>& path,Subset& cover) const;
+  void GetCover(const std::vector<int>& path,ExplanationSet& cover) const;
   ///Computes the length of the path
   Real GetLength(const std::vector<int>& path) const;
   ///Returns the MilestonePath
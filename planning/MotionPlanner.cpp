@@ -2,6 +2,8 @@
 #include <graph/Path.h>
 #include <math/random.h>
 #include <errors.h>
+#include <algorithm>
+#include <map>
 
 typedef TreeRoadmapPlanner::Node Node;
 using namespace std;
@@ -35,10 +37,60 @@ struct ClosestMilestoneCallback : public Node::Callback
   Node* closestMilestone;
 };
 
+//Point location filters
 
+// OtherComponentFilter: accepts roadmap nodes not in the same component as i
+struct OtherComponentFilter : public PointLocationBase::Filter
+{
+  OtherComponentFilter(Graph::ConnectedComponents& _ccs,int _i)
+    :ccs(_ccs),i(_i)
+  {}
+  virtual bool Accept(int j) { return !ccs.SameComponent(i,j); }
+  Graph::ConnectedComponents& ccs;
+  int i;
+};
+
+// NonAdjacentFilter: accepts roadmap nodes other than i not connected to i
+struct NonAdjacentFilter : public PointLocationBase::Filter
+{
+  NonAdjacentFilter(RoadmapPlanner::Roadmap& _roadmap,int _i)
+    :roadmap(_roadmap),i(_i)
+  {}
+  virtual bool Accept(int j) { return i!=j && !roadmap.HasEdge(i,j); }
+  RoadmapPlanner::Roadmap& roadmap;
+  int i;
+};
+
+// ComponentFilter: accepts tree nodes in component c (or, if exclude is
+// true, those not in component c)
+struct ComponentFilter : public PointLocationBase::Filter
+{
+  ComponentFilter(const vector<Node*>& _nodes,int _c,bool _exclude=false)
+    :nodes(_nodes),c(_c),exclude(_exclude)
+  {}
+  virtual bool Accept(int id) { return (nodes[id]->connectedComponent == c) != exclude; }
+  const vector<Node*>& nodes;
+  int c;
+  bool exclude;
+};
+
+
+
+// EarlierNodeFilter: accepts roadmap nodes with index less than i
+struct EarlierNodeFilter : public PointLocationBase::Filter
+{
+  EarlierNodeFilter(int _i) :i(_i) {}
+  virtual bool Accept(int j) { return j < i; }
+  int i;
+};
 
 RoadmapPlanner::RoadmapPlanner(CSpace* s)
-  :space(s)
+  :space(s),pointLocation(new GNATPointLocation(s)),numThreads(1)
+{
+}
+
+RoadmapPlanner::RoadmapPlanner(const RoadmapPlanner& rhs)
+  :space(rhs.space),roadmap(rhs.roadmap),ccs(rhs.ccs),pointLocation(new GNATPointLocation(rhs.space)),numThreads(rhs.numThreads)
 {
 }
 
@@ -48,14 +100,43 @@ RoadmapPlanner::~RoadmapPlanner()
 }
 
 
+const RoadmapPlanner& RoadmapPlanner::operator = (const RoadmapPlanner& rhs)
+{
+  space = rhs.space;
+  roadmap = rhs.roadmap;
+  ccs = rhs.ccs;
+  numThreads = rhs.numThreads;
+  //the clones are made again if needed, from the new space
+  threadSpaces.clear();
+  threadPool = NULL;
+  //don't share the index; it gets rebuilt on the next query
+  pointLocation->space = space;
+  pointLocation->Clear();
+  return *this;
+}
+
 void RoadmapPlanner::Cleanup()
 {
   roadmap.Cleanup();
   ccs.Clear();
+  pointLocation->Clear();
+}
+
+void RoadmapPlanner::UpdatePointLocation()
+{
+  int n=pointLocation->Size();
+  if(n > (int)roadmap.nodes.size()) {
+    //roadmap was replaced
+    pointLocation->Clear();
+    n = 0;
+  }
+  for(size_t i=n;i<roadmap.nodes.size();i++)
+    pointLocation->Add((int)i,roadmap.nodes[i]);
 }
 
 void RoadmapPlanner::GenerateConfig(Config& x)
 {
+  PlannerStatTimer timer(&stats,PlannerStats::Sample);
   space->Sample(x);
 }
 
@@ -67,7 +148,10 @@ int RoadmapPlanner::AddMilestone(const Config& x)
 
 int RoadmapPlanner::TestAndAddMilestone(const Config& x)
 {
-  if(!space->IsFeasible(x)) return -1;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::Feasibility);
+    if(!space->IsFeasible(x)) return -1;
+  }
   return AddMilestone(x);
 }
 
@@ -80,7 +164,12 @@ void RoadmapPlanner::ConnectEdge(int i,int j,const SmartPointer<EdgePlanner>& e)
 SmartPointer<EdgePlanner> RoadmapPlanner::TestAndConnectEdge(int i,int j)
 {
   SmartPointer<EdgePlanner> e=space->LocalPlanner(roadmap.nodes[i],roadmap.nodes[j]);
-  if(e->IsVisible()) {
+  bool visible;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck);
+    visible = e->IsVisible();
+  }
+  if(visible) {
     ConnectEdge(i,j,e);
     return e;
   }
@@ -92,44 +181,49 @@ SmartPointer<EdgePlanner> RoadmapPlanner::TestAndConnectEdge(int i,int j)
 
 void RoadmapPlanner::ConnectToNeighbors(int i,Real connectionThreshold,bool ccReject)
 {
-  for(size_t j=0;j<roadmap.nodes.size();j++) {
-    if(ccReject) { if(ccs.SameComponent(i,j)) continue; }
-    else if(i==(int)j || roadmap.HasEdge(i,j)) continue;
-    if(space->Distance(roadmap.nodes[i],roadmap.nodes[j]) < connectionThreshold) {
-      TestAndConnectEdge(i,j);
+  UpdatePointLocation();
+  vector<int> neighbors;
+  vector<Real> distances;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
+    if(ccReject) {
+      OtherComponentFilter filter(ccs,i);
+      pointLocation->Close(roadmap.nodes[i],connectionThreshold,neighbors,distances,&filter);
     }
+    else {
+      NonAdjacentFilter filter(roadmap,i);
+      pointLocation->Close(roadmap.nodes[i],connectionThreshold,neighbors,distances,&filter);
+    }
+  }
+  for(size_t j=0;j<neighbors.size();j++) {
+    //components may have merged since the query
+    if(ccReject && ccs.SameComponent(i,neighbors[j])) continue;
+    TestAndConnectEdge(i,neighbors[j]);
   }
 }
 
 void RoadmapPlanner::ConnectToNearestNeighbors(int i,int k,bool ccReject)
 {
   if(k <= 0) return;
-  set<pair<Real,int> > knn;
-  pair<Real,int> node;
-  Real worst=Inf;
-  for(size_t j=0;j<roadmap.nodes.size();j++) {
-    if(ccReject) { if(ccs.SameComponent(i,j)) continue; }
-    else if(i==(int)j) continue;
-    node.first = space->Distance(roadmap.nodes[i],roadmap.nodes[j]);
-    node.second = j;
-    if(node.first < worst) {
-      knn.insert(node);
-
-      if(ccReject) {  //oversample candidate nearest neighbors
-	if((int)knn.size() > k*4)
-	  knn.erase(--knn.end());
-      }
-      else {  //only keep k nearest neighbors
-	if(knn.size() > k)
-	  knn.erase(--knn.end());
-      }
-      worst = (--knn.end())->first;
+  UpdatePointLocation();
+  vector<int> knn;
+  vector<Real> distances;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
+    if(ccReject) {
+      //oversample candidate nearest neighbors
+      OtherComponentFilter filter(ccs,i);
+      pointLocation->KNN(roadmap.nodes[i],k*4,knn,distances,&filter);
+    }
+    else {
+      NonAdjacentFilter filter(roadmap,i);
+      pointLocation->KNN(roadmap.nodes[i],k,knn,distances,&filter);
     }
   }
   int numTests=0;
-  for(set<pair<Real,int> >::const_iterator j=knn.begin();j!=knn.end();j++) {
-    if(ccReject && ccs.SameComponent(i,j->second)) continue;
-    TestAndConnectEdge(i,j->second);
+  for(size_t j=0;j<knn.size();j++) {
+    if(ccReject && ccs.SameComponent(i,knn[j])) continue;
+    TestAndConnectEdge(i,knn[j]);
     numTests++;
     if(numTests == k) break;
   }
@@ -137,6 +231,8 @@ void RoadmapPlanner::ConnectToNearestNeighbors(int i,int k,bool ccReject)
 
 void RoadmapPlanner::Generate(int numSamples,Real connectionThreshold)
 {
+  if(numThreads > 1 && GenerateParallel(numSamples,connectionThreshold))
+    return;
   Config x;
   for(int i=0;i<numSamples;i++) {
     GenerateConfig(x);
@@ -145,10 +241,167 @@ void RoadmapPlanner::Generate(int numSamples,Real connectionThreshold)
   }
 }
 
+//tests the feasibility of a batch of samples
+struct FeasibilityBatch : public ParallelForBody
+{
+  FeasibilityBatch(const vector<CSpace*>& _spaces,const vector<Config>& _samples)
+    :spaces(_spaces),samples(_samples),feasible(_samples.size(),false)
+  {}
+  virtual void Run(int begin,int end,int thread) {
+    for(int i=begin;i<end;i++)
+      feasible[i] = spaces[thread]->IsFeasible(samples[i]);
+  }
+  const vector<CSpace*>& spaces;
+  const vector<Config>& samples;
+  vector<char> feasible;
+};
+
+//checks a batch of edges (i,j) between roadmap nodes, keeping the
+//visible ones
+struct EdgeBatch : public ParallelForBody
+{
+  EdgeBatch(const vector<CSpace*>& _spaces,const RoadmapPlanner::Roadmap& _roadmap,const vector<pair<int,int> >& _pairs)
+    :spaces(_spaces),roadmap(_roadmap),pairs(_pairs),edges(_pairs.size())
+  {}
+  virtual void Run(int begin,int end,int thread) {
+    for(int k=begin;k<end;k++) {
+      EdgePlanner* e = spaces[thread]->LocalPlanner(roadmap.nodes[pairs[k].first],roadmap.nodes[pairs[k].second]);
+      if(e->IsVisible()) edges[k] = e;
+      else delete e;
+    }
+  }
+  const vector<CSpace*>& spaces;
+  const RoadmapPlanner::Roadmap& roadmap;
+  const vector<pair<int,int> >& pairs;
+  vector<EdgePlanner*> edges;
+};
+
+//returns the component of node i after the merges in merged
+int SpeculativeComponent(Graph::ConnectedComponents& ccs,const map<int,int>& merged,int i)
+{
+  int c = ccs.GetComponent(i);
+  map<int,int>::const_iterator m;
+  while((m=merged.find(c)) != merged.end()) c = m->second;
+  return c;
+}
+
+bool RoadmapPlanner::GenerateParallel(int numSamples,Real connectionThreshold)
+{
+  //thread 0 is the calling thread, which uses space itself
+  if((int)threadSpaces.size() < numThreads) {
+    threadSpaces.resize(numThreads);
+    for(int t=1;t<numThreads;t++) {
+      if(threadSpaces[t]) continue;
+      CSpace* clone = space->Clone();
+      if(!clone) {
+	threadSpaces.clear();
+	return false;
+      }
+      threadSpaces[t] = clone;
+    }
+  }
+  if(!threadPool || threadPool->NumThreads() != numThreads)
+    threadPool = new ThreadPool(numThreads);
+  vector<CSpace*> spaces(numThreads,space);
+  for(int t=1;t<numThreads;t++) spaces[t] = threadSpaces[t];
+
+  const int batchSize = 16*numThreads;
+  vector<Config> samples;
+  for(int s=0;s<numSamples;s+=batchSize) {
+    samples.resize(Min(batchSize,numSamples-s));
+    for(size_t i=0;i<samples.size();i++)
+      GenerateConfig(samples[i]);
+    FeasibilityBatch feasibility(spaces,samples);
+    {
+      PlannerStatTimer timer(&stats,PlannerStats::Feasibility,(int)samples.size());
+      threadPool->ParallelFor((int)samples.size(),feasibility);
+    }
+    int first = (int)roadmap.nodes.size();
+    for(size_t i=0;i<samples.size();i++)
+      if(feasibility.feasible[i]) AddMilestone(samples[i]);
+    int last = (int)roadmap.nodes.size();
+    if(first == last) continue;
+
+    //the serial algorithm would connect node k to the candidates in
+    //neighbors[k-first] in order, skipping those already in its component
+    UpdatePointLocation();
+    vector<vector<int> > neighbors(last-first);
+    vector<Real> distances;
+    for(int k=first;k<last;k++) {
+      PlannerStatTimer nnTimer(&stats,PlannerStats::NearestNeighbor);
+      EarlierNodeFilter filter(k);
+      pointLocation->Close(roadmap.nodes[k],connectionThreshold,neighbors[k-first],distances,&filter);
+    }
+    //replay the serial algorithm.  When it needs an edge that hasn't been
+    //checked, the remaining nodes are replayed assuming all unchecked
+    //edges are visible, and the edges that this replay tests are checked
+    //in parallel before resuming.
+    map<pair<int,int>,EdgePlanner*> checked;
+    int k = first;
+    size_t pos = 0;
+    while(k < last) {
+      const vector<int>& nk = neighbors[k-first];
+      if(pos == nk.size()) {
+	k++;
+	pos = 0;
+	continue;
+      }
+      int j = nk[pos];
+      if(ccs.SameComponent(k,j)) {
+	pos++;
+	continue;
+      }
+      map<pair<int,int>,EdgePlanner*>::iterator e = checked.find(pair<int,int>(k,j));
+      if(e != checked.end()) {
+	if(e->second) ConnectEdge(k,j,e->second);
+	pos++;
+	continue;
+      }
+      vector<pair<int,int> > pairs;
+      map<int,int> merged;  //component merges assumed by the replay
+      for(int m=k;m<last;m++) {
+	const vector<int>& nm = neighbors[m-first];
+	for(size_t p=(m==k?pos:0);p<nm.size();p++) {
+	  int cm = SpeculativeComponent(ccs,merged,m);
+	  int c = SpeculativeComponent(ccs,merged,nm[p]);
+	  if(c == cm) continue;
+	  e = checked.find(pair<int,int>(m,nm[p]));
+	  if(e == checked.end()) 
+	    pairs.push_back(pair<int,int>(m,nm[p]));
+	  else if(!e->second) continue;
+	  merged[c] = cm;
+	}
+      }
+      EdgeBatch edges(spaces,roadmap,pairs);
+      {
+	PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck,(int)pairs.size());
+	threadPool->ParallelFor((int)pairs.size(),edges,1);
+      }
+      for(size_t p=0;p<pairs.size();p++) {
+	//the roadmap must not refer to the clones, which go away with the
+	//planner
+	EdgePlanner* e = edges.edges[p];
+	if(e && e->Space() != space) {
+	  edges.edges[p] = space->LocalPlanner(e->Start(),e->Goal());
+	  delete e;
+	}
+	checked[pairs[p]] = edges.edges[p];
+      }
+    }
+    //delete the edges that turned out not to be needed
+    for(map<pair<int,int>,EdgePlanner*>::iterator e=checked.begin();e!=checked.end();e++)
+      if(e->second && !roadmap.HasEdge(e->first.first,e->first.second))
+	delete e->second;
+  }
+  return true;
+}
+
 void RoadmapPlanner::CreatePath(int i,int j,MilestonePath& path)
 {
   Assert(ccs.SameComponent(i,j));
+  PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
   Graph::PathIntCallback callback(roadmap.nodes.size(),j);
+  roadmap.NewTraversal();
   roadmap._BFS(i,callback);
   list<int> nodes;
   Graph::GetAncestorPath(callback.parents,j,i,nodes);
@@ -182,7 +435,7 @@ void RoadmapPlanner::CreatePath(int i,int j,MilestonePath& path)
 
 
 TreeRoadmapPlanner::TreeRoadmapPlanner(CSpace* s)
-  :space(s),connectionThreshold(Inf)
+  :space(s),connectionThreshold(Inf),pointLocation(new GNATPointLocation(s))
 {
 }
 
@@ -198,11 +451,19 @@ void TreeRoadmapPlanner::Cleanup()
     SafeDelete(connectedComponents[i]);
   connectedComponents.clear();
   milestones.clear();
+  pointLocation->Clear();
+  pointLocationNodes.clear();
+  nodePool.Clear();
 }
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::TestAndAddMilestone(const Config& x)
 {
-  if(space->IsFeasible(x))
+  bool feasible;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::Feasibility);
+    feasible = space->IsFeasible(x);
+  }
+  if(feasible)
     return AddMilestone(x);
   else 
     return AddInfeasibleMilestone(x);
@@ -210,17 +471,20 @@ TreeRoadmapPlanner::Node* TreeRoadmapPlanner::TestAndAddMilestone(const Config&
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::AddMilestone(const Config& x)
 {
-  Milestone m;
-  m.x=x;
-  int n=(int)connectedComponents.size();
-  m.connectedComponent=n;
-  connectedComponents.push_back(new Node(m));
-  milestones.push_back(connectedComponents[n]);
-  return connectedComponents[n];
+  Node* node=new(&nodePool) Node;
+  node->x=x;
+  node->connectedComponent=(int)connectedComponents.size();
+  node->id=(int)pointLocationNodes.size();
+  connectedComponents.push_back(node);
+  milestones.push_back(node);
+  pointLocationNodes.push_back(node);
+  pointLocation->Add(node->id,x);
+  return node;
 }
 
 void TreeRoadmapPlanner::GenerateConfig(Config& x)
 {
+  PlannerStatTimer timer(&stats,PlannerStats::Sample);
   space->Sample(x);
 }
 
@@ -240,21 +504,26 @@ void TreeRoadmapPlanner::ConnectToNeighbors(Node* n)
     //for each other component, attempt a connection to the closest node
     for(size_t i=0;i<connectedComponents.size();i++) {
       if((int)i == n->connectedComponent) continue;
-      
-      ClosestMilestoneCallback callback(space,n->x);
-      connectedComponents[i]->DFS(callback);
-      TryConnect(n,callback.closestMilestone);
+      if(connectedComponents[i] == NULL) continue;
+
+      Node* closest = ClosestMilestoneInComponent(i,n->x);
+      if(closest) TryConnect(n,closest);
     }
   }
   else {
     //attempt a connection between this node and all others within the 
     //connection threshold
-    for(size_t i=0;i<milestones.size();i++) {
-      if(n->connectedComponent != milestones[i]->connectedComponent) {
-	if(space->Distance(n->x,milestones[i]->x) < connectionThreshold) {
-	  TryConnect(n,milestones[i]);
-	}
-      }
+    vector<int> neighbors;
+    vector<Real> distances;
+    {
+      PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
+      ComponentFilter filter(pointLocationNodes,n->connectedComponent,true);
+      pointLocation->Close(n->x,connectionThreshold,neighbors,distances,&filter);
+    }
+    for(size_t i=0;i<neighbors.size();i++) {
+      Node* m = pointLocationNodes[neighbors[i]];
+      if(n->connectedComponent != m->connectedComponent)
+	TryConnect(n,m);
     }
   }
 }
@@ -263,7 +532,12 @@ EdgePlanner* TreeRoadmapPlanner::TryConnect(Node* a,Node* b)
 {
   Assert(a->connectedComponent != b->connectedComponent);
   EdgePlanner* e=space->LocalPlanner(a->x,b->x);
-  if(e->IsVisible()) {
+  bool visible;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck);
+    visible = e->IsVisible();
+  }
+  if(visible) {
     if(a->connectedComponent < b->connectedComponent) AttachChild(a,b,e);
     else AttachChild(b,a,e);
     return e;
@@ -304,6 +578,8 @@ void TreeRoadmapPlanner::DeleteSubtree(Node* n)
   Graph::TopologicalSortCallback<Node*> callback;
   n->DFS(callback);
   for(list<Node*>::iterator i=callback.list.begin();i!=callback.list.end();i++) {
+    pointLocation->Remove((*i)->id);
+    pointLocationNodes[(*i)->id] = NULL;
     for(size_t j=0;j<milestones.size();j++) {
       if(milestones[j]==*i) {
 	milestones[j]=milestones.back();
@@ -318,6 +594,7 @@ void TreeRoadmapPlanner::DeleteSubtree(Node* n)
 void TreeRoadmapPlanner::CreatePath(Node* a, Node* b, MilestonePath& path)
 {
   Assert(a->connectedComponent == b->connectedComponent);
+  PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
   Assert(a->LCA(b) != NULL);  //make sure they're on same tree?
   a->reRoot();
   connectedComponents[a->connectedComponent] = a;
@@ -365,28 +642,26 @@ void TreeRoadmapPlanner::CreatePath(Node* a, Node* b, MilestonePath& path)
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::ClosestMilestone(const Config& x)
 {
-  if(milestones.empty()) return NULL;
-  Real dmin=space->Distance(milestones[0]->x,x);
-  Node* n=milestones[0];
-  for(size_t i=1;i<milestones.size();i++) {
-    Real d=space->Distance(milestones[i]->x,x);
-    if(d<dmin) {
-      dmin=d;
-      n=milestones[i];
-    }
-  }
-  return n;
+  PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
+  Real d;
+  int id=pointLocation->NN(x,d);
+  if(id < 0) return NULL;
+  return pointLocationNodes[id];
 }
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::ClosestMilestoneInComponent(int component,const Config& x)
 {
-  ClosestMilestoneCallback callback(space,x);
-  connectedComponents[component]->DFS(callback);
-  return callback.closestMilestone;
+  PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
+  Real d;
+  ComponentFilter filter(pointLocationNodes,component);
+  int id=pointLocation->NN(x,d,&filter);
+  if(id < 0) return NULL;
+  return pointLocationNodes[id];
 }
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::ClosestMilestoneInSubtree(Node* node,const Config& x)
 {
+  PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
   ClosestMilestoneCallback callback(space,x);
   node->DFS(callback);
   return callback.closestMilestone;
@@ -408,10 +683,20 @@ TreeRoadmapPlanner::Node* TreeRoadmapPlanner::Extend(Node* n,const Config& x)
 
 TreeRoadmapPlanner::Node* TreeRoadmapPlanner::TryExtend(Node* n,const Config& x)
 {
-  if(space->IsFeasible(x)) {
+  bool feasible;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::Feasibility);
+    feasible = space->IsFeasible(x);
+  }
+  if(feasible) {
     //connect closest to n
     EdgePlanner* e=space->LocalPlanner(n->x,x);
-    if(e->IsVisible()) {
+    bool visible;
+    {
+      PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck);
+      visible = e->IsVisible();
+    }
+    if(visible) {
       Node* c=AddMilestone(x);
       n->addChild(c);
       c->edgeFromParent() = e;
@@ -497,6 +782,7 @@ void PerturbationTreePlanner::GenerateConfig(Config& x)
   }
   else {
     Node* n = SelectMilestone(milestones);
+    PlannerStatTimer timer(&stats,PlannerStats::Sample);
     space->SampleNeighborhood(n->x,delta,x);
   }
 }
@@ -529,7 +815,10 @@ RRTPlanner::RRTPlanner(CSpace*s)
 TreeRoadmapPlanner::Node* RRTPlanner::Extend()
 {
   Config dest,x;
-  space->Sample(dest);
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::Sample);
+    space->Sample(dest);
+  }
 
   //pick closest milestone, step in that direction
   Node* closest=ClosestMilestone(dest);
@@ -573,20 +862,18 @@ bool BidirectionalRRTPlanner::Plan()
 
   if(n->connectedComponent == milestones[0]->connectedComponent) {
     //attempt to connect to goal, if the distance is < connectionThreshold
-    ClosestMilestoneCallback callback(space,n->x);
-    milestones[1]->DFS(callback);
-    if(callback.closestDistance < connectionThreshold) {
-      if(TryConnect(n,callback.closestMilestone)) //connection successful!
+    Node* closest=ClosestMilestoneInComponent(milestones[1]->connectedComponent,n->x);
+    if(space->Distance(closest->x,n->x) < connectionThreshold) {
+      if(TryConnect(n,closest)) //connection successful!
 	return true;
     }
   }
   else {
     Assert(n->connectedComponent == milestones[1]->connectedComponent);
     //attempt to connect to start, if the distance is < connectionThreshold
-    ClosestMilestoneCallback callback(space,n->x);
-    milestones[0]->DFS(callback);
-    if(callback.closestDistance < connectionThreshold) {
-      if(TryConnect(callback.closestMilestone,n)) //connection successful!
+    Node* closest=ClosestMilestoneInComponent(milestones[0]->connectedComponent,n->x);
+    if(space->Distance(closest->x,n->x) < connectionThreshold) {
+      if(TryConnect(closest,n)) //connection successful!
 	return true;
     }
   }
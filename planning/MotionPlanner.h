@@ -5,11 +5,14 @@
 #include <graph/UndirectedGraph.h>
 #include <graph/ConnectedComponents.h>
 #include <utils/SmartPointer.h>
+#include <utils/ThreadPool.h>
 #include <vector>
 #include <list>
 #include "CSpace.h"
 #include "EdgePlanner.h"
 #include "Path.h"
+#include "PointLocation.h"
+#include "PlannerStats.h"
 
 /** @defgroup MotionPlanning
  * @brief Classes to assist in motion planning.
@@ -17,6 +20,23 @@
 
 /** @ingroup MotionPlanning
  * @brief A base roadmap planner class.
+ *
+ * Neighbor queries are answered by the pointLocation index, which by
+ * default is a GNATPointLocation over the CSpace's distance metric.  It is
+ * kept in sync with roadmap.nodes lazily, so nodes should only be appended
+ * to the roadmap (or the roadmap cleared entirely).
+ *
+ * If numThreads > 1 and the space supports CSpace::Clone(), Generate()
+ * builds the roadmap in batches: the samples of a batch are drawn serially,
+ * their feasibility is tested in parallel, and the edges the serial
+ * algorithm would test are checked in parallel, speculatively, before the
+ * connections are replayed in serial order.  The roadmap is identical to
+ * that of a serial run, provided that IsFeasible() and the edge planners
+ * don't draw random numbers.  Edges are checked in the threads' clones of
+ * the space, but the roadmap stores new edge planners on space itself.
+ *
+ * The counts and times of the planner's operations are accumulated in
+ * stats.
  */
 class RoadmapPlanner
 {
@@ -24,7 +44,9 @@ public:
   typedef Graph::UndirectedGraph<Config,SmartPointer<EdgePlanner> > Roadmap;
 
   RoadmapPlanner(CSpace*);
+  RoadmapPlanner(const RoadmapPlanner&);
   virtual ~RoadmapPlanner();
+  const RoadmapPlanner& operator = (const RoadmapPlanner&);
   
   virtual void Cleanup();
   virtual void GenerateConfig(Config& x);
@@ -40,10 +62,22 @@ public:
   virtual void ConnectToNearestNeighbors(int i,int k,bool ccReject=true);
   virtual void Generate(int numSamples,Real connectionThreshold); 
   virtual void CreatePath(int i,int j,MilestonePath& path);
+  ///Adds any roadmap nodes not yet in pointLocation
+  void UpdatePointLocation();
+  ///Helper for Generate(): adds numSamples samples and connects them
+  ///using the thread pool.  Returns false if the space can't be cloned.
+  bool GenerateParallel(int numSamples,Real connectionThreshold);
 
   CSpace* space;
   Roadmap roadmap;
   Graph::ConnectedComponents ccs;
+  SmartPointer<PointLocationBase> pointLocation;
+  ///Number of threads used by Generate() (default 1)
+  int numThreads;
+  ///threadSpaces[t] is the space used by thread t>0 of threadPool
+  std::vector<SmartPointer<CSpace> > threadSpaces;
+  SmartPointer<ThreadPool> threadPool;
+  PlannerStats stats;
 };
 
 
@@ -54,6 +88,14 @@ public:
  * a connection may be made between them.  This is infinity by default.
  * If it is infinity, connections are attempted to the closest node in
  * a different component.
+ *
+ * Closest-milestone queries are answered by the pointLocation index, in
+ * which each milestone is stored under its Milestone::id.
+ *
+ * Nodes are allocated from nodePool, which is released by Cleanup().
+ *
+ * The counts and times of the planner's operations are accumulated in
+ * stats.
  */
 class TreeRoadmapPlanner
 {
@@ -62,6 +104,7 @@ public:
   {
     Config x;
     int connectedComponent;
+    int id;   ///< the milestone's id in pointLocation
   };
   
   typedef Graph::TreeNode<Milestone,SmartPointer<EdgePlanner> > Node;
@@ -79,7 +122,6 @@ public:
   virtual EdgePlanner* TryConnect(Node*,Node*);
   virtual void DeleteSubtree(Node* n);
   //helpers
-  //default implementation is O(n) search
   virtual Node* ClosestMilestone(const Config& x);
   virtual Node* ClosestMilestoneInComponent(int component,const Config& x);
   virtual Node* ClosestMilestoneInSubtree(Node* node,const Config& x);
@@ -92,6 +134,10 @@ public:
   CSpace* space;
   std::vector<Node*> connectedComponents;
   Real connectionThreshold;
+  SmartPointer<PointLocationBase> pointLocation;
+  std::vector<Node*> pointLocationNodes;  ///< maps ids to nodes, NULL if deleted
+  PlannerStats stats;
+  BlockPool nodePool;
   
   //temporary
   std::vector<Node*> milestones;
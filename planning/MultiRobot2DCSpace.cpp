@@ -187,7 +187,8 @@ Real MultiRobot2DCSpace::Distance(const Config& x, const Config& y)
   Real d2=0;
   for(size_t i=0;i<robots.size();i++,k+=stride) {
     d2 += Vector2(x(k+0),x(k+1)).distanceSquared(Vector2(y(k+0),y(k+1)));
-    d2 += Sqr(angleDistanceWeight)*Sqr(AngleDiff(x(k+2),y(k+2)));
+    if(allowRotation)
+      d2 += Sqr(angleDistanceWeight)*Sqr(AngleDiff(x(k+2),y(k+2)));
   }
   return Sqrt(d2);
 }
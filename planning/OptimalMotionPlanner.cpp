@@ -2,6 +2,7 @@
 #include <math/random.h>
 #include <Graph/Path.h>
 #include <Timer.h>
+#include <algorithm>
 
 class EdgeDistance
 {
@@ -15,7 +16,7 @@ class EdgeDistance
 
 
 PRMStarPlanner::PRMStarPlanner(CSpace* space)
-  :RoadmapPlanner(space),spp(roadmap),lazy(false),randomNeighbors(false),connectByRadius(false),connectRadiusConstant(1),connectionThreshold(Inf)
+  :RoadmapPlanner(space),spp(roadmap),lazy(false),randomNeighbors(false),connectByRadius(false),connectRadiusConstant(1),connectionThreshold(Inf),numCheckThreads(1),numPlanSteps(0)
 {}
 
 void PRMStarPlanner::Init(const Config& qstart,const Config& qgoal)
@@ -26,33 +27,25 @@ void PRMStarPlanner::Init(const Config& qstart,const Config& qgoal)
   spp.InitializeSource(start);  
 
   numPlanSteps = 0;
-  numEdgeChecks = 0;
-  tCheck=tKnn=tConnect=tLazy=0;
+  stats.Reset();
 }
 void PRMStarPlanner::PlanMore()
 {
   numPlanSteps ++;
   EdgeDistance distanceWeightFunc;
   Vector x;
-  Timer timer;
   GenerateConfig(x);
-  if(!space->IsFeasible(x)) {
-    tCheck += timer.ElapsedTime();
-    return;
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::Feasibility);
+    if(!space->IsFeasible(x)) return;
   }
-  tCheck += timer.ElapsedTime();
-  timer.Reset();
   int m = -1;
 
   vector<int> neighbors;
   if(connectByRadius) {
     Real rad = connectRadiusConstant*Pow(Log(Real(roadmap.nodes.size()))/Real(roadmap.nodes.size()),1.0/x.n);
     if(rad > connectionThreshold) rad = connectionThreshold;
-    KNN(x,1,neighbors);
-    int nearest = neighbors[0];
-    Neighbors(x,rad,neighbors);
-    if(neighbors.empty())
-      neighbors.push_back(nearest);
+    NeighborsOrNearest(x,rad,neighbors);
   }
   else {
     int kmax = int(((1.0+1.0/x.n)*E)*Log(Real(roadmap.nodes.size())));
@@ -61,8 +54,6 @@ void PRMStarPlanner::PlanMore()
       kmax = roadmap.nodes.size()-1;
     KNN(x,kmax,neighbors);
   }  
-  tKnn += timer.ElapsedTime();
-  timer.ElapsedTime();
 
   Real goalDist = spp.d[goal];
   for(size_t i=0;i<neighbors.size();i++) {
@@ -90,39 +81,47 @@ void PRMStarPlanner::PlanMore()
     if(!lazy || spp.d[n] + d < spp.d[m] || spp.d[m] + d < spp.d[n]) {
       e = space->LocalPlanner(x,xn);
       Assert(e->Space() != NULL);
-      if(!lazy) { numEdgeChecks++; if(e->IsVisible()) add=true; }
-      else add=true;
+      if(!lazy) {
+	PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck);
+	if(e->IsVisible()) add=true;
+      }
+      else {
+	//remembers whether the edge has been checked
+	e = new LazyEdgePlanner(e);
+	add=true;
+      }
     }
     if(add) {
       roadmap.AddEdge(m,n,e);
-      if(lazy) 
-	spp.DecreaseUpdate_Undirected(m,n,distanceWeightFunc);
+      //keeps spp.d[goal] up to date for IsConnected queries
+      PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
+      spp.DecreaseUpdate_Undirected(m,n,distanceWeightFunc);
     }
   }
-  tConnect += timer.ElapsedTime();
   if(lazy) {
     if(spp.d[goal] < goalDist) {
       //found an improved path to the goal! do checking
-      timer.Reset();
       CheckPath(start,goal);
-      tLazy += timer.ElapsedTime();
     }
   }
 }
 
 void PRMStarPlanner::Neighbors(const Config& x,Real rad,vector<int>& neighbors)
 {
-  set<pair<Real,int> > nn;
+  PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
   if(!randomNeighbors) {
     //radius rad neighbors
-    for(int i=0;i<roadmap.nodes.size();i++) {
-      Real d=space->Distance(roadmap.nodes[i],x);
-      if(d > 0 && d < rad) {
-	nn.insert(pair<Real,int>(d,i));
-      }
-    }
+    UpdatePointLocation();
+    vector<Real> distances;
+    pointLocation->Close(x,rad,neighbors,distances);
+    //skip points coincident with x
+    size_t n=0;
+    while(n<distances.size() && distances[n] <= 0) n++;
+    neighbors.erase(neighbors.begin(),neighbors.begin()+n);
+    return;
   }
   else {
+    set<pair<Real,int> > nn;
     int num = int(Log(Real(roadmap.nodes.size())));
     for(int k=0;k<num;k++) {
       int i = RandInt(roadmap.nodes.size());
@@ -131,34 +130,42 @@ void PRMStarPlanner::Neighbors(const Config& x,Real rad,vector<int>& neighbors)
 	nn.insert(pair<Real,int>(d,i));
       }
     }
+    neighbors.resize(0);
+    for(set<pair<Real,int> >::const_iterator j=nn.begin();j!=nn.end();j++) {
+      neighbors.push_back(j->second);
+    }
   }
-  neighbors.resize(0);
-  for(set<pair<Real,int> >::const_iterator j=nn.begin();j!=nn.end();j++) {
-    neighbors.push_back(j->second);
+}
+
+void PRMStarPlanner::NeighborsOrNearest(const Config& x,Real rad,vector<int>& neighbors)
+{
+  if(!randomNeighbors) {
+    Neighbors(x,rad,neighbors);
+    if(neighbors.empty()) KNN(x,1,neighbors);
+  }
+  else {
+    KNN(x,1,neighbors);
+    int nearest = neighbors[0];
+    Neighbors(x,rad,neighbors);
+    if(neighbors.empty())
+      neighbors.push_back(nearest);
   }
 }
 
 void PRMStarPlanner::KNN(const Config& x,int k,vector<int>& neighbors)
 {
+  PlannerStatTimer timer(&stats,PlannerStats::NearestNeighbor);
   //k nearest vs k random neighbors
   neighbors.resize(k);
   if(!randomNeighbors) {
-    set<pair<Real,int> > knn;
-    Real dmax = Inf;
-    for(int i=0;i<roadmap.nodes.size();i++) {
-      Real d=space->Distance(roadmap.nodes[i],x);
-      if(d > 0 && d < dmax) {
-	pair<Real,int> idx(d,i);
-	knn.insert(idx);
-	if((int)knn.size() > k)
-	  knn.erase(--knn.end());
-	dmax = (--knn.end())->first;
-      }
-    }
-    neighbors.resize(0);
-    for(set<pair<Real,int> >::const_iterator j=knn.begin();j!=knn.end();j++) {
-      neighbors.push_back(j->second);
-    }
+    UpdatePointLocation();
+    //ask for one extra, in case x coincides with a milestone
+    vector<Real> distances;
+    pointLocation->KNN(x,k+1,neighbors,distances);
+    size_t n=0;
+    while(n<distances.size() && distances[n] <= 0) n++;
+    neighbors.erase(neighbors.begin(),neighbors.begin()+n);
+    if((int)neighbors.size() > k) neighbors.resize(k);
   }
   else {
     set<pair<Real,int> > knn;
@@ -183,6 +190,7 @@ bool PRMStarPlanner::GetPath(MilestonePath& path)
 
 bool PRMStarPlanner::GetPath(int a,int b,vector<int>& nodes,MilestonePath& path)
 {
+  PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
   if(!lazy) {
     EdgeDistance distanceWeightFunc;
     spp.InitializeSource(a);
@@ -222,6 +230,11 @@ bool PRMStarPlanner::CheckPath(int a,int b)
       return false;
     }
     bool feas = true;
+    if(numCheckThreads > 1 && InitCheckThreads()) {
+      feas = CheckPathParallel(npath);
+      if(feas) return true;
+      continue;
+    }
     for(size_t k=0;k<path.edges.size();k++) {
       int i;
       if(k%2==0)
@@ -229,11 +242,16 @@ bool PRMStarPlanner::CheckPath(int a,int b)
       else
 	i=(int)path.edges.size()-1-(int)k/2;
       SmartPointer<EdgePlanner>* e = roadmap.FindEdge(npath[i],npath[i+1]);
-      numEdgeChecks++;
-      if(!(*e)->IsVisible()) {
+      bool visible;
+      {
+	PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck);
+	visible = (*e)->IsVisible();
+      }
+      if(!visible) {
 	//delete edge
 	//printf("Deleting edge %d %d...\n",npath[i],npath[i+1]);
 	roadmap.DeleteEdge(npath[i],npath[i+1]);
+	PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
 	spp.DeleteUpdate_Undirected(npath[i],npath[i+1],distanceWeightFunc);
 	//Assert(spp.HasShortestPaths_Undirected(0,distanceWeightFunc));
 	feas = false;
@@ -255,3 +273,106 @@ bool PRMStarPlanner::CheckPath(int a,int b)
   }
   return false;
 }
+
+//checks a set of edges, each thread in its own space, stopping all threads
+//once one edge fails.  Edges in the thread's space are checked with their
+//own planner, others with a new planner in the thread's space.
+class ParallelEdgeChecker : public ParallelForBody
+{
+ public:
+  ParallelEdgeChecker(ThreadPool& _pool,const vector<CSpace*>& _spaces,const vector<LazyEdgePlanner*>& _edges)
+    :pool(_pool),spaces(_spaces),edges(_edges),failed(false)
+  {}
+  bool Failed() {
+    pool.Lock();
+    bool res = failed;
+    pool.Unlock();
+    return res;
+  }
+  virtual void Run(int begin,int end,int thread)
+  {
+    for(int i=begin;i<end;i++) {
+      if(Failed()) return;
+      LazyEdgePlanner* e = edges[i];
+      if(e->Space() == spaces[thread])
+	e->IsVisible();
+      else {
+	EdgePlanner* ethread = spaces[thread]->LocalPlanner(e->Start(),e->Goal());
+	e->SetChecked(ethread->IsVisible());
+	delete ethread;
+      }
+      if(!e->visible) {
+	pool.Lock();
+	failed = true;
+	pool.Unlock();
+      }
+    }
+  }
+
+  ThreadPool& pool;
+  const vector<CSpace*>& spaces;
+  const vector<LazyEdgePlanner*>& edges;
+  //guarded by the pool's mutex
+  bool failed;
+};
+
+bool PRMStarPlanner::InitCheckThreads()
+{
+  if(checkSpaces.empty()) {
+    //thread 0 uses space itself
+    checkSpaces.push_back(space);
+    for(int t=1;t<numCheckThreads;t++) {
+      CSpace* clone = space->Clone();
+      if(!clone) break;
+      checkClones.push_back(clone);
+      checkSpaces.push_back(clone);
+    }
+    if(checkSpaces.size() > 1)
+      checkThreads = new ThreadPool((int)checkSpaces.size());
+  }
+  return checkSpaces.size() > 1;
+}
+
+bool PRMStarPlanner::CheckPathParallel(const vector<int>& npath)
+{
+  EdgeDistance distanceWeightFunc;
+  //only edges not checked in earlier rounds are dispatched, longest (most
+  //likely to fail) first
+  vector<LazyEdgePlanner*> pathEdges(npath.size()-1);
+  vector<pair<Real,int> > order;
+  for(size_t i=0;i+1<npath.size();i++) {
+    SmartPointer<EdgePlanner>* e = roadmap.FindEdge(npath[i],npath[i+1]);
+    Assert(e != NULL);
+    pathEdges[i] = dynamic_cast<LazyEdgePlanner*>((EdgePlanner*)*e);
+    if(!pathEdges[i]) {
+      //added by other means than PlanMore()
+      pathEdges[i] = new LazyEdgePlanner(*e);
+      *e = pathEdges[i];
+    }
+    if(!pathEdges[i]->checked)
+      order.push_back(pair<Real,int>(-space->Distance(roadmap.nodes[npath[i]],roadmap.nodes[npath[i+1]]),(int)i));
+  }
+  sort(order.begin(),order.end());
+  vector<LazyEdgePlanner*> edges(order.size());
+  for(size_t k=0;k<order.size();k++)
+    edges[k] = pathEdges[order[k].second];
+  ParallelEdgeChecker checker(*checkThreads,checkSpaces,edges);
+  {
+    PlannerStatTimer timer(&stats,PlannerStats::EdgeCheck,0);
+    checkThreads->ParallelFor((int)edges.size(),checker,1);
+    int numChecked = 0;
+    for(size_t k=0;k<edges.size();k++)
+      if(edges[k]->checked) numChecked++;
+    timer.SetCount(numChecked);
+  }
+  bool feasible = true;
+  for(size_t i=0;i<pathEdges.size();i++) {
+    if(pathEdges[i]->checked && !pathEdges[i]->visible) {
+      feasible = false;
+      roadmap.DeleteEdge(npath[i],npath[i+1]);
+      PlannerStatTimer searchTimer(&stats,PlannerStats::GraphSearch);
+      spp.DeleteUpdate_Undirected(npath[i],npath[i+1],distanceWeightFunc);
+    }
+  }
+  return feasible;
+}
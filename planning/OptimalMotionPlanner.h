@@ -3,7 +3,22 @@
 
 #include "MotionPlanner.h"
 #include <graph/ShortestPaths.h>
+#include <utils/ThreadPool.h>
 
+/** @ingroup MotionPlanning
+ * @brief The PRM* and Lazy-PRM* asymptotically optimal planners.
+ *
+ * Neighbor queries are answered by the RoadmapPlanner's pointLocation
+ * index, so each planning step takes time sublinear in the roadmap size.
+ *
+ * In lazy mode, roadmap edges are LazyEdgePlanners, which remember
+ * whether they have been checked.  With numCheckThreads > 1, the unchecked
+ * edges of each candidate path are checked in parallel, longest (most
+ * likely to fail) first, and the edges not yet started are skipped once
+ * one fails.  Each thread checks edges in its own clone of the space (see
+ * CSpace::Clone()).  If the space can't be cloned, paths are checked
+ * serially.
+ */
 class PRMStarPlanner : public RoadmapPlanner
 {
  public:
@@ -16,12 +31,22 @@ class PRMStarPlanner : public RoadmapPlanner
   void KNN(const Config& x,int k,vector<int>& nn);
   ///Helper: perform neighbor query limited by radius r
   void Neighbors(const Config& x,Real r,vector<int>& neighbors);
+  ///Helper: perform neighbor query limited by radius r, or if no
+  ///neighbors are within r, returns the nearest neighbor.  Requires only
+  ///a single index query in the common case.
+  void NeighborsOrNearest(const Config& x,Real r,vector<int>& neighbors);
   ///Helper: get path from start to goal
   bool GetPath(MilestonePath& path);
   ///Helper: get path from milestone a to b
   bool GetPath(int a,int b,vector<int>& nodes,MilestonePath& path);
   ///Helper: check feasibility of path from milestone a to b for lazy planning
   bool CheckPath(int a,int b);
+  ///Helper: checks the unchecked edges between the given nodes in
+  ///parallel, and deletes the infeasible ones.  Requires InitCheckThreads().
+  bool CheckPathParallel(const vector<int>& npath);
+  ///Helper: on the first call, clones the space for numCheckThreads
+  ///threads.  Returns false if the space can't be cloned.
+  bool InitCheckThreads();
 
   //configuration variables
   ///Set lazy to true if you wish to do lazy planning (default false)
@@ -38,15 +63,20 @@ class PRMStarPlanner : public RoadmapPlanner
   ///Set this value to limit the maximum distance of attempted
   ///connections
   Real connectionThreshold;
+  ///Number of threads used to check candidate paths in lazy mode
+  ///(default 1)
+  int numCheckThreads;
 
   int start,goal;
   typedef Graph::ShortestPathProblem<Config,SmartPointer<EdgePlanner> > ShortestPathProblem;
   ShortestPathProblem spp;
+  SmartPointer<ThreadPool> checkThreads;
+  ///The spaces used by the check threads: space itself, then its clones
+  vector<CSpace*> checkSpaces;
+  vector<SmartPointer<CSpace> > checkClones;
 
-  //statistics
+  ///Number of planning steps since Init().  Init() also resets stats.
   int numPlanSteps;
-  Real tCheck, tKnn, tConnect, tLazy;
-  int numEdgeChecks;
 };
 
 
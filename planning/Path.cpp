@@ -1,6 +1,9 @@
 #include "Path.h"
 #include <math/random.h>
+#include <utils/ThreadPool.h>
+#include <Timer.h>
 #include <errors.h>
+#include <algorithm>
 
 MilestonePath::MilestonePath()
 {}
@@ -129,6 +132,182 @@ int MilestonePath::Reduce(int numIters)
   return numsplices;
 }
 
+//checks the segments between pairs of configurations
+struct SegmentBatch : public ParallelForBody
+{
+  SegmentBatch(const vector<CSpace*>& _spaces,const vector<pair<const Config*,const Config*> >& _segments,const Timer& _timer,Real _timeLimit)
+    :spaces(_spaces),segments(_segments),timer(_timer),timeLimit(_timeLimit),visible(_segments.size(),0)
+  {}
+  virtual void Run(int begin,int end,int thread) {
+    //each segment reads its own copy of the timer, since ElapsedTime
+    //updates it.  Segments left once time runs out stay not visible
+    for(int k=begin;k<end;k++) {
+      Timer t=timer;
+      if(t.ElapsedTime() >= timeLimit) return;
+      EdgePlanner* e = spaces[thread]->LocalPlanner(*segments[k].first,*segments[k].second);
+      visible[k] = e->IsVisible();
+      delete e;
+    }
+  }
+  const vector<CSpace*>& spaces;
+  const vector<pair<const Config*,const Config*> >& segments;
+  const Timer& timer;
+  Real timeLimit;
+  vector<char> visible;
+};
+
+//a point x at parameter t of an edge.  left and right index the checked
+//segments from the edge's start to x and from x to the edge's goal, or
+//are -1
+struct ShortcutPoint
+{
+  int edge;
+  Real t;
+  Config x;
+  int left,right;
+};
+
+//a shortcut from point p1 to point p2, which shortens the path by gain
+struct ShortcutCandidate
+{
+  int p1,p2;
+  Real gain;
+};
+
+inline bool HigherGain(const ShortcutCandidate& a,const ShortcutCandidate& b)
+{
+  return a.gain > b.gain;
+}
+
+inline bool HigherFirstEdge(const pair<int,int>& a,const pair<int,int>& b)
+{
+  return a.first > b.first;
+}
+
+int MilestonePath::AnytimeReduce(Real timeLimit,int numThreads)
+{
+  //a shortcut joins points on different edges
+  if(edges.size() < 2) return 0;
+  CSpace* space=Space();
+  //thread 0 uses space itself
+  vector<SmartPointer<CSpace> > clones;
+  vector<CSpace*> spaces(1,space);
+  for(int t=1;t<numThreads;t++) {
+    CSpace* clone = space->Clone();
+    if(!clone) break;
+    clones.push_back(clone);
+    spaces.push_back(clone);
+  }
+  ThreadPool pool((int)spaces.size());
+  int numCandidates = 8*(int)spaces.size();
+
+  Timer timer;
+  int numsplices=0;
+  vector<Real> prefix;
+  vector<ShortcutPoint> points;
+  vector<ShortcutCandidate> candidates;
+  vector<pair<const Config*,const Config*> > splitSegments,shortcutSegments;
+  vector<char> usedEdges;
+  vector<pair<int,int> > accepted;
+  while(timer.ElapsedTime() < timeLimit) {
+    //prefix[i] is the length of edges 0...i-1
+    prefix.resize(edges.size()+1);
+    prefix[0] = 0;
+    for(size_t i=0;i<edges.size();i++)
+      prefix[i+1] = prefix[i] + space->Distance(edges[i]->Start(),edges[i]->Goal());
+
+    points.resize(2*numCandidates);
+    for(size_t k=0;k<points.size();k++) {
+      points[k].edge = rand()%edges.size();
+      points[k].t = Rand();
+      edges[points[k].edge]->Eval(points[k].t,points[k].x);
+      points[k].left = points[k].right = -1;
+    }
+    //pair up points on different edges, keeping the pairs that would
+    //shorten the path
+    candidates.resize(0);
+    for(int k=0;k<4*numCandidates && (int)candidates.size()<numCandidates;k++) {
+      ShortcutCandidate c;
+      c.p1 = rand()%points.size();
+      c.p2 = rand()%points.size();
+      if(points[c.p2].edge < points[c.p1].edge) swap(c.p1,c.p2);
+      const ShortcutPoint& a=points[c.p1];
+      const ShortcutPoint& b=points[c.p2];
+      if(a.edge == b.edge) continue;
+      Real newLength = space->Distance(edges[a.edge]->Start(),a.x) + space->Distance(a.x,b.x) + space->Distance(b.x,edges[b.edge]->Goal());
+      c.gain = prefix[b.edge+1]-prefix[a.edge]-newLength;
+      if(c.gain <= 0) continue;
+      candidates.push_back(c);
+    }
+    if(candidates.empty()) continue;
+
+    //check the shortcuts, best first
+    sort(candidates.begin(),candidates.end(),HigherGain);
+    shortcutSegments.resize(candidates.size());
+    for(size_t k=0;k<candidates.size();k++) {
+      shortcutSegments[k].first = &points[candidates[k].p1].x;
+      shortcutSegments[k].second = &points[candidates[k].p2].x;
+    }
+    SegmentBatch shortcuts(spaces,shortcutSegments,timer,timeLimit);
+    pool.ParallelFor((int)shortcutSegments.size(),shortcuts,1);
+
+    //for the visible shortcuts, check the segments joining the points to
+    //their edges, once per point
+    splitSegments.resize(0);
+    for(size_t k=0;k<candidates.size();k++) {
+      if(!shortcuts.visible[k]) continue;
+      ShortcutPoint& a=points[candidates[k].p1];
+      ShortcutPoint& b=points[candidates[k].p2];
+      if(a.left < 0) {
+	a.left = (int)splitSegments.size();
+	splitSegments.push_back(pair<const Config*,const Config*>(&edges[a.edge]->Start(),&a.x));
+      }
+      if(b.right < 0) {
+	b.right = (int)splitSegments.size();
+	splitSegments.push_back(pair<const Config*,const Config*>(&b.x,&edges[b.edge]->Goal()));
+      }
+    }
+    SegmentBatch splits(spaces,splitSegments,timer,timeLimit);
+    pool.ParallelFor((int)splitSegments.size(),splits,1);
+
+    //greedily take the best visible shortcuts whose spans of edges don't
+    //overlap
+    usedEdges.resize(0);
+    usedEdges.resize(edges.size(),0);
+    accepted.resize(0);
+    for(size_t k=0;k<candidates.size();k++) {
+      const ShortcutCandidate& c=candidates[k];
+      if(!shortcuts.visible[k]) continue;
+      if(!splits.visible[points[c.p1].left] || !splits.visible[points[c.p2].right]) continue;
+      int e1=points[c.p1].edge,e2=points[c.p2].edge;
+      bool overlap=false;
+      for(int e=e1;e<=e2;e++)
+	if(usedEdges[e]) { overlap=true; break; }
+      if(overlap) continue;
+      for(int e=e1;e<=e2;e++) usedEdges[e]=1;
+      accepted.push_back(pair<int,int>(e1,(int)k));
+    }
+    //splice from the back of the path, so the edge indices of the other
+    //shortcuts stay valid
+    sort(accepted.begin(),accepted.end(),HigherFirstEdge);
+    for(size_t k=0;k<accepted.size();k++) {
+      const ShortcutCandidate& c=candidates[accepted[k].second];
+      const ShortcutPoint& a=points[c.p1];
+      const ShortcutPoint& b=points[c.p2];
+      //replace edges a->a',...,b'->b with a->x1,x1->x2,x2->b
+      SmartPointer<EdgePlanner> e_ax1=space->LocalPlanner(edges[a.edge]->Start(),a.x);
+      SmartPointer<EdgePlanner> e_x1x2=space->LocalPlanner(a.x,b.x);
+      SmartPointer<EdgePlanner> e_x2b=space->LocalPlanner(b.x,edges[b.edge]->Goal());
+      edges.erase(edges.begin()+a.edge,edges.begin()+b.edge+1);
+      edges.insert(edges.begin()+a.edge,e_ax1);
+      edges.insert(edges.begin()+a.edge+1,e_x1x2);
+      edges.insert(edges.begin()+a.edge+2,e_x2b);
+    }
+    numsplices += (int)accepted.size();
+  }
+  return numsplices;
+}
+
 void MilestonePath::Discretize(Real h)
 {
   for(size_t i=0;i<edges.size();i++) {
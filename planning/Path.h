@@ -48,6 +48,17 @@ public:
   /// Tries to shorten the path by connecting random points
   /// with a shortcut, for numIters iterations.  Returns # of shortcuts
   int Reduce(int numIters);
+  /// Anytime, parallel version of Reduce.  Until timeLimit seconds have
+  /// passed, each round samples points on the path, checks shortcuts
+  /// between them on numThreads threads (using clones of the space), and
+  /// splices in the non-overlapping ones that shorten the path most.
+  /// Segments still unchecked when the time limit passes count as not
+  /// visible, so a round ends at the limit.  For the visible shortcuts,
+  /// the segments that connect a point to its edge's endpoints are
+  /// checked once per round and shared by all shortcuts through that
+  /// point.
+  /// Returns # of shortcuts.
+  int AnytimeReduce(Real timeLimit,int numThreads=1);
   /// Replaces the section of the path between milestones
   /// start and goal with a new path.  If the index is negative,
   /// erases the corresponding start/goal milestones too.
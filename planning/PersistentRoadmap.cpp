@@ -0,0 +1,389 @@
+#include "PersistentRoadmap.h"
+#include <myfile.h>
+#include <errors.h>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif //WIN32
+using namespace std;
+
+const static int kRoadmapMagic = 0x504d524b;  //'KRMP' in little-endian
+const static int kRoadmapVersion = 1;
+const static int kRoadmapHeaderSize = 6*sizeof(int);
+
+//sizes of the arrays following the header, in order
+inline size_t RoadmapFileSize(int dim,int numNodes,int numEdges)
+{
+  return kRoadmapHeaderSize
+    + sizeof(Real)*(size_t(numNodes)*dim + numEdges)
+    + sizeof(int)*(2*size_t(numEdges) + size_t(numNodes)+1 + 2*size_t(numEdges))
+    + size_t(numEdges);
+}
+
+//writes the roadmap file, computing the adjacency lists from edgeNodes
+static bool WriteRoadmap(const char* fn,int dim,int numNodes,int numEdges,const Real* nodes,const Real* edgeLengths,const int* edgeNodes,const unsigned char* edgeStatus)
+{
+  vector<int> start(numNodes+1,0),adjacency(2*numEdges);
+  for(int e=0;e<numEdges;e++) {
+    start[edgeNodes[2*e]+1]++;
+    start[edgeNodes[2*e+1]+1]++;
+  }
+  for(int i=0;i<numNodes;i++) start[i+1] += start[i];
+  vector<int> pos(start.begin(),start.end()-1);
+  for(int e=0;e<numEdges;e++) {
+    adjacency[pos[edgeNodes[2*e]]++] = e;
+    adjacency[pos[edgeNodes[2*e+1]]++] = e;
+  }
+
+  File f;
+  if(!f.Open(fn,FILEWRITE)) {
+    fprintf(stderr,"PersistentRoadmap: couldn't open %s for writing\n",fn);
+    return false;
+  }
+  int header[6] = {kRoadmapMagic,kRoadmapVersion,(int)sizeof(Real),dim,numNodes,numEdges};
+  if(!f.WriteData(header,sizeof(header))) return false;
+  if(!f.WriteData(nodes,sizeof(Real)*numNodes*dim)) return false;
+  if(!f.WriteData(edgeLengths,sizeof(Real)*numEdges)) return false;
+  if(!f.WriteData(edgeNodes,sizeof(int)*2*numEdges)) return false;
+  if(!f.WriteData(&start[0],sizeof(int)*(numNodes+1))) return false;
+  if(numEdges > 0 && !f.WriteData(&adjacency[0],sizeof(int)*2*numEdges)) return false;
+  if(!f.WriteData(edgeStatus,numEdges)) return false;
+  f.Close();
+  return true;
+}
+
+PersistentRoadmap::PersistentRoadmap()
+  :dim(0),numNodes(0),numEdges(0),
+   nodes(NULL),edgeLengths(NULL),edgeNodes(NULL),adjacencyStart(NULL),adjacency(NULL),edgeStatus(NULL),
+   numEdgeChecks(0),
+   data(NULL),dataSize(0),mapped(false)
+{}
+
+PersistentRoadmap::~PersistentRoadmap()
+{
+  Close();
+}
+
+bool PersistentRoadmap::Save(const RoadmapPlanner& planner,const char* fn,bool lazy)
+{
+  const RoadmapPlanner::Roadmap& roadmap = planner.roadmap;
+  int n = roadmap.NumNodes();
+  int d = (n > 0 ? roadmap.nodes[0].n : 0);
+  vector<Real> nodes(size_t(n)*d);
+  for(int i=0;i<n;i++) {
+    Assert(roadmap.nodes[i].n == d);
+    copy(roadmap.nodes[i].begin(),roadmap.nodes[i].end(),nodes.begin()+size_t(i)*d);
+  }
+  vector<Real> lengths;
+  vector<int> edgeNodes;
+  for(int i=0;i<n;i++) {
+    RoadmapPlanner::Roadmap::ConstEdgeIterator e;
+    for(e=roadmap.edges[i].begin();e!=roadmap.edges[i].end();e++) {
+      edgeNodes.push_back(i);
+      edgeNodes.push_back(e->first);
+      lengths.push_back(planner.space->Distance(roadmap.nodes[i],roadmap.nodes[e->first]));
+    }
+  }
+  int m = (int)lengths.size();
+  vector<unsigned char> status(m,(lazy ? Unchecked : Feasible));
+  return WriteRoadmap(fn,d,n,m,(n*d>0?&nodes[0]:NULL),(m>0?&lengths[0]:NULL),(m>0?&edgeNodes[0]:NULL),(m>0?&status[0]:NULL));
+}
+
+bool PersistentRoadmap::Save(const char* fn) const
+{
+  return WriteRoadmap(fn,dim,numNodes,numEdges,nodes,edgeLengths,edgeNodes,edgeStatus);
+}
+
+bool PersistentRoadmap::Load(const char* fn)
+{
+  Close();
+#ifndef WIN32
+  int fd = open(fn,O_RDONLY);
+  if(fd < 0) {
+    fprintf(stderr,"PersistentRoadmap: couldn't open %s\n",fn);
+    return false;
+  }
+  struct stat st;
+  if(fstat(fd,&st) != 0 || st.st_size < kRoadmapHeaderSize) {
+    fprintf(stderr,"PersistentRoadmap: %s is too short\n",fn);
+    close(fd);
+    return false;
+  }
+  dataSize = (size_t)st.st_size;
+  //a private writable mapping, so edge status can be updated in memory
+  //without touching the file
+  void* map = mmap(NULL,dataSize,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(map == MAP_FAILED) {
+    fprintf(stderr,"PersistentRoadmap: couldn't map %s\n",fn);
+    dataSize = 0;
+    return false;
+  }
+  data = map;
+  mapped = true;
+#else
+  File f;
+  if(!f.Open(fn,FILEREAD)) {
+    fprintf(stderr,"PersistentRoadmap: couldn't open %s\n",fn);
+    return false;
+  }
+  int len = f.Length();
+  if(len < kRoadmapHeaderSize) {
+    fprintf(stderr,"PersistentRoadmap: %s is too short\n",fn);
+    return false;
+  }
+  dataSize = (size_t)len;
+  data = malloc(dataSize);
+  if(!f.ReadData(data,len)) {
+    fprintf(stderr,"PersistentRoadmap: couldn't read %s\n",fn);
+    Close();
+    return false;
+  }
+  mapped = false;
+#endif //WIN32
+  if(!SetPointers(dataSize)) {
+    fprintf(stderr,"PersistentRoadmap: %s is not a valid roadmap file\n",fn);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool PersistentRoadmap::SetPointers(size_t size)
+{
+  const int* header = (const int*)data;
+  if(header[0] != kRoadmapMagic || header[1] != kRoadmapVersion || header[2] != (int)sizeof(Real)) return false;
+  if(header[3] < 0 || header[4] < 0 || header[5] < 0) return false;
+  //adjacency offsets go up to 2*numEdges
+  if(header[5] > INT_MAX/2) return false;
+  if(RoadmapFileSize(header[3],header[4],header[5]) != size) return false;
+  dim = header[3];
+  numNodes = header[4];
+  numEdges = header[5];
+  char* p = (char*)data + kRoadmapHeaderSize;
+  nodes = (Real*)p; p += sizeof(Real)*numNodes*dim;
+  edgeLengths = (Real*)p; p += sizeof(Real)*numEdges;
+  edgeNodes = (int*)p; p += sizeof(int)*2*numEdges;
+  adjacencyStart = (int*)p; p += sizeof(int)*(numNodes+1);
+  adjacency = (int*)p; p += sizeof(int)*2*numEdges;
+  edgeStatus = (unsigned char*)p;
+  return CheckIndices();
+}
+
+bool PersistentRoadmap::CheckIndices() const
+{
+  for(int e=0;e<2*numEdges;e++)
+    if(edgeNodes[e] < 0 || edgeNodes[e] >= numNodes) return false;
+  if(adjacencyStart[0] != 0 || adjacencyStart[numNodes] != 2*numEdges) return false;
+  for(int i=0;i<numNodes;i++)
+    if(adjacencyStart[i] > adjacencyStart[i+1]) return false;
+  for(int a=0;a<2*numEdges;a++)
+    if(adjacency[a] < 0 || adjacency[a] >= numEdges) return false;
+  for(int e=0;e<numEdges;e++)
+    if(edgeStatus[e] > Infeasible) return false;
+  return true;
+}
+
+void PersistentRoadmap::Close()
+{
+  if(data) {
+#ifndef WIN32
+    if(mapped) munmap(data,dataSize);
+    else free(data);
+#else
+    free(data);
+#endif //WIN32
+  }
+  data = NULL;
+  dataSize = 0;
+  mapped = false;
+  pointLocation = NULL;
+  dim = numNodes = numEdges = 0;
+  nodes = edgeLengths = NULL;
+  edgeNodes = adjacencyStart = adjacency = NULL;
+  edgeStatus = NULL;
+}
+
+void PersistentRoadmap::GetNode(int i,Config& x) const
+{
+  Assert(i >= 0 && i < numNodes);
+  x.setRef(nodes+size_t(i)*dim,dim);
+}
+
+void PersistentRoadmap::ResetValidity()
+{
+  if(numEdges > 0) memset(edgeStatus,Unchecked,numEdges);
+}
+
+//A temporary edge from the start or goal to a roadmap node
+struct QueryEdge
+{
+  int node;
+  Real length;
+  int status;
+};
+
+bool PersistentRoadmap::Plan(CSpace* space,const Config& start,const Config& goal,int k,MilestonePath& path)
+{
+  path.edges.clear();
+  if(!space->IsFeasible(start) || !space->IsFeasible(goal)) return false;
+
+  //the start and goal are nodes numNodes and numNodes+1, connected to
+  //their k nearest milestones (and to each other)
+  int s=numNodes,g=numNodes+1;
+  if(!pointLocation || pointLocation->space != space) {
+    pointLocation = new GNATPointLocation(space);
+    Config x;
+    for(int i=0;i<numNodes;i++) {
+      GetNode(i,x);
+      pointLocation->Add(i,x);
+    }
+  }
+  vector<QueryEdge> sEdges,gEdges;
+  vector<int> sNearest,gNearest;
+  vector<Real> sDist,gDist;
+  pointLocation->KNN(start,k,sNearest,sDist);
+  pointLocation->KNN(goal,k,gNearest,gDist);
+  QueryEdge qe;
+  qe.status = Unchecked;
+  for(size_t i=0;i<sNearest.size();i++) {
+    qe.node = sNearest[i]; qe.length = sDist[i];
+    sEdges.push_back(qe);
+  }
+  for(size_t i=0;i<gNearest.size();i++) {
+    qe.node = gNearest[i]; qe.length = gDist[i];
+    gEdges.push_back(qe);
+  }
+  //the direct edge is the last start edge
+  qe.node = g; qe.length = space->Distance(start,goal);
+  sEdges.push_back(qe);
+
+  //edges entering each node of the search are encoded as e >= 0 for
+  //roadmap edges, -1-i for sEdges[i], and -2-numNodes-i for gEdges[i]
+  //(gEdges are traversed from the milestone toward the goal)
+  vector<Real> d(numNodes+2);
+  vector<int> parent(numNodes+2);
+  vector<SmartPointer<EdgePlanner> > sPlanners(sEdges.size()),gPlanners(gEdges.size());
+  typedef pair<Real,int> QueueItem;
+  while(true) {
+    fill(d.begin(),d.end(),Inf);
+    fill(parent.begin(),parent.end(),-1);
+    priority_queue<QueueItem,vector<QueueItem>,greater<QueueItem> > q;
+    for(size_t i=0;i<sEdges.size();i++) {
+      if(sEdges[i].status == Infeasible) continue;
+      int v = sEdges[i].node;
+      if(sEdges[i].length < d[v]) {
+	d[v] = sEdges[i].length;
+	parent[v] = -1-(int)i;
+	q.push(QueueItem(d[v],v));
+      }
+    }
+    //goal edges, looked up by milestone
+    vector<int> gIndex(numNodes,-1);
+    for(size_t i=0;i<gEdges.size();i++)
+      if(gEdges[i].status != Infeasible) gIndex[gEdges[i].node] = (int)i;
+    while(!q.empty()) {
+      QueueItem item = q.top(); q.pop();
+      int u = item.second;
+      if(item.first > d[u]) continue;
+      if(u == g) break;
+      for(int a=adjacencyStart[u];a<adjacencyStart[u+1];a++) {
+	int e = adjacency[a];
+	if(edgeStatus[e] == Infeasible) continue;
+	int v = (edgeNodes[2*e]==u ? edgeNodes[2*e+1] : edgeNodes[2*e]);
+	Real dv = d[u] + edgeLengths[e];
+	if(dv < d[v]) {
+	  d[v] = dv;
+	  parent[v] = e;
+	  q.push(QueueItem(dv,v));
+	}
+      }
+      if(gIndex[u] >= 0) {
+	Real dv = d[u] + gEdges[gIndex[u]].length;
+	if(dv < d[g]) {
+	  d[g] = dv;
+	  parent[g] = -2-numNodes-gIndex[u];
+	  q.push(QueueItem(dv,g));
+	}
+      }
+    }
+    if(IsInf(d[g])) return false;
+
+    //walk back from the goal, collecting the path's nodes and edges
+    vector<int> pathNodes(1,g),pathEdges;
+    int v = g;
+    while(v != s) {
+      int e = parent[v];
+      pathEdges.push_back(e);
+      if(e >= 0) v = (edgeNodes[2*e]==v ? edgeNodes[2*e+1] : edgeNodes[2*e]);
+      else if(e >= -(int)sEdges.size()) v = s;
+      else v = gEdges[-2-numNodes-e].node;
+      pathNodes.push_back(v);
+    }
+    reverse(pathNodes.begin(),pathNodes.end());
+    reverse(pathEdges.begin(),pathEdges.end());
+
+    //check the unchecked edges on the path, and create the path's edge
+    //planners
+    vector<SmartPointer<EdgePlanner> > planners(pathEdges.size());
+    bool feasible = true;
+    Config a,b;
+    for(size_t i=0;i<pathEdges.size();i++) {
+      int e = pathEdges[i];
+      int u = pathNodes[i], w = pathNodes[i+1];
+      if(u == s) a.setRef(start); else GetNode(u,a);
+      if(w == g) b.setRef(goal); else GetNode(w,b);
+      if(e >= 0) {
+	planners[i] = space->LocalPlanner(a,b);
+	if(edgeStatus[e] == Unchecked) {
+	  numEdgeChecks++;
+	  edgeStatus[e] = (planners[i]->IsVisible() ? Feasible : Infeasible);
+	}
+	if(edgeStatus[e] == Infeasible) { feasible = false; break; }
+      }
+      else {
+	QueryEdge* qe;
+	SmartPointer<EdgePlanner>* qp;
+	if(e >= -(int)sEdges.size()) { qe = &sEdges[-1-e]; qp = &sPlanners[-1-e]; }
+	else { qe = &gEdges[-2-numNodes-e]; qp = &gPlanners[-2-numNodes-e]; }
+	if(qe->status == Unchecked) {
+	  *qp = space->LocalPlanner(a,b);
+	  numEdgeChecks++;
+	  qe->status = ((*qp)->IsVisible() ? Feasible : Infeasible);
+	}
+	if(qe->status == Infeasible) { feasible = false; break; }
+	planners[i] = *qp;
+      }
+    }
+    if(feasible) {
+      //the planners hold copies of their endpoints, so the path stays valid
+      //after the roadmap is closed
+      path.edges = planners;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PersistentRoadmap::GetRoadmap(RoadmapPlanner& planner) const
+{
+  planner.Cleanup();
+  Config x;
+  for(int i=0;i<numNodes;i++) {
+    GetNode(i,x);
+    planner.AddMilestone(Config(x));
+  }
+  for(int e=0;e<numEdges;e++) {
+    if(edgeStatus[e] == Infeasible) continue;
+    int i=edgeNodes[2*e],j=edgeNodes[2*e+1];
+    planner.ConnectEdge(i,j,planner.space->LocalPlanner(planner.roadmap.nodes[i],planner.roadmap.nodes[j]));
+  }
+}
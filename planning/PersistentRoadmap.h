@@ -0,0 +1,94 @@
+#ifndef PERSISTENT_ROADMAP_H
+#define PERSISTENT_ROADMAP_H
+
+#include "MotionPlanner.h"
+#include "PointLocation.h"
+#include <vector>
+
+/** @ingroup MotionPlanning
+ * @brief A roadmap stored in a compact binary file, for answering many
+ * queries in the same static environment.
+ *
+ * A roadmap built by a RoadmapPlanner (or PRMStarPlanner) is written with
+ * Save().  Load() maps the file into memory, and rejects it unless its
+ * node and edge indices are in range.  The first Plan() call
+ * reads all the milestones once, into a GNAT nearest-neighbor index over
+ * the space's metric, and later calls only read the edges and milestones
+ * that their searches touch.  The mapping is private: edge status changes
+ * made while planning are not written back unless Save() is called.
+ *
+ * Each edge has a status of unchecked, feasible, or infeasible.  Plan()
+ * connects the start and goal to their nearest milestones and searches
+ * for the shortest path over the edges not known to be infeasible,
+ * checking only the unchecked edges on the candidate path (as in lazy
+ * PRM) until a path of checked edges is found.  When the environment
+ * changes, ResetValidity() marks all edges unchecked and they are
+ * re-validated on demand by later queries.
+ *
+ * The file holds a header {'KRMP',version,sizeof(Real),dim,numNodes,
+ * numEdges} of ints, followed by the arrays nodes, edgeLengths, edgeNodes,
+ * adjacencyStart, adjacency, and edgeStatus.
+ */
+class PersistentRoadmap
+{
+public:
+  enum { Unchecked=0, Feasible=1, Infeasible=2 };
+
+  PersistentRoadmap();
+  ~PersistentRoadmap();
+  ///Saves the roadmap of the planner.  If lazy is true, the edges are
+  ///saved as unchecked (e.g., for the roadmap of a lazy PRM* planner),
+  ///otherwise as feasible.
+  static bool Save(const RoadmapPlanner& planner,const char* fn,bool lazy=false);
+  ///Saves this roadmap, with its current edge status
+  bool Save(const char* fn) const;
+  bool Load(const char* fn);
+  void Close();
+
+  inline int NumNodes() const { return numNodes; }
+  inline int NumEdges() const { return numEdges; }
+  ///Sets x to refer to node i's data in the mapped file
+  void GetNode(int i,Config& x) const;
+  ///Marks all edges unchecked, e.g., after the environment has changed
+  void ResetValidity();
+  ///Connects start and goal to their k nearest milestones and returns the
+  ///shortest feasible path between them in path.  Unchecked edges are
+  ///checked lazily using the space's local planner.  The nearest
+  ///milestones are found with an index built on the first call (and again
+  ///if the space changes), so space->Distance must be a metric.
+  bool Plan(CSpace* space,const Config& start,const Config& goal,int k,MilestonePath& path);
+  ///Copies the milestones and the edges not known to be infeasible into
+  ///the planner's roadmap
+  void GetRoadmap(RoadmapPlanner& planner) const;
+
+  int dim,numNodes,numEdges;
+  ///Milestone i is nodes[i*dim...(i+1)*dim-1]
+  Real* nodes;
+  ///Length of each edge in the space's metric
+  Real* edgeLengths;
+  ///Edge e connects nodes edgeNodes[2*e] and edgeNodes[2*e+1]
+  int* edgeNodes;
+  ///The edges adjacent to node i are adjacency[adjacencyStart[i]...
+  ///adjacencyStart[i+1]-1]
+  int* adjacencyStart;
+  int* adjacency;
+  ///Unchecked, Feasible, or Infeasible for each edge
+  unsigned char* edgeStatus;
+
+  ///Number of edges checked by Plan()
+  int numEdgeChecks;
+
+private:
+  bool SetPointers(size_t size);
+  ///Returns false if the edge nodes, adjacency lists or edge status are
+  ///out of range
+  bool CheckIndices() const;
+
+  void* data;
+  size_t dataSize;
+  bool mapped;
+  ///Index of the milestones, built by Plan()
+  SmartPointer<PointLocationBase> pointLocation;
+};
+
+#endif
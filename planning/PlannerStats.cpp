@@ -0,0 +1,37 @@
+#include "PlannerStats.h"
+
+const static char* kOperationNames[PlannerStats::NumOperations] = {"sample","feasibility","edgeCheck","nearestNeighbor","graphSearch"};
+
+PlannerStats::PlannerStats()
+{
+  Reset();
+}
+
+void PlannerStats::Reset()
+{
+  for(int i=0;i<NumOperations;i++) {
+    count[i] = 0;
+    time[i] = 0;
+  }
+}
+
+void PlannerStats::Add(const PlannerStats& stats)
+{
+  for(int i=0;i<NumOperations;i++)
+    Add(i,stats.count[i],stats.time[i]);
+}
+
+void PlannerStats::Get(StatDatabase& db) const
+{
+#if PLANNER_STATS
+  for(int i=0;i<NumOperations;i++) {
+    db.Increment(kOperationNames[i],count[i]);
+    db.AddValue(kOperationNames[i],"time",time[i]);
+  }
+#endif
+}
+
+const char* PlannerStats::OperationName(int op)
+{
+  return kOperationNames[op];
+}
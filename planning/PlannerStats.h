@@ -0,0 +1,66 @@
+#ifndef PLANNER_STATS_H
+#define PLANNER_STATS_H
+
+#include <utils/StatCollector.h>
+#include <Timer.h>
+
+/// Define PLANNER_STATS to 0 to compile out the planners' instrumentation.
+/// PlannerStatTimer then does nothing, and the counts stay zero.
+#ifndef PLANNER_STATS
+#define PLANNER_STATS 1
+#endif
+
+/** @ingroup MotionPlanning
+ * @brief Counts and cumulative times of the basic operations of a
+ * sample-based planner.
+ *
+ * Planners time each operation with a PlannerStatTimer.  Operations run
+ * on a thread pool are added once the pool is done, with the wall-clock
+ * time of the parallel section.  Operations nest: e.g., the time of an
+ * edge check includes the feasibility tests made by its edge planner, but
+ * these tests are not counted under Feasibility.
+ */
+struct PlannerStats
+{
+  enum Operation { Sample, Feasibility, EdgeCheck, NearestNeighbor, GraphSearch, NumOperations };
+
+  PlannerStats();
+  void Reset();
+  inline void Add(int op,int num,double t) { count[op]+=num; time[op]+=t; }
+  void Add(const PlannerStats& stats);
+  ///Adds the counts and times to db.  The count of operation op is
+  ///stored under OperationName(op), and its time in seconds in the value
+  ///of the "time" child, e.g., "nearestNeighbor:time".  Nothing is added
+  ///if PLANNER_STATS is 0.
+  void Get(StatDatabase& db) const;
+  static const char* OperationName(int op);
+
+  int count[NumOperations];
+  double time[NumOperations];
+};
+
+/** @ingroup MotionPlanning
+ * @brief Adds the time until its destruction to num operations of a
+ * PlannerStats, if it isn't NULL.
+ *
+ * For a batch of operations run on a thread pool, num is the size of the
+ * batch, or is set with SetCount() once the pool is done.
+ */
+class PlannerStatTimer
+{
+ public:
+#if PLANNER_STATS
+  PlannerStatTimer(PlannerStats* _stats,int _op,int _num=1) :stats(_stats),op(_op),num(_num) {}
+  ~PlannerStatTimer() { if(stats) stats->Add(op,num,timer.ElapsedTime()); }
+  void SetCount(int _num) { num = _num; }
+
+  PlannerStats* stats;
+  int op,num;
+  Timer timer;
+#else
+  PlannerStatTimer(PlannerStats* _stats,int _op,int _num=1) {}
+  void SetCount(int _num) {}
+#endif
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include "PointLocation.h"
+#include <errors.h>
+#include <algorithm>
+using namespace std;
+
+PointLocationBase::PointLocationBase(CSpace* _space)
+  :space(_space)
+{}
+
+int PointLocationBase::NN(const Config& x,Real& dist,Filter* filter)
+{
+  vector<int> ids;
+  vector<Real> dists;
+  KNN(x,1,ids,dists,filter);
+  if(ids.empty()) {
+    dist = Inf;
+    return -1;
+  }
+  dist = dists[0];
+  return ids[0];
+}
+
+
+
+NaivePointLocation::NaivePointLocation(CSpace* space)
+  :PointLocationBase(space)
+{}
+
+void NaivePointLocation::Clear()
+{
+  ids.clear();
+  points.clear();
+}
+
+void NaivePointLocation::Add(int id,const Config& x)
+{
+  ids.push_back(id);
+  points.push_back(x);
+}
+
+bool NaivePointLocation::Remove(int id)
+{
+  for(size_t i=0;i<ids.size();i++) {
+    if(ids[i] == id) {
+      ids[i] = ids.back();
+      points[i] = points.back();
+      ids.resize(ids.size()-1);
+      points.resize(points.size()-1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void NaivePointLocation::KNN(const Config& x,int k,vector<int>& nn,vector<Real>& dists,Filter* filter)
+{
+  vector<pair<Real,int> > candidates;
+  candidates.reserve(ids.size());
+  for(size_t i=0;i<ids.size();i++) {
+    if(filter && !filter->Accept(ids[i])) continue;
+    candidates.push_back(pair<Real,int>(space->Distance(x,points[i]),ids[i]));
+  }
+  if(k > (int)candidates.size()) k = (int)candidates.size();
+  partial_sort(candidates.begin(),candidates.begin()+k,candidates.end());
+  nn.resize(k);
+  dists.resize(k);
+  for(int i=0;i<k;i++) {
+    dists[i] = candidates[i].first;
+    nn[i] = candidates[i].second;
+  }
+}
+
+void NaivePointLocation::Close(const Config& x,Real r,vector<int>& nn,vector<Real>& dists,Filter* filter)
+{
+  vector<pair<Real,int> > candidates;
+  for(size_t i=0;i<ids.size();i++) {
+    if(filter && !filter->Accept(ids[i])) continue;
+    Real d = space->Distance(x,points[i]);
+    if(d < r) candidates.push_back(pair<Real,int>(d,ids[i]));
+  }
+  sort(candidates.begin(),candidates.end());
+  nn.resize(candidates.size());
+  dists.resize(candidates.size());
+  for(size_t i=0;i<candidates.size();i++) {
+    dists[i] = candidates[i].first;
+    nn[i] = candidates[i].second;
+  }
+}
+
+
+
+struct GNATPointLocation::Node
+{
+  Node() : unsplittable(false) {}
+  ~Node() {
+    for(size_t i=0;i<children.size();i++) delete children[i];
+  }
+  inline bool IsLeaf() const { return pivots.empty(); }
+
+  ///leaf data: the entries stored in this leaf
+  vector<int> entries;
+  ///set if all the entries in this leaf coincide
+  bool unsplittable;
+  ///internal node data: the pivot entries and their subtrees
+  vector<int> pivots;
+  vector<Node*> children;
+  ///dmin[i*m+j],dmax[i*m+j] give the range of distances from pivot i to
+  ///all points in the subtree of child j
+  vector<Real> dmin,dmax;
+};
+
+/* A k-nearest or radius query.  Results are kept in a max-heap by distance
+ * so that the current pruning radius is at the front.  k=0 means unlimited.
+ */
+struct GNATPointLocation::Query
+{
+  Query(int _k,Real _r,Filter* _filter) : k(_k),r(_r),filter(_filter) {}
+  inline Real Radius() const {
+    if(k > 0 && (int)heap.size() == k) return heap.front().first;
+    return r;
+  }
+  inline void Add(Real d,int id) {
+    if(!(d < Radius())) return;
+    heap.push_back(pair<Real,int>(d,id));
+    push_heap(heap.begin(),heap.end());
+    if(k > 0 && (int)heap.size() > k) {
+      pop_heap(heap.begin(),heap.end());
+      heap.resize(heap.size()-1);
+    }
+  }
+  void GetResults(vector<int>& ids,vector<Real>& dists) {
+    sort_heap(heap.begin(),heap.end());
+    ids.resize(heap.size());
+    dists.resize(heap.size());
+    for(size_t i=0;i<heap.size();i++) {
+      dists[i] = heap[i].first;
+      ids[i] = heap[i].second;
+    }
+  }
+
+  int k;
+  Real r;
+  Filter* filter;
+  vector<pair<Real,int> > heap;
+};
+
+GNATPointLocation::GNATPointLocation(CSpace* space,int _degree,int _maxLeafSize)
+  :PointLocationBase(space),degree(_degree),maxLeafSize(_maxLeafSize),root(new Node),numRemoved(0)
+{
+  Assert(degree >= 2);
+  Assert(maxLeafSize >= degree);
+}
+
+GNATPointLocation::~GNATPointLocation()
+{
+  delete root;
+}
+
+void GNATPointLocation::Clear()
+{
+  delete root;
+  root = new Node;
+  points.clear();
+  entryIds.clear();
+  idEntries.clear();
+  numRemoved = 0;
+}
+
+void GNATPointLocation::Add(int id,const Config& x)
+{
+  Assert(id >= 0);
+  if(id >= (int)idEntries.size()) idEntries.resize(id+1,-1);
+  else if(idEntries[id] >= 0) Remove(id);
+  int e = (int)points.size();
+  points.push_back(x);
+  entryIds.push_back(id);
+  idEntries[id] = e;
+  Insert(root,e);
+}
+
+bool GNATPointLocation::Remove(int id)
+{
+  if(id < 0 || id >= (int)idEntries.size() || idEntries[id] < 0) return false;
+  //entries are only marked as removed, since they may be used as pivots
+  entryIds[idEntries[id]] = -1;
+  idEntries[id] = -1;
+  numRemoved++;
+  if(numRemoved > maxLeafSize && numRemoved*2 > (int)points.size())
+    Rebuild();
+  return true;
+}
+
+void GNATPointLocation::Rebuild()
+{
+  deque<Config> oldPoints;
+  vector<int> oldIds;
+  oldPoints.swap(points);
+  oldIds.swap(entryIds);
+  Clear();
+  for(size_t e=0;e<oldIds.size();e++) {
+    if(oldIds[e] < 0) continue;
+    if(oldIds[e] >= (int)idEntries.size()) idEntries.resize(oldIds[e]+1,-1);
+    idEntries[oldIds[e]] = (int)points.size();
+    root->entries.push_back((int)points.size());
+    points.push_back(oldPoints[e]);
+    entryIds.push_back(oldIds[e]);
+  }
+  //bulk build
+  if((int)root->entries.size() > maxLeafSize)
+    Split(root);
+}
+
+void GNATPointLocation::KNN(const Config& x,int k,vector<int>& ids,vector<Real>& dists,Filter* filter)
+{
+  if(k <= 0) {
+    ids.resize(0);
+    dists.resize(0);
+    return;
+  }
+  Query q(k,Inf,filter);
+  Search(root,x,q);
+  q.GetResults(ids,dists);
+}
+
+void GNATPointLocation::Close(const Config& x,Real r,vector<int>& ids,vector<Real>& dists,Filter* filter)
+{
+  Query q(0,r,filter);
+  Search(root,x,q);
+  q.GetResults(ids,dists);
+}
+
+void GNATPointLocation::Insert(Node* n,int e)
+{
+  const Config& x=points[e];
+  vector<Real> d;
+  while(!n->IsLeaf()) {
+    int m=(int)n->pivots.size();
+    d.resize(m);
+    int best=0;
+    for(int i=0;i<m;i++) {
+      d[i] = space->Distance(points[n->pivots[i]],x);
+      if(d[i] < d[best]) best=i;
+    }
+    for(int i=0;i<m;i++) {
+      if(d[i] < n->dmin[i*m+best]) n->dmin[i*m+best] = d[i];
+      if(d[i] > n->dmax[i*m+best]) n->dmax[i*m+best] = d[i];
+    }
+    n = n->children[best];
+  }
+  n->entries.push_back(e);
+  if(n->unsplittable && space->Distance(points[n->entries[0]],x) > 0)
+    n->unsplittable = false;
+  if(!n->unsplittable && (int)n->entries.size() > maxLeafSize)
+    Split(n);
+}
+
+void GNATPointLocation::Split(Node* n)
+{
+  Assert(n->IsLeaf());
+  //discard removed entries
+  vector<int> E;
+  E.reserve(n->entries.size());
+  for(size_t i=0;i<n->entries.size();i++)
+    if(entryIds[n->entries[i]] >= 0) E.push_back(n->entries[i]);
+  n->entries.swap(E);
+  int N=(int)E.size();
+  if(N <= maxLeafSize) return;
+
+  //pick pivots by the farthest-point heuristic
+  vector<vector<Real> > dist;
+  vector<int> pivotIndices;
+  vector<Real> dset(N,Inf);
+  int next=0;
+  for(int i=0;i<degree;i++) {
+    pivotIndices.push_back(next);
+    dist.resize(i+1);
+    dist[i].resize(N);
+    const Config& p=points[E[next]];
+    for(int j=0;j<N;j++) {
+      dist[i][j] = space->Distance(p,points[E[j]]);
+      if(dist[i][j] < dset[j]) dset[j] = dist[i][j];
+    }
+    next = 0;
+    for(int j=1;j<N;j++)
+      if(dset[j] > dset[next]) next=j;
+    //all remaining points coincide with a pivot
+    if(dset[next] <= 0) break;
+  }
+  int m=(int)pivotIndices.size();
+  if(m < 2) {
+    n->unsplittable = true;
+    return;
+  }
+
+  n->pivots.resize(m);
+  n->children.resize(m);
+  n->dmin.assign(m*m,Inf);
+  n->dmax.assign(m*m,-Inf);
+  vector<bool> isPivot(N,false);
+  for(int i=0;i<m;i++) {
+    n->pivots[i] = E[pivotIndices[i]];
+    n->children[i] = new Node;
+    isPivot[pivotIndices[i]] = true;
+  }
+  for(int j=0;j<N;j++) {
+    if(isPivot[j]) continue;
+    int best=0;
+    for(int i=1;i<m;i++)
+      if(dist[i][j] < dist[best][j]) best=i;
+    for(int i=0;i<m;i++) {
+      if(dist[i][j] < n->dmin[i*m+best]) n->dmin[i*m+best] = dist[i][j];
+      if(dist[i][j] > n->dmax[i*m+best]) n->dmax[i*m+best] = dist[i][j];
+    }
+    n->children[best]->entries.push_back(E[j]);
+  }
+  vector<int>().swap(n->entries);
+  for(int i=0;i<m;i++)
+    if((int)n->children[i]->entries.size() > maxLeafSize)
+      Split(n->children[i]);
+}
+
+void GNATPointLocation::Search(Node* n,const Config& x,Query& q)
+{
+  if(n->IsLeaf()) {
+    for(size_t i=0;i<n->entries.size();i++) {
+      int id=entryIds[n->entries[i]];
+      if(id < 0) continue;
+      if(q.filter && !q.filter->Accept(id)) continue;
+      q.Add(space->Distance(x,points[n->entries[i]]),id);
+    }
+    return;
+  }
+  int m=(int)n->pivots.size();
+  vector<Real> d(m);
+  vector<pair<Real,int> > order(m);
+  for(int i=0;i<m;i++) {
+    d[i] = space->Distance(x,points[n->pivots[i]]);
+    order[i].first = d[i];
+    order[i].second = i;
+    int id=entryIds[n->pivots[i]];
+    if(id >= 0 && (!q.filter || q.filter->Accept(id)))
+      q.Add(d[i],id);
+  }
+  //visit the subtrees with the closest pivots first
+  sort(order.begin(),order.end());
+  for(int k=0;k<m;k++) {
+    int j=order[k].second;
+    Real r=q.Radius();
+    bool prune=false;
+    //triangle inequality: points in subtree j are at least
+    //max(d[i]-dmax,dmin-d[i]) away from x
+    for(int i=0;i<m;i++) {
+      if(d[i]-r >= n->dmax[i*m+j] || d[i]+r <= n->dmin[i*m+j]) {
+	prune=true;
+	break;
+      }
+    }
+    if(!prune) Search(n->children[j],x,q);
+  }
+}
@@ -0,0 +1,114 @@
+#ifndef PLANNING_POINT_LOCATION_H
+#define PLANNING_POINT_LOCATION_H
+
+#include "CSpace.h"
+#include <vector>
+#include <deque>
+
+/** @ingroup MotionPlanning
+ * @brief A nearest-neighbor index over configurations, measured with
+ * the CSpace's Distance function.
+ *
+ * Points are identified by user-supplied integer ids (nonnegative, and
+ * preferably dense, since some implementations use them as array indices).
+ * Points may be added and removed incrementally.  All query results are
+ * sorted by increasing distance.
+ *
+ * An optional Filter restricts a query to the ids for which Accept()
+ * returns true, e.g., to search only within a single connected component.
+ */
+class PointLocationBase
+{
+ public:
+  struct Filter
+  {
+    virtual ~Filter() {}
+    virtual bool Accept(int id)=0;
+  };
+
+  PointLocationBase(CSpace* space);
+  virtual ~PointLocationBase() {}
+  ///Removes all points
+  virtual void Clear()=0;
+  ///Adds the point x with the given id
+  virtual void Add(int id,const Config& x)=0;
+  ///Removes the point with the given id.  Returns false if it's not present
+  virtual bool Remove(int id)=0;
+  ///Returns the number of points currently stored
+  virtual int Size() const=0;
+  ///Returns the id of the closest point to x, or -1 if none exists.
+  ///The distance is returned in dist.
+  virtual int NN(const Config& x,Real& dist,Filter* filter=NULL);
+  ///Returns the ids and distances of the k closest points to x
+  virtual void KNN(const Config& x,int k,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL)=0;
+  ///Returns the ids and distances of all points closer than r to x
+  virtual void Close(const Config& x,Real r,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL)=0;
+
+  CSpace* space;
+};
+
+/** @ingroup MotionPlanning
+ * @brief Brute-force point location.  O(n) queries, but has no overhead
+ * and works with any distance function.
+ */
+class NaivePointLocation : public PointLocationBase
+{
+ public:
+  NaivePointLocation(CSpace* space);
+  virtual void Clear();
+  virtual void Add(int id,const Config& x);
+  virtual bool Remove(int id);
+  virtual int Size() const { return (int)points.size(); }
+  virtual void KNN(const Config& x,int k,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL);
+  virtual void Close(const Config& x,Real r,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL);
+
+  std::vector<int> ids;
+  std::vector<Config> points;
+};
+
+/** @ingroup MotionPlanning
+ * @brief Point location with a Geometric Near-neighbor Access Tree (GNAT).
+ *
+ * Works for any CSpace::Distance that is a metric (i.e., satisfies the
+ * triangle inequality).  Each internal node splits its points amongst
+ * up to 'degree' pivots, and stores the range of distances from each pivot
+ * to the points of each child subtree, which is used to prune subtrees
+ * during queries.  Leaves are split once they contain more than
+ * maxLeafSize points.
+ *
+ * Removed points are only marked as removed.  The tree is rebuilt once
+ * more than half of its points have been removed.
+ */
+class GNATPointLocation : public PointLocationBase
+{
+ public:
+  struct Node;
+
+  GNATPointLocation(CSpace* space,int degree=8,int maxLeafSize=32);
+  virtual ~GNATPointLocation();
+  virtual void Clear();
+  virtual void Add(int id,const Config& x);
+  virtual bool Remove(int id);
+  virtual int Size() const { return (int)points.size()-numRemoved; }
+  virtual void KNN(const Config& x,int k,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL);
+  virtual void Close(const Config& x,Real r,std::vector<int>& ids,std::vector<Real>& dists,Filter* filter=NULL);
+  ///Rebuilds the tree from scratch, discarding removed points
+  void Rebuild();
+
+  int degree;
+  int maxLeafSize;
+
+ private:
+  struct Query;
+  void Insert(Node* n,int e);
+  void Split(Node* n);
+  void Search(Node* n,const Config& x,Query& q);
+
+  Node* root;
+  std::deque<Config> points;    //indexed by entry
+  std::vector<int> entryIds;    //entry -> id, -1 if removed
+  std::vector<int> idEntries;   //id -> entry, -1 if not present
+  int numRemoved;
+};
+
+#endif
@@ -13,6 +13,7 @@ public:
   void DrawRobotGL(const Config& q) const;
   void DrawGL(const Config& q) const;
 
+  virtual CSpace* Clone() const { return CloneExact(this); }
   virtual void Sample(Config& x);
   virtual void SampleNeighborhood(const Config& c,Real r,Config& x);
   virtual int NumObstacles();
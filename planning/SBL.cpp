@@ -17,6 +17,7 @@ void SBLPlanner::Cleanup()
   SafeDelete(tStart);
   SafeDelete(tGoal);
   outputPath.clear();
+  nodePool.Clear();
   numIters=0;
 }
 
@@ -25,6 +26,8 @@ void SBLPlanner::Init(const Config& qStart,const Config& qGoal)
   Assert(!tStart && !tGoal);
   tStart = new SBLTreeWithIndex(space);
   tGoal = new SBLTreeWithIndex(space);
+  tStart->stats = tGoal->stats = &stats;
+  tStart->nodePool = tGoal->nodePool = &nodePool;
   tStart->Init(qStart);
   tGoal->Init(qGoal);
   //cout<<"SBL: Distance "<<space->Distance(qStart,qGoal)<<endl;
@@ -90,6 +93,8 @@ void SBLPlannerWithGrid::Init(const Config& qStart,const Config& qGoal)
   SBLTreeWithGrid* g= new SBLTreeWithGrid(space);
   tStart = s;
   tGoal = g;
+  s->stats = g->stats = &stats;
+  s->nodePool = g->nodePool = &nodePool;
   s->Init(qStart);
   g->Init(qGoal);
 
@@ -143,6 +148,7 @@ void SBLPRT::Cleanup()
   for(size_t i=0;i<roadmap.nodes.size();i++)
     delete roadmap.nodes[i];
   roadmap.Cleanup();
+  nodePool.Clear();
   numIters=0;
 }
 
@@ -150,6 +156,8 @@ int SBLPRT::AddSeed(const Config& q)
 {
   //SBLTree* t = new SBLTreeWithIndex(space);
   SBLTreeWithGrid* t = new SBLTreeWithGrid(space);
+  t->stats = &stats;
+  t->nodePool = &nodePool;
   t->A.h.resize(q.n,0.1);
   t->RandomizeSubset();
   ccs.AddNode();
@@ -270,6 +278,8 @@ void SBLPRT::CreatePath(int i,int j,MilestonePath& path)
 {
   Assert(i >= 0 && i < (int)roadmap.nodes.size());
   Assert(j >= 0 && j < (int)roadmap.nodes.size());
+  PlannerStatTimer timer(&stats,PlannerStats::GraphSearch);
+  path.edges.clear();
   ConnectedSeedCallback callback(this,j);
   callback.node = j;
   roadmap.NewTraversal();
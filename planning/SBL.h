@@ -19,6 +19,10 @@
  * shrinking the neighborhood sampling radius until we quit. 
  * edgeConnectionThreshold is the minimum distance required for a connection
  * between the two trees.
+ *
+ * The counts and times of the planner's operations are accumulated in
+ * stats.  The trees' nodes are allocated from nodePool, which is released
+ * by Cleanup().
  */
 class SBLPlanner
 {
@@ -47,6 +51,8 @@ public:
   int numIters;
   SBLTree *tStart, *tGoal;
   std::list<EdgeInfo> outputPath;
+  PlannerStats stats;
+  BlockPool nodePool;
 };
 
 /** @brief An SBL planner whose trees use grids for point location.
@@ -75,6 +81,10 @@ class SBLPlannerWithGrid : public SBLPlanner
  * Plans are attempted only along these edges.  An edge has a corresponding
  * MilestonePath which will contain the path between the seeds once planning
  * is complete.
+ *
+ * The counts and times of the planner's operations, including those of
+ * the trees, are accumulated in stats.  The trees' nodes are allocated
+ * from nodePool, which is released by Cleanup().
  */
 class SBLPRT
 {
@@ -112,6 +122,8 @@ class SBLPRT
   int numIters;
   Roadmap roadmap;          //the roadmap nodes
   Graph::ConnectedComponents ccs;  //connected components of the roadmap
+  PlannerStats stats;
+  BlockPool nodePool;
 };
 
 #endif
@@ -14,25 +14,6 @@ typedef EdgePlanner Edge;
 #define USE_PLAN_EXTENSIONS 0
 const static Real kMinExtensionLength = 0.01;
 
-// ClosestMilestoneCallback: finds the closest milestone to x 
-struct ClosestMilestoneCallback : public Node::Callback
-{
-  ClosestMilestoneCallback(CSpace* s,const Config& _x)
-    :space(s),closestDistance(Inf),x(_x),closestMilestone(NULL)
-  {}
-  virtual void Visit(Node* n) {
-    Real d = space->Distance(x,*n);
-    if(d < closestDistance) {
-      closestDistance = d;
-      closestMilestone = n;
-    }
-  }
-  CSpace* space;
-  Real closestDistance;
-  const Config& x;
-  Node* closestMilestone;
-};
-
 struct AddPointCallback : public Node::Callback
 {
   AddPointCallback(SBLSubdivision& _s) :s(_s) {}
@@ -90,7 +71,7 @@ struct RemoveTreeCallback : public Node::Callback
 
 
 SBLTree::SBLTree(CSpace* s)
-  :space(s),root(NULL)
+  :space(s),root(NULL),stats(NULL),nodePool(NULL),pointLocation(new GNATPointLocation(s))
 {}
 
 SBLTree::~SBLTree()
@@ -101,6 +82,36 @@ SBLTree::~SBLTree()
 void SBLTree::Cleanup()
 {
   SafeDelete(root);
+  pointLocation->Clear();
+  pointLocationNodes.clear();
+  pointLocationIds.clear();
+  freeIds.clear();
+}
+
+void SBLTree::AddMilestone(Node* n)
+{
+  int id;
+  if(freeIds.empty()) {
+    id = (int)pointLocationNodes.size();
+    pointLocationNodes.push_back(n);
+  }
+  else {
+    id = freeIds.back();
+    freeIds.pop_back();
+    pointLocationNodes[id] = n;
+  }
+  pointLocationIds[n] = id;
+  pointLocation->Add(id,*n);
+}
+
+void SBLTree::RemoveMilestone(Node* n)
+{
+  map<Node*,int>::iterator i=pointLocationIds.find(n);
+  if(i == pointLocationIds.end()) return;
+  pointLocation->Remove(i->second);
+  pointLocationNodes[i->second] = NULL;
+  freeIds.push_back(i->second);
+  pointLocationIds.erase(i);
 }
 
 void SBLTree::Init(const Config& qRoot)
@@ -116,8 +127,16 @@ Node* SBLTree::Extend(Real maxDistance,int maxIters)
   Config x;
   for(int i=1;i<=maxIters;i++) {
     Real r = maxDistance/i;
-    space->SampleNeighborhood(*n,r,x);
-    if(space->IsFeasible(x)) {
+    {
+      PlannerStatTimer timer(stats,PlannerStats::Sample);
+      space->SampleNeighborhood(*n,r,x);
+    }
+    bool feasible;
+    {
+      PlannerStatTimer timer(stats,PlannerStats::Feasibility);
+      feasible = space->IsFeasible(x);
+    }
+    if(feasible) {
       //add as child of n
       return AddChild(n,x);
     }
@@ -251,7 +270,12 @@ bool SBLTree::CheckPath(SBLTree* s,Node* ns,SBLTree* g,Node* ng,std::list<EdgeIn
       FatalError("SBLPlanner is unable to cast edge planner to BisectionEpsilonEdgePlanner - turn off USE_PLAN_EXTENSIONS in SBLTree.cpp");
     }
     //assert(len == temp.e->Priority());
-    if(!bisectionEdge->Plan(a,b)) {
+    bool visible;
+    {
+      PlannerStatTimer timer(s->stats,PlannerStats::EdgeCheck);
+      visible = bisectionEdge->Plan(a,b);
+    }
+    if(!visible) {
       Config p=*a;
       Config q=*b;
       assert(bisectionEdge == temp.e);
@@ -305,7 +329,13 @@ bool SBLTree::CheckPath(SBLTree* s,Node* ns,SBLTree* g,Node* ng,std::list<EdgeIn
       return false;
     }
 #else
-    if(!temp.e->Plan()) {
+    //each refinement of an edge counts as an edge check
+    bool visible;
+    {
+      PlannerStatTimer timer(s->stats,PlannerStats::EdgeCheck);
+      visible = temp.e->Plan();
+    }
+    if(!visible) {
       //disconnect!
       if(temp.e == bridge) {
 	//cout<<"Disconnecting edge between connected nodes"<<endl;
@@ -396,7 +426,12 @@ bool SBLTree::CheckPath(SBLTree* t,Node* ns,Node* ng,MilestonePath& outputPath)
   while(!q.empty()) {
     temp=q.top(); q.pop();
     if(temp.e->Done()) continue;
-    if(!temp.e->Plan()) {
+    bool visible;
+    {
+      PlannerStatTimer timer(t->stats,PlannerStats::EdgeCheck);
+      visible = temp.e->Plan();
+    }
+    if(!visible) {
       //disconnect!
       //cout<<"Disconnecting edge on start tree"<<endl;
       t->DeleteSubtree(temp.t);
@@ -419,10 +454,11 @@ Node* SBLTree::PickExpand()
 
 Node* SBLTree::FindClosest(const Config& x)
 {
-  //walk through start tree
-  ClosestMilestoneCallback callback(space,x);
-  root->DFS(callback);
-  return callback.closestMilestone;
+  PlannerStatTimer timer(stats,PlannerStats::NearestNeighbor);
+  Real d;
+  int id=pointLocation->NN(x,d);
+  if(id < 0) return NULL;
+  return pointLocationNodes[id];
 }
 
 
@@ -434,15 +470,18 @@ SBLTreeWithIndex::SBLTreeWithIndex(CSpace* space)
 void SBLTreeWithIndex::Cleanup()
 {
   index.resize(0);
+  SBLTree::Cleanup();
 }
 
 void SBLTreeWithIndex::AddMilestone(Node* n)
 {
+  SBLTree::AddMilestone(n);
   index.push_back(n);
 }
 
 void SBLTreeWithIndex::RemoveMilestone(Node* n)
 {
+  SBLTree::RemoveMilestone(n);
   vector<Node*>::iterator i=find(index.begin(),index.end(),n);
   if(i == index.end()) return;
   *i = index.back();
@@ -476,8 +515,12 @@ void SBLSubdivision::Clear()
 
 void SBLSubdivision::RandomizeSubset()
 {
-  Assert(h.n >= subsetToFull.Size());
   int n=h.n;
+  //spaces with fewer dimensions than the grid map all of them
+  if(n < subsetToFull.Size()) {
+    subsetToFull.mapping.resize(n);
+    subdiv.h.resize(n);
+  }
   vector<int> p(n); //make a permutation
   for(int i=0;i<n;i++) p[i]=i;
   for(size_t i=0;i<subsetToFull.mapping.size();i++) {
@@ -587,11 +630,13 @@ void SBLTreeWithGrid::RandomizeSubset()
 
 void SBLTreeWithGrid::AddMilestone(Node* n)
 {
+  SBLTree::AddMilestone(n);
   A.AddPoint(n);
 }
 
 void SBLTreeWithGrid::RemoveMilestone(Node* n)
 {
+  SBLTree::RemoveMilestone(n);
   A.RemovePoint(n);
 }
 
@@ -602,6 +647,7 @@ Node* SBLTreeWithGrid::PickExpand()
 
 Node* SBLTreeWithGrid::FindNearby(const Config& x)
 {
+  PlannerStatTimer timer(stats,PlannerStats::NearestNeighbor);
   Node* n=A.PickPoint(x);
   if(n) return n;
   return A.PickRandom();
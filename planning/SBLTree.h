@@ -6,12 +6,25 @@
 #include <utils/ArrayMapping.h>
 #include <utils/SmartPointer.h>
 #include <list>
+#include <map>
 #include "CSpace.h"
 #include "EdgePlanner.h"
 #include "Path.h"
+#include "PlannerStats.h"
+#include "PointLocation.h"
 
 /** @ingroup MotionPlanning
  * @brief A tree of configurations to be used in the SBL motion planner.
+ *
+ * FindClosest() queries the pointLocation index, which by default is a
+ * GNATPointLocation over the CSpace's distance metric.  It is kept in sync
+ * by AddMilestone(Node*) and RemoveMilestone(Node*), so subclasses that
+ * override these must call the SBLTree versions.
+ *
+ * If stats is not NULL, the tree's operations are counted in it.  If
+ * nodePool is not NULL, new nodes are allocated from it.  The SBL planners
+ * share a pool between their trees, since nodes may move from one tree to
+ * another.
  */
 class SBLTree
 {
@@ -30,12 +43,12 @@ public:
   virtual void Init(const Config& qStart);
   virtual Node* Extend(Real maxDistance,int maxIters);
 
-  virtual void AddMilestone(Node* n) {}
-  virtual void RemoveMilestone(Node* n) {}
+  virtual void AddMilestone(Node* n);
+  virtual void RemoveMilestone(Node* n);
   virtual Node* PickExpand();
 
   //helpers
-  Node* AddMilestone(const Config& q) { Node* n=new Node(q); AddMilestone(n); return n; }
+  Node* AddMilestone(const Config& q) { Node* n=new(nodePool) Node(q); AddMilestone(n); return n; }
   bool HasNode(Node* n) const;
   Node* AddChild(Node* n,const Config& x);
   Node* FindClosest(const Config& x);
@@ -49,6 +62,12 @@ public:
 
   CSpace* space;
   Node *root;
+  PlannerStats* stats;
+  BlockPool* nodePool;
+  SmartPointer<PointLocationBase> pointLocation;
+  std::vector<Node*> pointLocationNodes;  ///< maps ids to nodes, NULL if removed
+  std::map<Node*,int> pointLocationIds;   ///< maps nodes to ids
+  std::vector<int> freeIds;               ///< ids of removed nodes, for reuse
 };
 
 /** @ingroup MotionPlanning
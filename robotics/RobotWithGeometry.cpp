@@ -10,24 +10,86 @@
 using namespace GLDraw;
 using namespace std;
 
+RobotWithGeometry::SelfCollisionCache::SelfCollisionCache()
+  :radius1(Inf),radius2(Inf)
+{
+  Clear();
+}
+
+void RobotWithGeometry::SelfCollisionCache::Clear()
+{
+  T1.setIdentity();
+  T2.setIdentity();
+  separation = 0;
+  witness1 = witness2 = -1;
+}
+
+//returns the largest distance of the geometry from its origin
+static Real GeometryRadius(const RobotWithGeometry::CollisionGeometry& geom)
+{
+  AABB3D bb = geom.AnyGeometry3D::GetAABB();
+  if(bb.bmin.x > bb.bmax.x) return Inf;
+  return Vector3(Max(Abs(bb.bmin.x),Abs(bb.bmax.x)),
+		 Max(Abs(bb.bmin.y),Abs(bb.bmax.y)),
+		 Max(Abs(bb.bmin.z),Abs(bb.bmax.z))).norm();
+}
+
+//bounds how far a point within radius of the origin moves from T0 to T
+static Real MotionBound(const RigidTransform& T0,const RigidTransform& T,Real radius)
+{
+  if(IsInf(radius)) return Inf;
+  Real dR = 0;
+  for(int i=0;i<3;i++)
+    for(int j=0;j<3;j++)
+      dR += Sqr(T.R(i,j)-T0.R(i,j));
+  return T.t.distance(T0.t) + Sqrt(dR)*radius;
+}
+
+static Real BoxDistance(const AABB3D& a,const AABB3D& b)
+{
+  Vector3 gap;
+  gap.x = Max(Max(a.bmin.x-b.bmax.x,b.bmin.x-a.bmax.x),0.0);
+  gap.y = Max(Max(a.bmin.y-b.bmax.y,b.bmin.y-a.bmax.y),0.0);
+  gap.z = Max(Max(a.bmin.z-b.bmax.z,b.bmin.z-a.bmax.z),0.0);
+  return gap.norm();
+}
+
 RobotWithGeometry::RobotWithGeometry()
+  :useSelfCollisionCache(true)
 {}
 
+//the bounding box of geom, grown by its margin, for the broad phase
+static AABB3D EnvBox(const RobotWithGeometry::CollisionGeometry& geom)
+{
+  AABB3D bb;
+  if(geom.Empty()) {
+    bb.minimize();
+    return bb;
+  }
+  bb = geom.GetAABB();
+  bb.bmin -= Vector3(geom.margin);
+  bb.bmax += Vector3(geom.margin);
+  return bb;
+}
+
 RobotWithGeometry::~RobotWithGeometry()
 {
   CleanupCollisions();
   CleanupSelfCollisions();
+  CleanupEnvGeometry();
 }
 
 void RobotWithGeometry::Initialize(int n)
 {
   CleanupCollisions();
   CleanupSelfCollisions();
+  CleanupEnvGeometry();
 
   RobotDynamics3D::Initialize(n);
   Assert((int)links.size() == n);
   geometry.resize(n);
   selfCollisions.resize(n,n,NULL);
+  selfCollisionCache.resize(n,n);
   envCollisions.resize(n,NULL);
 }
 
@@ -68,8 +130,12 @@ void RobotWithGeometry::InitSelfCollisionPair(int i,int j)
   Assert(i<j);
   Assert(!selfCollisions(i,j));
   Assert(j < (int)geometry.size());
-  if(!geometry[i].Empty() && !geometry[j].Empty()) 
+  if(!geometry[i].Empty() && !geometry[j].Empty()) {
     selfCollisions(i,j) = new CollisionQuery(geometry[i],geometry[j]);
+    selfCollisionCache(i,j).Clear();
+    selfCollisionCache(i,j).radius1 = GeometryRadius(geometry[i]);
+    selfCollisionCache(i,j).radius2 = GeometryRadius(geometry[j]);
+  }
 }
 
 
@@ -110,6 +176,8 @@ void RobotWithGeometry::UpdateGeometry()
 void RobotWithGeometry::UpdateGeometry(int i)
 {
   geometry[i].SetTransform(links[i].T_World);
+  if(!envGeometry.empty())
+    envBroadPhase.Update(i,EnvBox(geometry[i]));
 }
 
 void RobotWithGeometry::InitMeshCollision(CollisionGeometry& mesh)
@@ -141,12 +209,48 @@ bool UnderCollisionMargin(Geometry::AnyCollisionQuery* q,Real adj)
   }
 }
 
+//Checks a pair using the results of its last query.  The separation of the
+//bounding boxes at the last broad phase, less the distance the bodies could
+//have moved since, lets the pair be skipped; a colliding pair first checks
+//the triangles that collided last time.
+static bool CachedCollision(RobotWithGeometry::CollisionQuery* query,RobotWithGeometry::SelfCollisionCache& cache,Real d)
+{
+  const RobotWithGeometry::CollisionGeometry& a=*query->a, &b=*query->b;
+  RigidTransform Ta=a.GetTransform(),Tb=b.GetTransform();
+  Real motion = MotionBound(cache.T1,Ta,cache.radius1)+MotionBound(cache.T2,Tb,cache.radius2);
+  //conservative skip: the bodies can't have closed the gap yet
+  if(motion < cache.separation - d) return false;
+  bool meshes = (query->qmesh.m1 != NULL);
+  Real margin = a.margin+b.margin;
+  if(meshes && cache.witness1 >= 0) {
+    if(Geometry::TriangleDistance(a.TriangleMeshCollisionData(),cache.witness1,b.TriangleMeshCollisionData(),cache.witness2) <= d+margin)
+      return true;
+    cache.witness1 = cache.witness2 = -1;
+  }
+  //broad phase on the bounding boxes
+  cache.T1 = Ta;
+  cache.T2 = Tb;
+  cache.separation = BoxDistance(a.GetAABB(),b.GetAABB()) - margin;
+  if(cache.separation > d) return false;
+  if(UnderCollisionMargin(query,d)) {
+    cache.separation = 0;
+    //only exact collision queries report their triangles
+    if(meshes && d == 0 && margin == 0 && !query->elements1.empty()) {
+      cache.witness1 = query->elements1[0];
+      cache.witness2 = query->elements2[0];
+    }
+    return true;
+  }
+  return false;
+}
+
 bool RobotWithGeometry::SelfCollision(int i, int j, Real d)
 {
   if(i > j) std::swap(i,j);
   CollisionQuery* query=selfCollisions(i,j);
   if(query == NULL) return false;
-  return UnderCollisionMargin(query,d);
+  if(!useSelfCollisionCache || d < 0) return UnderCollisionMargin(query,d);
+  return CachedCollision(query,selfCollisionCache(i,j),d);
 }
 
 bool RobotWithGeometry::SelfCollision(const vector<int>& bodies,Real distance)
@@ -197,6 +301,70 @@ bool RobotWithGeometry::MeshCollision(int i,Real distance)
   return (envCollisions[i] && UnderCollisionMargin(envCollisions[i],distance));
 }
 
+int RobotWithGeometry::AddEnvGeometry(CollisionGeometry* obj)
+{
+  if(envGeometry.empty()) {
+    envBroadPhase.Clear();
+    for(size_t i=0;i<links.size();i++)
+      envBroadPhase.Add(EnvBox(geometry[i]),0);
+  }
+  envGeometry.push_back(obj);
+  envGeometryCollisions.push_back(vector<CollisionQuery*>(links.size(),NULL));
+  envBroadPhase.Add(EnvBox(*obj),1);
+  return (int)envGeometry.size()-1;
+}
+
+void RobotWithGeometry::UpdateEnvGeometry(int k)
+{
+  envBroadPhase.Update((int)links.size()+k,EnvBox(*envGeometry[k]));
+}
+
+void RobotWithGeometry::CleanupEnvGeometry()
+{
+  for(size_t k=0;k<envGeometryCollisions.size();k++)
+    for(size_t i=0;i<envGeometryCollisions[k].size();i++)
+      SafeDelete(envGeometryCollisions[k][i]);
+  envGeometryCollisions.clear();
+  envGeometry.clear();
+  envBroadPhase.Clear();
+}
+
+bool RobotWithGeometry::EnvCollision(Real distance)
+{
+  if(envGeometry.empty()) return false;
+  for(size_t i=0;i<links.size();i++)
+    if(EnvCollision(i,distance)) return true;
+  return false;
+}
+
+bool RobotWithGeometry::EnvCollision(int i,Real distance)
+{
+  //the broad phase has no boxes until the first object is added
+  if(envGeometry.empty()) return false;
+  if(geometry[i].Empty()) return false;
+  int n = (int)links.size();
+  if(distance > 0) {
+    //the broad phase only finds touching boxes, so check the box distances
+    const AABB3D& bb = envBroadPhase.boxes[i];
+    for(size_t k=0;k<envGeometry.size();k++) {
+      if(BoxDistance(bb,envBroadPhase.boxes[n+k]) > distance) continue;
+      CollisionQuery*& q = envGeometryCollisions[k][i];
+      if(!q) q = new CollisionQuery(geometry[i],*envGeometry[k]);
+      if(UnderCollisionMargin(q,distance)) return true;
+    }
+    return false;
+  }
+  envBroadPhase.Refresh();
+  const vector<int>& objects = envBroadPhase.Overlaps(i);
+  for(size_t j=0;j<objects.size();j++) {
+    int k = objects[j]-n;
+    CollisionQuery*& q = envGeometryCollisions[k][i];
+    if(!q) q = new CollisionQuery(geometry[i],*envGeometry[k]);
+    if(UnderCollisionMargin(q,distance)) return true;
+  }
+  return false;
+}
+
 void RobotWithGeometry::DrawGL()
 {
   for(size_t i=0;i<links.size();i++) {
@@ -4,6 +4,7 @@
 #include <robotics/RobotDynamics3D.h>
 #include <structs/array2d.h>
 #include <geometry/AnyGeometry.h>
+#include <geometry/SweepAndPrune.h>
 
 /** @ingroup Robot
  * @brief The base class for a robot definition. 
@@ -14,12 +15,43 @@
  * 2) Load the geometry for each link using LoadGeometry(),
  * 3) Initialize the collision structures (and self collision pairs) using
  *    InitCollisions() and InitSelfCollisionPair().
+ *
+ * Collisions with a scene of several environment objects are checked by
+ * adding the objects with AddEnvGeometry() and calling EnvCollision().
+ * A sweep-and-prune broad phase over the bounding boxes of the links and
+ * objects, updated in UpdateGeometry(), passes only the overlapping
+ * link-object pairs on to the narrow phase.
  */
 class RobotWithGeometry : public RobotDynamics3D
 {
 public:
   typedef Geometry::AnyCollisionGeometry3D CollisionGeometry;
   typedef Geometry::AnyCollisionQuery CollisionQuery;
+
+  /** @brief Results of earlier self collision queries of a pair of
+   * bodies, reused by later queries at nearby configurations.
+   *
+   * If the bodies were separated by at least separation at transforms
+   * T1,T2, and their points have moved by less than separation-d since,
+   * they are still more than d apart.  The motion of a body is bounded by
+   * |t-t0| + ||R-R0||_F*radius, where radius bounds the distance of its
+   * geometry from its origin.  If the bodies last collided, the witness
+   * triangles are tested first.
+   */
+  struct SelfCollisionCache
+  {
+    SelfCollisionCache();
+    void Clear();
+
+    ///Radii of the bodies' geometry about their origins
+    Real radius1,radius2;
+    ///Transforms at which separation was computed
+    RigidTransform T1,T2;
+    ///Lower bound on the distance between the bodies at T1,T2
+    Real separation;
+    ///The last colliding pair of triangles, or -1
+    int witness1,witness2;
+  };
   
   RobotWithGeometry();
   virtual ~RobotWithGeometry();
@@ -53,13 +85,36 @@ public:
   virtual bool MeshCollision(CollisionGeometry& mesh);
   virtual bool MeshCollision(int i,Real distance=0);
 
+  /// Adds an environment object, returning its index in envGeometry.  The
+  /// object must outlive the robot's use of it.
+  int AddEnvGeometry(CollisionGeometry* obj);
+  /// Call this when environment object k has moved
+  void UpdateEnvGeometry(int k);
+  void CleanupEnvGeometry();
+  /// Query collision between the robot and the environment objects
+  virtual bool EnvCollision(Real distance=0);
+  /// Query collision between link i and the environment objects
+  virtual bool EnvCollision(int i,Real distance=0);
+
   virtual void DrawGL();
   virtual void DrawLinkGL(int i);
 
   std::vector<CollisionGeometry> geometry;
   ///matrix(i,j) of collisions between bodies, i < j (upper triangular)
   Array2D<CollisionQuery*> selfCollisions;
+  ///If true (default), SelfCollision uses selfCollisionCache to skip or
+  ///shortcut queries of bodies that have moved little since the last one
+  bool useSelfCollisionCache;
+  ///Cached results for the pairs in selfCollisions
+  Array2D<SelfCollisionCache> selfCollisionCache;
   std::vector<CollisionQuery*> envCollisions;
+  ///Environment objects added with AddEnvGeometry()
+  std::vector<CollisionGeometry*> envGeometry;
+  ///envGeometryCollisions[k][i] checks link i against object k.  Created
+  ///when the pair first overlaps in the broad phase.
+  std::vector<std::vector<CollisionQuery*> > envGeometryCollisions;
+  ///Boxes of the links (ids 0...n-1) and environment objects (ids n+k)
+  Geometry::SweepAndPrune envBroadPhase;
 };
 
 #endif
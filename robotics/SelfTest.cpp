@@ -3,6 +3,7 @@
 #include "Rotation.h"
 #include "NewtonEuler.h"
 #include "RLG.h"
+#include "RobotWithGeometry.h"
 #include <errors.h>
 #include "SelfTest.h"
 using namespace Math;
@@ -297,3 +298,64 @@ void TestNewtonEuler()
     ne.SelfTest();
   }
 }
+
+//environment collisions of a chain of spheres, before and after objects
+//are added
+void TestEnvCollision()
+{
+  int n=3;
+  RobotWithGeometry robot;
+  robot.Initialize(n);
+  MakePlanarChain(robot,n);
+  for(int i=0;i<n;i++) {
+    Sphere3D s;
+    s.center.setZero();
+    s.radius = 0.25;
+    robot.geometry[i] = RobotWithGeometry::CollisionGeometry(GeometricPrimitive3D(s));
+    robot.geometry[i].InitCollisions();
+  }
+  robot.q.setZero();
+  robot.UpdateFrames();
+  robot.UpdateGeometry();
+
+  //no environment objects
+  Assert(!robot.EnvCollision());
+  Assert(!robot.EnvCollision(1.0));
+  for(int i=0;i<n;i++) {
+    Assert(!robot.EnvCollision(i));
+    Assert(!robot.EnvCollision(i,1.0));
+  }
+
+  //an object 0.2 from the last link, and one far away
+  Sphere3D s;
+  s.center.set(n-1+0.7,0,0);
+  s.radius = 0.25;
+  GeometricPrimitive3D nearSphere(s);
+  s.center.set(0,10,0);
+  GeometricPrimitive3D farSphere(s);
+  RobotWithGeometry::CollisionGeometry near(nearSphere),far(farSphere);
+  near.InitCollisions();
+  far.InitCollisions();
+  robot.AddEnvGeometry(&far);
+  Assert(!robot.EnvCollision());
+  Assert(!robot.EnvCollision(1.0));
+  int k=robot.AddEnvGeometry(&near);
+  Assert(!robot.EnvCollision());
+  Assert(robot.EnvCollision(0.3));
+  Assert(robot.EnvCollision(n-1,0.3));
+  Assert(!robot.EnvCollision(n-2,0.3));
+
+  //move the object into the last link
+  RigidTransform T;
+  T.R.setIdentity();
+  T.t.set(-0.3,0,0);
+  near.SetTransform(T);
+  robot.UpdateEnvGeometry(k);
+  Assert(robot.EnvCollision());
+  Assert(robot.EnvCollision(n-1));
+  Assert(!robot.EnvCollision(0));
+
+  robot.CleanupEnvGeometry();
+  Assert(!robot.EnvCollision());
+  Assert(!robot.EnvCollision(n-1,1.0));
+}
@@ -7,5 +7,6 @@
 void TestRotations();
 void TestRLG();
 void TestNewtonEuler();
+void TestEnvCollision();
 
 #endif
@@ -1034,13 +1034,13 @@ Real LinearProcessHMMRegression::ProbabilityX(const LinearProcessHMMState& s,con
 	if(!s.x.empty()) {
 	  Vector vtemp;
 	  xRegressions[i].A.mul(s.x,vtemp);
-	  cout<<"  Prediction "<<i<<": "<<vtemp+xRegressions[i].error.mu<<endl;
+	  cout<<"  Prediction "<<i<<": "<<Vector(vtemp+xRegressions[i].error.mu)<<endl;
 	  p += s.p(i) * xRegressions[i].Probability(s.x,x);
 	}
 	else {
 	  Vector vtemp;
 	  xRegressions[i].A.mul(s.xPrev,vtemp);
-	  cout<<"  Prediction "<<i<<": "<<vtemp+xRegressions[i].error.mu<<endl;
+	  cout<<"  Prediction "<<i<<": "<<Vector(vtemp+xRegressions[i].error.mu)<<endl;
 	  cout<<"  Error cov L "<<xRegressions[i].error.L<<endl;
 	  p += s.p(i) * xRegressions[i].Probability(s.xPrev,x);
 	}
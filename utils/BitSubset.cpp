@@ -0,0 +1,199 @@
+#include "BitSubset.h"
+#include "Subset.h"
+#include <algorithm>
+#include <assert.h>
+using namespace std;
+
+#if defined (__GNUC__) && (__GNUC__ > 3)
+inline int PopCount(BitSubset::Word w) { return __builtin_popcountl(w); }
+inline int LowestBit(BitSubset::Word w) { return __builtin_ctzl(w); }
+#else
+inline int PopCount(BitSubset::Word w)
+{
+  int n=0;
+  for(;w;w&=w-1) n++;
+  return n;
+}
+inline int LowestBit(BitSubset::Word w)
+{
+  int n=0;
+  for(;!(w&1);w>>=1) n++;
+  return n;
+}
+#endif //__GNUC__
+
+inline int NumWords(int maxItem) { return (maxItem+BitSubset::WordBits-1)/BitSubset::WordBits; }
+
+BitSubset::BitSubset(int _maxItem)
+  :maxItem(_maxItem),words(NumWords(_maxItem),0)
+{}
+
+BitSubset::BitSubset(const BitSubset& s)
+  :maxItem(s.maxItem),words(s.words)
+{}
+
+BitSubset::BitSubset(const vector<bool>& bits)
+  :maxItem((int)bits.size()),words(NumWords((int)bits.size()),0)
+{
+  for(size_t i=0;i<bits.size();i++)
+    if(bits[i]) words[i/WordBits] |= Word(1)<<(i%WordBits);
+}
+
+BitSubset::BitSubset(const Subset& s)
+  :maxItem(s.maxItem),words(NumWords(s.maxItem),0)
+{
+  for(Subset::const_iterator i=s.begin();i!=s.end();i++)
+    insert(*i);
+}
+
+bool BitSubset::empty() const
+{
+  for(size_t i=0;i<words.size();i++)
+    if(words[i]) return false;
+  return true;
+}
+
+size_t BitSubset::size() const
+{
+  size_t n=0;
+  for(size_t i=0;i<words.size();i++)
+    n += PopCount(words[i]);
+  return n;
+}
+
+int BitSubset::next(int item) const
+{
+  if(item >= maxItem) return maxItem;
+  size_t i=item/WordBits;
+  Word w = words[i] & (~Word(0) << (item%WordBits));
+  while(!w) {
+    i++;
+    if(i == words.size()) return maxItem;
+    w = words[i];
+  }
+  return int(i*WordBits) + LowestBit(w);
+}
+
+//Same order as Subset: by maxItem, then lexicographically by the sorted
+//items.  At the first item p in which a and b differ, the one containing
+//p comes first unless the other one has no items after p.
+bool BitSubset::operator < (const BitSubset& s) const
+{
+  if(maxItem < s.maxItem) return true;
+  if(maxItem > s.maxItem) return false;
+  for(size_t i=0;i<words.size();i++) {
+    if(words[i] == s.words[i]) continue;
+    int p = LowestBit(words[i]^s.words[i]);
+    Word above = (p+1 < (int)WordBits ? ~Word(0) << (p+1) : Word(0));
+    const vector<Word>& other = ((words[i]>>p)&1 ? s.words : words);
+    bool otherHasMore = ((other[i] & above) != 0);
+    for(size_t j=i+1;j<other.size() && !otherHasMore;j++)
+      if(other[j]) otherHasMore = true;
+    //this has p: this < s iff s has more items
+    //s has p: this < s iff this has no more items
+    if(&other == &s.words) return otherHasMore;
+    else return !otherHasMore;
+  }
+  return false;
+}
+
+bool BitSubset::operator > (const BitSubset& s) const
+{
+  return s < *this;
+}
+
+bool BitSubset::operator == (const BitSubset& s) const
+{
+  return maxItem == s.maxItem && words == s.words;
+}
+
+bool BitSubset::operator != (const BitSubset& s) const
+{
+  return !(s==*this);
+}
+
+BitSubset BitSubset::operator + (const BitSubset& s) const
+{
+  const BitSubset& a = (maxItem >= s.maxItem ? *this : s);
+  const BitSubset& b = (maxItem >= s.maxItem ? s : *this);
+  BitSubset res(a);
+  for(size_t i=0;i<b.words.size();i++)
+    res.words[i] |= b.words[i];
+  return res;
+}
+
+BitSubset BitSubset::operator - (const BitSubset& s) const
+{
+  BitSubset res(*this);
+  size_t n=std::min(words.size(),s.words.size());
+  for(size_t i=0;i<n;i++)
+    res.words[i] &= ~s.words[i];
+  return res;
+}
+
+BitSubset BitSubset::operator & (const BitSubset& s) const
+{
+  BitSubset res(std::min(maxItem,s.maxItem));
+  for(size_t i=0;i<res.words.size();i++)
+    res.words[i] = words[i] & s.words[i];
+  return res;
+}
+
+BitSubset BitSubset::operator - () const
+{
+  BitSubset res(maxItem);
+  for(size_t i=0;i<words.size();i++)
+    res.words[i] = ~words[i];
+  if(maxItem % WordBits != 0)
+    res.words.back() &= ~(~Word(0) << (maxItem % WordBits));
+  return res;
+}
+
+void BitSubset::insert(int item)
+{
+  assert(item >= 0 && item < maxItem);
+  words[item/WordBits] |= Word(1)<<(item%WordBits);
+}
+
+void BitSubset::insert_end(int item)
+{
+  assert(next(item) == maxItem);
+  insert(item);
+}
+
+void BitSubset::remove(int item)
+{
+  if(item < 0 || item >= maxItem) return;
+  words[item/WordBits] &= ~(Word(1)<<(item%WordBits));
+}
+
+BitSubset::const_iterator BitSubset::find(int item) const
+{
+  if(count(item)) return const_iterator(this,item);
+  return end();
+}
+
+bool BitSubset::is_subset(const BitSubset& s) const
+{
+  if(maxItem > s.maxItem) return false;
+  for(size_t i=0;i<words.size();i++)
+    if(words[i] & ~s.words[i]) return false;
+  return true;
+}
+
+void BitSubset::resize(int _maxItem)
+{
+  maxItem = _maxItem;
+  words.resize(NumWords(maxItem),0);
+  if(maxItem % WordBits != 0)
+    words.back() &= ~(~Word(0) << (maxItem % WordBits));
+}
+
+ostream& operator << (ostream& out,const BitSubset& s)
+{
+  out<<"{";
+  for(BitSubset::const_iterator i=s.begin();i!=s.end();i++)
+    out<<*i<<" ";
+  out<<"}";
+  return out;
+}
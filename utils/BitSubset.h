@@ -0,0 +1,79 @@
+#ifndef STRUCTS_BIT_SUBSET_H
+#define STRUCTS_BIT_SUBSET_H
+
+#include <vector>
+#include <iostream>
+
+struct Subset;
+
+/**@brief A finite subset of the items [0,maxItem) stored as a bit-vector.
+ *
+ * Has the same interface and ordering as Subset, but union, intersection,
+ * difference, and subset tests operate a machine word at a time, and
+ * size() uses popcount.  Most efficient when maxItem is small, or when
+ * the subset contains a sizable fraction of the items.
+ *
+ * Bits at or above maxItem are always zero, so maxItem should only be
+ * changed through resize().
+ */
+struct BitSubset
+{
+  typedef unsigned long Word;
+  enum { WordBits = sizeof(Word)*8 };
+
+  ///Iterates over the items of the subset in increasing order
+  class const_iterator
+  {
+  public:
+    const_iterator() :s(NULL),item(0) {}
+    const_iterator(const BitSubset* _s,int _item) :s(_s),item(_item) {}
+    inline int operator * () const { return item; }
+    inline const_iterator& operator ++ () { item = s->next(item+1); return *this; }
+    inline const_iterator operator ++ (int) { const_iterator temp=*this; ++(*this); return temp; }
+    inline bool operator == (const const_iterator& i) const { return item == i.item; }
+    inline bool operator != (const const_iterator& i) const { return item != i.item; }
+
+    const BitSubset* s;
+    int item;
+  };
+  typedef const_iterator iterator;
+
+  BitSubset(int maxItem=0);
+  BitSubset(const BitSubset& s);
+  BitSubset(const std::vector<bool>& bits);
+  explicit BitSubset(const Subset& s);
+  inline const_iterator begin() const { return const_iterator(this,next(0)); }
+  inline const_iterator end() const { return const_iterator(this,maxItem); }
+  bool empty() const;
+  size_t size() const;
+  bool operator < (const BitSubset& s) const;
+  bool operator > (const BitSubset& s) const;
+  bool operator == (const BitSubset& s) const;
+  bool operator != (const BitSubset& s) const;
+  //set union
+  BitSubset operator + (const BitSubset& s) const;
+  //set complement
+  BitSubset operator - () const;
+  //set difference
+  BitSubset operator - (const BitSubset& s) const;
+  //set intersection
+  BitSubset operator & (const BitSubset& s) const;
+  void insert(int item);
+  void insert_end(int item);
+  void remove(int item);
+  const_iterator find(int item) const;
+  inline void erase(const_iterator it) { remove(*it); }
+  inline size_t count(int item) const { return (item >= 0 && item < maxItem ? (words[item/WordBits]>>(item%WordBits))&1 : 0); }
+  bool is_subset(const BitSubset& s) const;
+  ///Changes maxItem, dropping the items at or above the new maximum
+  void resize(int maxItem);
+  ///Returns the first item >= item, or maxItem if there is none
+  int next(int item) const;
+
+  int maxItem;
+  std::vector<Word> words;
+};
+
+std::ostream& operator << (std::ostream& out,const BitSubset& s);
+
+#endif
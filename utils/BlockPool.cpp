@@ -0,0 +1,79 @@
+#include "BlockPool.h"
+#include <errors.h>
+#include <new>
+
+//placed before each block returned by New, keeps the object aligned
+union BlockHeader
+{
+  BlockPool* pool;
+  double d;
+  void* p;
+};
+
+BlockPool::BlockPool(size_t _blocksPerChunk)
+  :blockSize(0),blocksPerChunk(_blocksPerChunk),chunkUsed(0),freeList(NULL),numBlocks(0)
+{}
+
+BlockPool::~BlockPool()
+{
+  for(size_t i=0;i<chunks.size();i++)
+    delete [] chunks[i];
+}
+
+void* BlockPool::Allocate(size_t size)
+{
+  if(blockSize == 0) {
+    //round up to keep blocks aligned, and to fit the free list pointer
+    const size_t align = sizeof(BlockHeader);
+    blockSize = ((size+align-1)/align)*align;
+    if(blockSize == 0) blockSize = align;
+  }
+  Assert(size <= blockSize);
+  numBlocks++;
+  if(freeList) {
+    void* block = freeList;
+    freeList = *(void**)freeList;
+    return block;
+  }
+  if(chunks.empty() || chunkUsed == blocksPerChunk) {
+    chunks.push_back(new char[blockSize*blocksPerChunk]);
+    chunkUsed = 0;
+  }
+  return chunks.back() + blockSize*(chunkUsed++);
+}
+
+void BlockPool::Free(void* block)
+{
+  Assert(numBlocks > 0);
+  numBlocks--;
+  *(void**)block = freeList;
+  freeList = block;
+}
+
+bool BlockPool::Clear()
+{
+  if(numBlocks > 0) return false;
+  for(size_t i=0;i<chunks.size();i++)
+    delete [] chunks[i];
+  chunks.clear();
+  chunkUsed = 0;
+  freeList = NULL;
+  return true;
+}
+
+void* BlockPool::New(size_t size,BlockPool* pool)
+{
+  BlockHeader* h;
+  if(pool) h = (BlockHeader*)pool->Allocate(size+sizeof(BlockHeader));
+  else h = (BlockHeader*)::operator new(size+sizeof(BlockHeader));
+  h->pool = pool;
+  return h+1;
+}
+
+void BlockPool::Delete(void* ptr)
+{
+  if(!ptr) return;
+  BlockHeader* h = ((BlockHeader*)ptr)-1;
+  if(h->pool) h->pool->Free(h);
+  else ::operator delete(h);
+}
@@ -0,0 +1,51 @@
+#ifndef UTILS_BLOCK_POOL_H
+#define UTILS_BLOCK_POOL_H
+
+#include <vector>
+#include <stddef.h>
+
+/** @ingroup Utils
+ * @brief Allocates equal-sized blocks of memory out of large chunks.
+ *
+ * Freed blocks are kept on a free list and reused, and the chunks are
+ * only returned to the heap by Clear() or the destructor.  This is much
+ * cheaper than malloc/free for many small objects that are created and
+ * destroyed together, e.g., the nodes of a planner's tree, and keeps them
+ * close together in memory.  The block size is set by the first call to
+ * Allocate.  Not thread safe.
+ *
+ * To allocate an object with a class-specific operator new, use the
+ * static New/Delete methods, which prefix each block with the pool it
+ * came from (or NULL for the heap), so that the object may be deleted
+ * without knowing where it was allocated.  See Graph::TreeNode.
+ */
+class BlockPool
+{
+ public:
+  BlockPool(size_t blocksPerChunk=256);
+  ~BlockPool();
+  void* Allocate(size_t size);
+  void Free(void* block);
+  ///Returns the chunks to the heap if no block is in use, and returns
+  ///true.  Otherwise, does nothing and returns false.
+  bool Clear();
+  inline size_t NumBlocks() const { return numBlocks; }
+
+  ///Allocates size bytes from pool, or from the heap if pool is NULL
+  static void* New(size_t size,BlockPool* pool);
+  ///Frees memory returned by New
+  static void Delete(void* ptr);
+
+  size_t blockSize,blocksPerChunk;
+
+ private:
+  BlockPool(const BlockPool&) {}
+  const BlockPool& operator=(const BlockPool&) { return *this; }
+
+  std::vector<char*> chunks;
+  size_t chunkUsed;   //number of blocks handed out of the last chunk
+  void* freeList;
+  size_t numBlocks;   //number of blocks in use
+};
+
+#endif
@@ -8,7 +8,8 @@
  * union, intersection, difference, etc.
  *
  * Most efficient when the subset contains far fewer items than the maximum.
- * If a majority of items are stored, then a bit-vector may be more efficient.
+ * If a majority of items are stored, then a bit-vector (BitSubset) may be
+ * more efficient.
  */
 struct Subset
 {
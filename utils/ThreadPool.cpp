@@ -0,0 +1,145 @@
+#include "ThreadPool.h"
+#include <utils.h>
+#include <errors.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif //WIN32
+
+int ThreadPool::NumCores()
+{
+#ifndef WIN32
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if(n > 0) return (int)n;
+#endif //WIN32
+  return 1;
+}
+
+#ifdef WIN32
+
+ThreadPool::ThreadPool(int _numThreads)
+  :numThreads(1)
+{}
+
+ThreadPool::~ThreadPool()
+{}
+
+void ThreadPool::ParallelFor(int n,ParallelForBody& body,int chunkSize)
+{
+  if(n > 0) body.Run(0,n,0);
+}
+
+void ThreadPool::Lock()
+{}
+
+void ThreadPool::Unlock()
+{}
+
+#else
+
+void* thread_pool_worker_func(void* ptr)
+{
+  ThreadPool* pool = reinterpret_cast<ThreadPool*>(ptr);
+  pthread_mutex_lock(&pool->mutex);
+  int thread = ++pool->numStarted;
+  int generation = 0;
+  while(true) {
+    while(!pool->quit && pool->generation == generation)
+      pthread_cond_wait(&pool->startCond,&pool->mutex);
+    if(pool->quit) break;
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+    pool->RunChunks(thread);
+    pthread_mutex_lock(&pool->mutex);
+    pool->active--;
+    if(pool->active == 0)
+      pthread_cond_signal(&pool->doneCond);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+ThreadPool::ThreadPool(int _numThreads)
+  :numThreads(_numThreads),generation(0),quit(false),numStarted(0),body(NULL),n(0),chunkSize(1),next(0),active(0)
+{
+  if(numThreads <= 0) numThreads = NumCores();
+  pthread_mutex_init(&loopMutex,NULL);
+  pthread_mutex_init(&mutex,NULL);
+  pthread_cond_init(&startCond,NULL);
+  pthread_cond_init(&doneCond,NULL);
+  threads.resize(numThreads-1);
+  for(size_t i=0;i<threads.size();i++) {
+    if(pthread_create(&threads[i],NULL,thread_pool_worker_func,this) != 0) {
+      fprintf(stderr,"ThreadPool: could only create %d threads\n",(int)i+1);
+      threads.resize(i);
+      numThreads = (int)i+1;
+      break;
+    }
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  pthread_mutex_lock(&mutex);
+  quit = true;
+  pthread_cond_broadcast(&startCond);
+  pthread_mutex_unlock(&mutex);
+  for(size_t i=0;i<threads.size();i++)
+    pthread_join(threads[i],NULL);
+  pthread_cond_destroy(&startCond);
+  pthread_cond_destroy(&doneCond);
+  pthread_mutex_destroy(&mutex);
+  pthread_mutex_destroy(&loopMutex);
+}
+
+void ThreadPool::ParallelFor(int _n,ParallelForBody& _body,int _chunkSize)
+{
+  if(_n <= 0) return;
+  if(_chunkSize <= 0) _chunkSize = Max(1,_n/(numThreads*8));
+  if(numThreads == 1 || _chunkSize >= _n) {
+    _body.Run(0,_n,0);
+    return;
+  }
+  pthread_mutex_lock(&loopMutex);
+  pthread_mutex_lock(&mutex);
+  body = &_body;
+  n = _n;
+  chunkSize = _chunkSize;
+  next = 0;
+  active = (int)threads.size();
+  generation++;
+  pthread_cond_broadcast(&startCond);
+  pthread_mutex_unlock(&mutex);
+
+  RunChunks(0);
+
+  pthread_mutex_lock(&mutex);
+  while(active > 0)
+    pthread_cond_wait(&doneCond,&mutex);
+  body = NULL;
+  pthread_mutex_unlock(&mutex);
+  pthread_mutex_unlock(&loopMutex);
+}
+
+void ThreadPool::Lock()
+{
+  pthread_mutex_lock(&mutex);
+}
+
+void ThreadPool::Unlock()
+{
+  pthread_mutex_unlock(&mutex);
+}
+
+void ThreadPool::RunChunks(int thread)
+{
+  while(true) {
+    pthread_mutex_lock(&mutex);
+    int begin = next;
+    next += chunkSize;
+    pthread_mutex_unlock(&mutex);
+    if(begin >= n) return;
+    body->Run(begin,Min(begin+chunkSize,n),thread);
+  }
+}
+
+#endif //WIN32
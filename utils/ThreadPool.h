@@ -0,0 +1,74 @@
+#ifndef UTILS_THREAD_POOL_H
+#define UTILS_THREAD_POOL_H
+
+#include <vector>
+#ifndef WIN32
+#include <pthread.h>
+#endif //WIN32
+
+/** @ingroup Utils
+ * @brief The body of a loop executed by ThreadPool::ParallelFor.
+ *
+ * Run(begin,end,thread) must process the items in [begin,end).  thread
+ * is the index of the executing thread, in [0,NumThreads()), so the body
+ * can keep per-thread scratch data.  Run is called concurrently from
+ * multiple threads, so it may only write to per-item or per-thread data.
+ */
+class ParallelForBody
+{
+ public:
+  virtual ~ParallelForBody() {}
+  virtual void Run(int begin,int end,int thread)=0;
+};
+
+/** @ingroup Utils
+ * @brief A fixed set of worker threads that execute parallel loops.
+ *
+ * The thread calling ParallelFor participates as thread 0, so a pool
+ * with NumThreads()==1 spawns no threads and runs loops serially.  The
+ * loop is split into chunks that are handed out to threads as they
+ * become free.  Only one loop runs at a time; calls from different
+ * threads are serialized, and a loop body must not call ParallelFor on
+ * the same pool.
+ *
+ * On platforms without pthreads, loops are always run serially.
+ */
+class ThreadPool
+{
+ public:
+  ///Creates a pool with numThreads threads, or NumCores() if 0
+  ThreadPool(int numThreads=0);
+  ~ThreadPool();
+  inline int NumThreads() const { return numThreads; }
+  ///Runs body over [0,n) and returns once all items are done.  Chunks
+  ///have at most chunkSize items, or are picked automatically if 0.
+  void ParallelFor(int n,ParallelForBody& body,int chunkSize=0);
+  ///Locks and unlocks the pool's mutex, so that loop bodies can share
+  ///flags between threads.  Must not be held while calling ParallelFor.
+  void Lock();
+  void Unlock();
+  ///Returns the number of processors available
+  static int NumCores();
+
+ private:
+  ThreadPool(const ThreadPool&) {}
+  const ThreadPool& operator=(const ThreadPool&) { return *this; }
+
+  int numThreads;
+#ifndef WIN32
+  friend void* thread_pool_worker_func(void*);
+  void RunChunks(int thread);
+
+  std::vector<pthread_t> threads;
+  pthread_mutex_t loopMutex;    //held during ParallelFor
+  pthread_mutex_t mutex;        //protects the loop state below
+  pthread_cond_t startCond,doneCond;
+  int generation;               //incremented for each new loop
+  bool quit;
+  int numStarted;
+  ParallelForBody* body;
+  int n,chunkSize,next,active;
+#endif //WIN32
+};
+
+#endif